@@ -0,0 +1,64 @@
+#include "BenchmarkHarness.hpp"
+
+#include <cstdio>
+
+static volatile std::uintptr_t ourPointerSink = 0;
+static volatile std::uint64_t ourValueSink = 0;
+
+namespace BenchmarkHarness
+{
+	void KeepAlive(const void* aValue)
+	{
+		ourPointerSink = reinterpret_cast<std::uintptr_t>(aValue);
+	}
+
+	void KeepAlive(std::uint64_t aValue)
+	{
+		ourValueSink = aValue;
+	}
+
+	std::string ToJSON(const std::vector<Result>& someResults, const std::string& aLabel)
+	{
+		// Names and parameters are our own identifiers, so nothing here needs escaping
+		std::string json = "{\n  \"label\": \"" + aLabel + "\",\n  \"benchmarks\": [\n";
+		char buffer[256];
+		for (std::size_t i = 0; i < someResults.size(); ++i)
+		{
+			const Result& result = someResults[i];
+			json += "    {\"name\": \"" + result.myName + "\", \"parameters\": {";
+			for (std::size_t parameter = 0; parameter < result.myParameters.size(); ++parameter)
+			{
+				snprintf(buffer, sizeof(buffer), "%s\"%s\": %llu",
+					parameter > 0 ? ", " : "",
+					result.myParameters[parameter].first.c_str(),
+					static_cast<unsigned long long>(result.myParameters[parameter].second));
+				json += buffer;
+			}
+
+			snprintf(buffer, sizeof(buffer), "}, \"operations\": %llu, \"ns_per_op\": %.3f, \"bytes_per_op\": %.3f, \"allocs_per_op\": %.3f}%s\n",
+				static_cast<unsigned long long>(result.myOperationCount),
+				result.myNanosecondsPerOperation,
+				result.myBytesPerOperation,
+				result.myAllocationsPerOperation,
+				i + 1 < someResults.size() ? "," : "");
+			json += buffer;
+		}
+
+		json += "  ]\n}\n";
+		return json;
+	}
+
+	void PrintSummary(const Result& aResult)
+	{
+		std::string parameters;
+		for (const std::pair<std::string, std::uint64_t>& parameter : aResult.myParameters)
+			parameters += " " + parameter.first + "=" + std::to_string(parameter.second);
+
+		fprintf(stderr, "%-32s%-28s %14.1f ns/op %14.1f B/op %10.2f allocs/op\n",
+			aResult.myName.c_str(),
+			parameters.c_str(),
+			aResult.myNanosecondsPerOperation,
+			aResult.myBytesPerOperation,
+			aResult.myAllocationsPerOperation);
+	}
+} // namespace BenchmarkHarness
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "AllocationTracker.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace BenchmarkHarnessParameters
+{
+	static constexpr std::chrono::milliseconds ourMinimumBatchDuration = std::chrono::milliseconds(100);
+	static constexpr unsigned int ourBatchCount = 5;
+	static constexpr std::uint64_t ourMaximumBatchSize = 1ull << 30;
+}
+
+namespace BenchmarkHarness
+{
+	struct Result
+	{
+		std::string myName;
+		// Pairs of name and value, written out as a JSON object
+		std::vector<std::pair<std::string, std::uint64_t>> myParameters;
+		std::uint64_t myOperationCount;
+		double myNanosecondsPerOperation;
+		double myBytesPerOperation;
+		double myAllocationsPerOperation;
+	};
+
+	// Keeps the compiler from optimizing away work whose result is otherwise unused
+	void KeepAlive(const void* aValue);
+	void KeepAlive(std::uint64_t aValue);
+
+	// Runs anOperation in growing batches until a batch takes long enough to time reliably,
+	// then reports the fastest of a few such batches. Allocation counts come from the same batch.
+	template <typename Operation>
+	Result Measure(const std::string& aName, std::vector<std::pair<std::string, std::uint64_t>> someParameters, Operation&& anOperation)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		// The first call also warms up caches and lazily initialized state
+		std::uint64_t batchSize = 1;
+		while (true)
+		{
+			const Clock::time_point start = Clock::now();
+			for (std::uint64_t i = 0; i < batchSize; ++i)
+				anOperation();
+			const Clock::duration elapsed = Clock::now() - start;
+
+			if (elapsed >= BenchmarkHarnessParameters::ourMinimumBatchDuration || batchSize >= BenchmarkHarnessParameters::ourMaximumBatchSize)
+				break;
+
+			// Aim a little past the minimum so the next batch is likely to be the last
+			const double elapsedNanoseconds = static_cast<double>(std::max<Clock::rep>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), 1));
+			const double wantedNanoseconds = std::chrono::duration<double, std::nano>(BenchmarkHarnessParameters::ourMinimumBatchDuration).count() * 1.2;
+			const double growth = std::clamp(wantedNanoseconds / elapsedNanoseconds, 2.0, 100.0);
+			batchSize = std::min(static_cast<std::uint64_t>(static_cast<double>(batchSize) * growth), BenchmarkHarnessParameters::ourMaximumBatchSize);
+		}
+
+		Result result;
+		result.myName = aName;
+		result.myParameters = std::move(someParameters);
+		result.myOperationCount = batchSize;
+		result.myNanosecondsPerOperation = 0.0;
+		result.myBytesPerOperation = 0.0;
+		result.myAllocationsPerOperation = 0.0;
+
+		for (unsigned int batch = 0; batch < BenchmarkHarnessParameters::ourBatchCount; ++batch)
+		{
+			const std::uint64_t allocationCount = AllocationTracker::GetAllocationCount();
+			const std::uint64_t allocatedBytes = AllocationTracker::GetAllocatedBytes();
+
+			const Clock::time_point start = Clock::now();
+			for (std::uint64_t i = 0; i < batchSize; ++i)
+				anOperation();
+			const double elapsedNanoseconds = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+			const double nanosecondsPerOperation = elapsedNanoseconds / static_cast<double>(batchSize);
+			if (batch == 0 || nanosecondsPerOperation < result.myNanosecondsPerOperation)
+			{
+				result.myNanosecondsPerOperation = nanosecondsPerOperation;
+				result.myBytesPerOperation = static_cast<double>(AllocationTracker::GetAllocatedBytes() - allocatedBytes) / static_cast<double>(batchSize);
+				result.myAllocationsPerOperation = static_cast<double>(AllocationTracker::GetAllocationCount() - allocationCount) / static_cast<double>(batchSize);
+			}
+		}
+
+		return result;
+	}
+
+	std::string ToJSON(const std::vector<Result>& someResults, const std::string& aLabel);
+	void PrintSummary(const Result& aResult);
+} // namespace BenchmarkHarness
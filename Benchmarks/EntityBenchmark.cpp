@@ -0,0 +1,52 @@
+#include "EntityStore.hpp"
+#include "JobSystem.hpp"
+#include "MovementSystem.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace EntityBenchmarkParameters
+{
+	static constexpr std::size_t ourEntityCount = 100000;
+	static constexpr unsigned int ourTickCount = 1000;
+	static constexpr float ourDeltaTime = 1.0f / 60.0f;
+}
+
+int main(int /*argc*/, char** /*argv*/)
+{
+	EntityStore store;
+	store.Reserve(EntityBenchmarkParameters::ourEntityCount);
+
+	std::mt19937 generator(1234);
+	std::uniform_real_distribution<float> distribution(-100.0f, 100.0f);
+	std::vector<EntityHandle> handles;
+	handles.reserve(EntityBenchmarkParameters::ourEntityCount);
+	for (std::size_t i = 0; i < EntityBenchmarkParameters::ourEntityCount; ++i)
+		handles.push_back(store.CreateEntity(distribution(generator), distribution(generator), distribution(generator), distribution(generator)));
+
+	// Warm up caches and wake the workers before measuring
+	MovementSystem::Update(store, EntityBenchmarkParameters::ourDeltaTime);
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (unsigned int tick = 0; tick < EntityBenchmarkParameters::ourTickCount; ++tick)
+		MovementSystem::Update(store, EntityBenchmarkParameters::ourDeltaTime);
+	const double elapsedNanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+	const double nanosecondsPerTick = elapsedNanoseconds / EntityBenchmarkParameters::ourTickCount;
+	printf("Moved %zu entities for %u ticks on %zu workers\n", store.GetCount(), EntityBenchmarkParameters::ourTickCount, JobSystem::GetInstance().GetWorkerCount());
+	printf("%.3f ms per tick, %.3f ns per entity\n", nanosecondsPerTick / 1000000.0, nanosecondsPerTick / static_cast<double>(store.GetCount()));
+
+	// Churn half of the entities to exercise swap-remove and slot reuse
+	const std::chrono::steady_clock::time_point churnStart = std::chrono::steady_clock::now();
+	for (std::size_t i = 0; i < handles.size(); i += 2)
+	{
+		store.DestroyEntity(handles[i]);
+		handles[i] = store.CreateEntity(0.0f, 0.0f, 1.0f, 1.0f);
+	}
+	const double churnNanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - churnStart).count();
+	printf("%.3f ns per destroy and create\n", churnNanoseconds / static_cast<double>(handles.size() / 2));
+
+	return 0;
+}
@@ -0,0 +1,445 @@
+#include "BenchmarkHarness.hpp"
+#include "Camera.hpp"
+#include "EntityStore.hpp"
+#include "FileUtility.hpp"
+#include "InputManager.hpp"
+#include "ParticleSystem.hpp"
+#include "SnapshotRing.hpp"
+#include "TileGeometry.hpp"
+#include "TilePropertyTable.hpp"
+
+#include <glm/matrix.hpp>
+#include <tmxlite/Map.hpp>
+#include <tmxlite/TileLayer.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace ViridianBenchParameters
+{
+	static constexpr unsigned int ourMapSizes[] = { 16, 64, 256, 1024, 4096, 8192 };
+	static constexpr unsigned int ourTilesetCounts[] = { 1, 4, 16 };
+	static constexpr unsigned int ourTilesPerTileset = 64;
+	// The text of an 8192 square map alone runs into hundreds of megabytes before tmxlite copies it
+	static constexpr unsigned int ourMaximumTMXSize = 4096;
+	static constexpr std::size_t ourFileSizes[] = { 4 * 1024, 256 * 1024, 16 * 1024 * 1024 };
+	static constexpr std::uint32_t ourSeed = 1234;
+	static constexpr std::size_t ourSnapshotEntityCounts[] = { 1000, 10000, 65536 };
+	static constexpr unsigned int ourSnapshotMapSize = 256;
+	static constexpr unsigned int ourSnapshotEditsPerTick = 16;
+	static constexpr std::size_t ourSnapshotCapacity = 256 * 1024 * 1024;
+	static constexpr std::size_t ourSnapshotRecordCount = 60 * 60;
+	static constexpr unsigned int ourSnapshotKeyframeInterval = 60;
+	static constexpr double ourSnapshotTicksPerSecond = 60.0;
+	static constexpr std::size_t ourParticleCounts[] = { 100000, 1000000 };
+	static constexpr float ourParticleLifetimeMinimum = 1.0f;
+	static constexpr float ourParticleLifetimeMaximum = 3.0f;
+	static constexpr float ourParticleDeltaTime = 1.0f / 60.0f;
+}
+
+struct Options
+{
+	std::string myOutputFilePath;
+	std::string myLabel;
+	std::string myFilter;
+	unsigned int myMaximumSize = 8192;
+};
+
+// Roughly one in ten tiles is empty and one in twenty flipped, the rest spread evenly over the tilesets
+static std::vector<tmx::TileLayer::Tile> CreateTiles(unsigned int aSize, unsigned int aTilesetCount)
+{
+	std::mt19937 generator(ViridianBenchParameters::ourSeed);
+	std::uniform_int_distribution<unsigned int> percentage(0, 99);
+	std::uniform_int_distribution<std::uint32_t> tile(0, aTilesetCount * ViridianBenchParameters::ourTilesPerTileset - 1);
+	std::uniform_int_distribution<unsigned int> flip(1, 7);
+
+	std::vector<tmx::TileLayer::Tile> tiles(static_cast<std::size_t>(aSize) * aSize);
+	for (tmx::TileLayer::Tile& t : tiles)
+	{
+		t.ID = percentage(generator) < 10 ? 0 : tile(generator) + 1;
+		t.flipFlags = static_cast<std::uint8_t>(t.ID != 0 && percentage(generator) < 5 ? flip(generator) << 1 : 0);
+	}
+
+	return tiles;
+}
+
+static std::string EncodeBase64(const std::vector<std::uint8_t>& someBytes)
+{
+	static constexpr char ourAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	std::string encoded;
+	encoded.reserve((someBytes.size() + 2) / 3 * 4);
+	for (std::size_t i = 0; i < someBytes.size(); i += 3)
+	{
+		const std::uint32_t remaining = static_cast<std::uint32_t>(someBytes.size() - i);
+		const std::uint32_t triple = (someBytes[i] << 16) | (remaining > 1 ? someBytes[i + 1] << 8 : 0) | (remaining > 2 ? someBytes[i + 2] : 0);
+		encoded += ourAlphabet[(triple >> 18) & 63];
+		encoded += ourAlphabet[(triple >> 12) & 63];
+		encoded += remaining > 1 ? ourAlphabet[(triple >> 6) & 63] : '=';
+		encoded += remaining > 2 ? ourAlphabet[triple & 63] : '=';
+	}
+
+	return encoded;
+}
+
+static std::string CreateTMX(const std::vector<tmx::TileLayer::Tile>& someTiles, unsigned int aSize, unsigned int aTilesetCount, bool anIsBase64)
+{
+	const std::string size = std::to_string(aSize);
+	std::string tmx = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<map version=\"1.0\" orientation=\"orthogonal\" renderorder=\"right-down\" width=\"" + size + "\" height=\"" + size + "\" tilewidth=\"64\" tileheight=\"64\" nextobjectid=\"1\">\n";
+	for (unsigned int tileset = 0; tileset < aTilesetCount; ++tileset)
+	{
+		tmx += " <tileset firstgid=\"" + std::to_string(tileset * ViridianBenchParameters::ourTilesPerTileset + 1) + "\" name=\"tileset" + std::to_string(tileset)
+			+ "\" tilewidth=\"64\" tileheight=\"64\" tilecount=\"64\" columns=\"8\">\n  <image source=\"Tilesets/tileset.png\" width=\"512\" height=\"512\"/>\n </tileset>\n";
+	}
+
+	tmx += " <layer name=\"Tile Layer 1\" width=\"" + size + "\" height=\"" + size + "\">\n";
+	if (anIsBase64)
+	{
+		std::vector<std::uint8_t> bytes;
+		bytes.reserve(someTiles.size() * 4);
+		for (const tmx::TileLayer::Tile& tile : someTiles)
+		{
+			const std::uint32_t value = tile.ID | (static_cast<std::uint32_t>(tile.flipFlags) << 28);
+			for (int shift = 0; shift < 32; shift += 8)
+				bytes.push_back(static_cast<std::uint8_t>(value >> shift));
+		}
+
+		tmx += "  <data encoding=\"base64\">\n   " + EncodeBase64(bytes) + "\n  </data>\n";
+	}
+	else
+	{
+		tmx += "  <data encoding=\"csv\">\n";
+		for (std::size_t i = 0; i < someTiles.size(); ++i)
+		{
+			tmx += std::to_string(someTiles[i].ID | (static_cast<std::uint32_t>(someTiles[i].flipFlags) << 28));
+			if (i + 1 < someTiles.size())
+				tmx += (i + 1) % aSize == 0 ? ",\n" : ",";
+		}
+		tmx += "\n  </data>\n";
+	}
+
+	tmx += " </layer>\n</map>\n";
+	return tmx;
+}
+
+static bool GetIsSelected(const Options& someOptions, const char* aName)
+{
+	return someOptions.myFilter.empty() || std::strstr(aName, someOptions.myFilter.c_str()) != nullptr;
+}
+
+static void Record(std::vector<BenchmarkHarness::Result>& someResults, BenchmarkHarness::Result aResult)
+{
+	BenchmarkHarness::PrintSummary(aResult);
+	someResults.push_back(std::move(aResult));
+}
+
+static void BenchmarkTileGeometry(const Options& someOptions, std::vector<BenchmarkHarness::Result>& someResults)
+{
+	const bool isLookupSelected = GetIsSelected(someOptions, "TileGeometry::BuildLookup");
+	const bool isRunsSelected = GetIsSelected(someOptions, "TileGeometry::BuildRuns");
+	if (!isLookupSelected && !isRunsSelected)
+		return;
+
+	std::vector<bool> opaqueTiles(ViridianBenchParameters::ourTilesPerTileset);
+	for (std::size_t i = 0; i < opaqueTiles.size(); ++i)
+		opaqueTiles[i] = i % 2 == 0;
+
+	const TileGeometry::Placement placement = { 0.0f, 0.0f, 64.0f, 64.0f, -1.0f };
+	for (const unsigned int size : ViridianBenchParameters::ourMapSizes)
+	{
+		if (size > someOptions.myMaximumSize)
+			continue;
+
+		for (const unsigned int tilesetCount : ViridianBenchParameters::ourTilesetCounts)
+		{
+			const std::vector<tmx::TileLayer::Tile> tiles = CreateTiles(size, tilesetCount);
+			std::vector<std::uint16_t> lookup(tiles.size() * 2);
+
+			// The same work MapLayer::CreateSubsets does for a layer: one lookup per tileset
+			if (isLookupSelected)
+			{
+				Record(someResults, BenchmarkHarness::Measure("TileGeometry::BuildLookup", { { "size", size }, { "tilesets", tilesetCount } }, [&]()
+					{
+						for (unsigned int tileset = 0; tileset < tilesetCount; ++tileset)
+							TileGeometry::BuildLookup(tiles, size, 0, size, tileset * ViridianBenchParameters::ourTilesPerTileset + 1, ViridianBenchParameters::ourTilesPerTileset, lookup.data());
+
+						BenchmarkHarness::KeepAlive(lookup.data());
+					}));
+			}
+
+			if (isRunsSelected)
+			{
+				TileGeometry::BuildLookup(tiles, size, 0, size, 1, ViridianBenchParameters::ourTilesPerTileset, lookup.data());
+
+				std::vector<float> opaqueVertices;
+				std::vector<float> transparentVertices;
+				Record(someResults, BenchmarkHarness::Measure("TileGeometry::BuildRuns", { { "size", size }, { "tilesets", tilesetCount } }, [&]()
+					{
+						opaqueVertices.clear();
+						transparentVertices.clear();
+						TileGeometry::BuildRuns(lookup.data(), size, size, 0, size, placement, opaqueTiles, opaqueVertices, transparentVertices);
+						BenchmarkHarness::KeepAlive(opaqueVertices.data());
+						BenchmarkHarness::KeepAlive(transparentVertices.data());
+					}));
+			}
+		}
+	}
+}
+
+static void BenchmarkInput(const Options& someOptions, std::vector<BenchmarkHarness::Result>& someResults)
+{
+	if (!GetIsSelected(someOptions, "InputManager::GetIsKeyDown"))
+		return;
+
+	const InputManager& inputManager = InputManager::GetInstance();
+	std::uint64_t keyIndex = 0;
+	std::uint64_t downCount = 0;
+	Record(someResults, BenchmarkHarness::Measure("InputManager::GetIsKeyDown", { { "keys", static_cast<std::uint64_t>(Key::Count) } }, [&]()
+		{
+			downCount += inputManager.GetIsKeyDown(static_cast<Key>(keyIndex)) ? 1 : 0;
+			keyIndex = keyIndex + 1 < static_cast<std::uint64_t>(Key::Count) ? keyIndex + 1 : 0;
+		}));
+	BenchmarkHarness::KeepAlive(downCount);
+}
+
+static void BenchmarkFileReading(const Options& someOptions, std::vector<BenchmarkHarness::Result>& someResults)
+{
+	if (!GetIsSelected(someOptions, "FileUtility::ReadFile"))
+		return;
+
+	const std::string filePath = (std::filesystem::temp_directory_path() / "ViridianBench.txt").string();
+	for (const std::size_t fileSize : ViridianBenchParameters::ourFileSizes)
+	{
+		{
+			std::ofstream file(filePath, std::ofstream::binary | std::ofstream::trunc);
+			const std::string line(63, 'x');
+			for (std::size_t written = 0; written < fileSize; written += line.size() + 1)
+				file << line << '\n';
+		}
+
+		Record(someResults, BenchmarkHarness::Measure("FileUtility::ReadFile", { { "bytes", fileSize } }, [&]()
+			{
+				const std::string contents = FileUtility::ReadFile(filePath.c_str());
+				BenchmarkHarness::KeepAlive(contents.size());
+			}));
+	}
+
+	std::filesystem::remove(filePath);
+}
+
+static void BenchmarkTMX(const Options& someOptions, std::vector<BenchmarkHarness::Result>& someResults)
+{
+	static constexpr const char* ourNames[] = { "tmx::Map::loadFromString/csv", "tmx::Map::loadFromString/base64" };
+
+	for (const unsigned int size : ViridianBenchParameters::ourMapSizes)
+	{
+		if (size > someOptions.myMaximumSize || size > ViridianBenchParameters::ourMaximumTMXSize)
+			continue;
+
+		for (const unsigned int tilesetCount : ViridianBenchParameters::ourTilesetCounts)
+		{
+			const std::vector<tmx::TileLayer::Tile> tiles = CreateTiles(size, tilesetCount);
+			for (int encoding = 0; encoding < 2; ++encoding)
+			{
+				if (!GetIsSelected(someOptions, ourNames[encoding]))
+					continue;
+
+				const std::string tmx = CreateTMX(tiles, size, tilesetCount, encoding == 1);
+				Record(someResults, BenchmarkHarness::Measure(ourNames[encoding], { { "size", size }, { "tilesets", tilesetCount } }, [&]()
+					{
+						tmx::Map map;
+						map.loadFromString(tmx, "Data/Tilemaps");
+						BenchmarkHarness::KeepAlive(map.getLayers().size());
+					}));
+			}
+		}
+	}
+}
+
+static void BenchmarkCamera(const Options& someOptions, std::vector<BenchmarkHarness::Result>& someResults)
+{
+	if (!GetIsSelected(someOptions, "Camera::ModelViewProjection"))
+		return;
+
+	Camera camera(glm::vec2(800.0f, 600.0f));
+	const glm::mat4 model(1.0f);
+	float offset = 0.0f;
+	float sum = 0.0f;
+
+	// Mirrors what Game::Update does every frame
+	Record(someResults, BenchmarkHarness::Measure("Camera::ModelViewProjection", {}, [&]()
+		{
+			offset += 1.0f;
+			camera.SetPosition(glm::vec3(offset, offset * 0.5f, 0.0f));
+			const glm::mat4 modelViewProjection = camera.GetProjectionMatrix() * camera.GetViewMatrix() * model;
+			sum += modelViewProjection[3][0];
+		}));
+	BenchmarkHarness::KeepAlive(static_cast<std::uint64_t>(sum));
+}
+
+static void BenchmarkSnapshots(const Options& someOptions, std::vector<BenchmarkHarness::Result>& someResults)
+{
+	const bool isRecordSelected = GetIsSelected(someOptions, "SnapshotRing::Record");
+	const bool isRestoreSelected = GetIsSelected(someOptions, "SnapshotRing::Restore");
+	if (!isRecordSelected && !isRestoreSelected)
+		return;
+
+	const unsigned int size = ViridianBenchParameters::ourSnapshotMapSize;
+	tmx::Map map;
+	map.loadFromString(CreateTMX(CreateTiles(size, 1), size, 1, true), "Data/Tilemaps");
+	const tmx::TileLayer& layer = map.getLayers()[0]->getLayerAs<tmx::TileLayer>();
+
+	for (const std::size_t entityCount : ViridianBenchParameters::ourSnapshotEntityCounts)
+	{
+		std::mt19937 generator(ViridianBenchParameters::ourSeed);
+		std::uniform_real_distribution<float> distribution(-100.0f, 100.0f);
+		std::uniform_int_distribution<int> coordinate(0, static_cast<int>(size) - 1);
+		std::uniform_int_distribution<std::uint32_t> gid(0, ViridianBenchParameters::ourTilesPerTileset);
+
+		EntityStore entityStore;
+		entityStore.Reserve(entityCount);
+		for (std::size_t i = 0; i < entityCount; ++i)
+			entityStore.CreateEntity(distribution(generator), distribution(generator), distribution(generator), distribution(generator));
+
+		TilePropertyTable tileTable(map.getTilesets(), static_cast<int>(size), static_cast<int>(size));
+		tileTable.AddLayer(layer);
+
+		glm::vec3 cameraPosition(0.0f);
+		std::uint32_t tick = 0;
+
+		// Every entity moves and a few tiles change, like a busy tick of the game
+		const auto simulateTick = [&](SnapshotRing& aSnapshotRing)
+			{
+				float* positionsX = entityStore.GetPositionsX();
+				float* positionsY = entityStore.GetPositionsY();
+				const float* velocitiesX = entityStore.GetVelocitiesX();
+				const float* velocitiesY = entityStore.GetVelocitiesY();
+				for (std::size_t i = 0; i < entityStore.GetCount(); ++i)
+				{
+					positionsX[i] += velocitiesX[i] * (1.0f / 60.0f);
+					positionsY[i] += velocitiesY[i] * (1.0f / 60.0f);
+				}
+
+				for (unsigned int i = 0; i < ViridianBenchParameters::ourSnapshotEditsPerTick; ++i)
+					tileTable.SetGID(0, coordinate(generator), coordinate(generator), gid(generator));
+
+				cameraPosition.x += 1.0f;
+				aSnapshotRing.Record(++tick, entityStore, tileTable, cameraPosition);
+			};
+
+		const std::vector<std::pair<std::string, std::uint64_t>> parameters = { { "entities", entityCount }, { "edits", ViridianBenchParameters::ourSnapshotEditsPerTick } };
+		if (isRecordSelected)
+		{
+			SnapshotRing snapshotRing(ViridianBenchParameters::ourSnapshotCapacity, ViridianBenchParameters::ourSnapshotRecordCount, ViridianBenchParameters::ourSnapshotKeyframeInterval);
+			Record(someResults, BenchmarkHarness::Measure("SnapshotRing::Record", parameters, [&]() { simulateTick(snapshotRing); }));
+			fprintf(stderr, "%-60s %14.1f KB per second of history\n", "",
+				static_cast<double>(snapshotRing.GetUsedBytes()) / static_cast<double>(snapshotRing.GetRecordCount()) * ViridianBenchParameters::ourSnapshotTicksPerSecond / 1024.0);
+		}
+
+		if (isRestoreSelected)
+		{
+			// The first tick is a keyframe, so the tick right before the second one replays the most deltas.
+			// Restoring it drops the newer ticks, which leaves it in place to be restored again.
+			SnapshotRing snapshotRing(ViridianBenchParameters::ourSnapshotCapacity, ViridianBenchParameters::ourSnapshotRecordCount, ViridianBenchParameters::ourSnapshotKeyframeInterval);
+			const std::uint32_t restoredTick = tick + ViridianBenchParameters::ourSnapshotKeyframeInterval;
+			for (unsigned int i = 0; i < ViridianBenchParameters::ourSnapshotKeyframeInterval * 2; ++i)
+				simulateTick(snapshotRing);
+
+			Record(someResults, BenchmarkHarness::Measure("SnapshotRing::Restore", parameters, [&]()
+				{
+					BenchmarkHarness::KeepAlive(snapshotRing.Restore(restoredTick, entityStore, tileTable, cameraPosition) ? 1 : 0);
+				}));
+		}
+	}
+}
+
+static void BenchmarkParticles(const Options& someOptions, std::vector<BenchmarkHarness::Result>& someResults)
+{
+	const bool isUpdateSelected = GetIsSelected(someOptions, "ParticleSystem::Update");
+	const bool isWriteSelected = GetIsSelected(someOptions, "ParticleSystem::WriteInstances");
+	if (!isUpdateSelected && !isWriteSelected)
+		return;
+
+	for (const std::size_t particleCount : ViridianBenchParameters::ourParticleCounts)
+	{
+		// Emitting as many particles per second as die keeps the pool near the count, with churn every tick
+		const float averageLifetime = (ViridianBenchParameters::ourParticleLifetimeMinimum + ViridianBenchParameters::ourParticleLifetimeMaximum) * 0.5f;
+		ParticleSystem particleSystem(1, particleCount + particleCount / 4);
+		particleSystem.SetGravity(0.0f, 60.0f);
+
+		ParticleEmitter emitter;
+		emitter.myRate = static_cast<float>(particleCount) / averageLifetime;
+		emitter.mySpeedMinimum = 10.0f;
+		emitter.mySpeedMaximum = 100.0f;
+		emitter.myLifetimeMinimum = ViridianBenchParameters::ourParticleLifetimeMinimum;
+		emitter.myLifetimeMaximum = ViridianBenchParameters::ourParticleLifetimeMaximum;
+		particleSystem.AddEmitter(emitter);
+
+		const unsigned int warmupTicks = static_cast<unsigned int>(ViridianBenchParameters::ourParticleLifetimeMaximum / ViridianBenchParameters::ourParticleDeltaTime);
+		for (unsigned int i = 0; i < warmupTicks; ++i)
+			particleSystem.Update(ViridianBenchParameters::ourParticleDeltaTime);
+
+		if (isUpdateSelected)
+		{
+			Record(someResults, BenchmarkHarness::Measure("ParticleSystem::Update", { { "particles", particleCount } }, [&]()
+				{
+					particleSystem.Update(ViridianBenchParameters::ourParticleDeltaTime);
+					BenchmarkHarness::KeepAlive(particleSystem.GetCount(0));
+				}));
+		}
+
+		// Stands in for the mapped buffer the renderer writes to
+		if (isWriteSelected)
+		{
+			std::vector<float> instances(particleSystem.GetCapacity() * ParticleSystem::ourFloatsPerInstance);
+			Record(someResults, BenchmarkHarness::Measure("ParticleSystem::WriteInstances", { { "particles", particleCount } }, [&]()
+				{
+					particleSystem.WriteInstances(0, instances.data());
+					BenchmarkHarness::KeepAlive(instances.data());
+				}));
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--output") == 0)
+			options.myOutputFilePath = argv[i + 1];
+		else if (std::strcmp(argv[i], "--label") == 0)
+			options.myLabel = argv[i + 1];
+		else if (std::strcmp(argv[i], "--filter") == 0)
+			options.myFilter = argv[i + 1];
+		else if (std::strcmp(argv[i], "--max-size") == 0)
+			options.myMaximumSize = static_cast<unsigned int>(std::strtoul(argv[i + 1], nullptr, 10));
+		else
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+	}
+
+	std::vector<BenchmarkHarness::Result> results;
+	BenchmarkTileGeometry(options, results);
+	BenchmarkInput(options, results);
+	BenchmarkFileReading(options, results);
+	BenchmarkTMX(options, results);
+	BenchmarkCamera(options, results);
+	BenchmarkSnapshots(options, results);
+	BenchmarkParticles(options, results);
+
+	const std::string json = BenchmarkHarness::ToJSON(results, options.myLabel);
+	if (options.myOutputFilePath.empty())
+	{
+		fputs(json.c_str(), stdout);
+		return 0;
+	}
+
+	std::ofstream output(options.myOutputFilePath, std::ofstream::trunc);
+	output << json;
+	return output.good() ? 0 : 1;
+}
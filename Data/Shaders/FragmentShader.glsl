@@ -4,14 +4,26 @@
 #define FLIP_VERTICAL 4u
 #define FLIP_DIAGONAL 2u
 
+// Depth is resolved before shading so opaque tiles drawn earlier reject hidden fragments
+layout(early_fragment_tests) in;
+
 in vec2 vTextureCoordinates;
 
 uniform usampler2D uLookupMap;
 uniform sampler2D uTileMap;
-uniform vec2 uTileSize = vec2(64.0);
+// Light level in red and visibility in green, one texel per tile
+uniform sampler2D uLightMap;
+// Where tiles are in the tileset texture, in texture coordinates. Baked tilesets pad every tile, so the
+// stride between tiles is larger than a tile and the first one starts past the padding.
 uniform vec2 uTilesetCount = vec2(6.0, 7.0);
-uniform vec2 uTilesetScale = vec2(1.0);
+uniform vec2 uTileStride = vec2(1.0) / vec2(6.0, 7.0);
+uniform vec2 uTileOrigin = vec2(0.0);
+uniform vec2 uTileExtent = vec2(1.0) / vec2(6.0, 7.0);
 uniform float uOpacity = 1.0;
+// Unlit tiles are drawn exactly as their texture has them
+uniform bool uIsLit = false;
+uniform float uAmbientLight = 0.25;
+uniform float uHiddenBrightness = 0.4;
 
 out vec4 colour;
 
@@ -20,22 +32,28 @@ const float epsilon = 0.000005;
 
 void main()
 {
+    // Mip selection follows the coordinates across the whole layer, the wrap at every tile edge would otherwise
+    // pick the smallest level there. Derivatives are taken before any fragment of the quad can be discarded.
+    vec2 lookupSize = vec2(textureSize(uLookupMap, 0));
+    vec2 gradientScale = lookupSize * uTileExtent;
+    vec2 gradientX = dFdx(vTextureCoordinates) * gradientScale;
+    vec2 gradientY = dFdy(vTextureCoordinates) * gradientScale;
+
     uvec2 values = texture(uLookupMap, vTextureCoordinates).rg;
     if(values.r > 0u)
     {
         float index = float(values.r) - 1.0;
-        vec2 position = vec2(mod(index + epsilon, uTilesetCount.x), floor((index / uTilesetCount.x) + epsilon)) / uTilesetCount;
-        vec2 offsetCoord = (vTextureCoordinates * (textureSize(uLookupMap, 0) * uTilesetScale)) / uTileSize;
+        vec2 cell = vec2(mod(index + epsilon, uTilesetCount.x), floor((index / uTilesetCount.x) + epsilon));
+        vec2 position = uTileOrigin + cell * uTileStride;
 
-        vec2 texelSize = vec2(1.0) / textureSize(uLookupMap, 0);
+        vec2 texelSize = vec2(1.0) / lookupSize;
         vec2 offset = mod(vTextureCoordinates, texelSize);
         vec2 ratio = offset / texelSize;
-        offset = ratio * (1.0 / uTileSize);
-        offset *= uTileSize / uTilesetCount;
+        offset = ratio * uTileExtent;
 
         if (values.g != 0u)
         {
-            vec2 tileSize = vec2(1.0) / uTilesetCount;
+            vec2 tileSize = uTileExtent;
             if ((values.g & FLIP_DIAGONAL) != 0u)
             {
                 float temp = offset.x;
@@ -58,11 +76,17 @@ void main()
                 offset.x = tileSize.x - offset.x;
             }
         }
-        colour = texture(uTileMap, position + offset);
+        colour = textureGrad(uTileMap, position + offset, gradientX, gradientY);
         colour.a = min(colour.a, uOpacity);
+
+        if (uIsLit)
+        {
+            vec2 light = texture(uLightMap, vTextureCoordinates).rg;
+            colour.rgb *= max(light.r, uAmbientLight) * mix(uHiddenBrightness, 1.0, light.g);
+        }
     }
     else
     {
-        colour = vec4(0.0);
+        discard;
     }
 }
\ No newline at end of file
@@ -0,0 +1,22 @@
+#version 460
+
+in vec2 vCorner;
+in float vLife;
+
+uniform vec4 uStartColor;
+uniform vec4 uEndColor;
+
+out vec4 colour;
+
+void main()
+{
+	// A soft round dot that fades out towards its edge
+	float falloff = 1.0 - dot(vCorner, vCorner);
+	if (falloff <= 0.0)
+	{
+		discard;
+	}
+
+	colour = mix(uStartColor, uEndColor, vLife);
+	colour.a *= falloff;
+}
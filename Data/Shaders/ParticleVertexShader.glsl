@@ -0,0 +1,18 @@
+#version 460
+
+// Position, size and life in [0, 1) of one particle, advanced once per instance
+in vec4 aInstance;
+
+uniform mat4 uModelViewProjection;
+
+out vec2 vCorner;
+out float vLife;
+
+void main()
+{
+	// The four vertices of the strip are the corners of a quad around the particle
+	vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) * 2.0 - 1.0;
+	gl_Position = uModelViewProjection * vec4(aInstance.xy + corner * aInstance.z * 0.5, 0.0, 1.0);
+	vCorner = corner;
+	vLife = aInstance.w;
+}
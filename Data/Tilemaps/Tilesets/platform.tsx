@@ -11,8 +11,24 @@
   <terrain name="brown" tile="-1"/>
   <terrain name="green" tile="-1"/>
  </terraintypes>
- <tile id="0" terrain=",0,,0"/>
- <tile id="22" terrain="1,1,1,"/>
- <tile id="25" terrain=",1,,1"/>
- <tile id="26" terrain="0,,0,"/>
+ <tile id="0" terrain=",0,,0">
+  <properties>
+   <property name="opaque" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="22" terrain="1,1,1,">
+  <properties>
+   <property name="opaque" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="25" terrain=",1,,1">
+  <properties>
+   <property name="opaque" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="26" terrain="0,,0,">
+  <properties>
+   <property name="opaque" type="bool" value="true"/>
+  </properties>
+ </tile>
 </tileset>
@@ -0,0 +1,52 @@
+"""Compares two ViridianBench JSON reports, e.g. from before and after a change.
+
+Usage: python CompareBenchmarks.py baseline.json candidate.json [threshold percent]
+"""
+
+import json
+import sys
+
+
+def load(path):
+    with open(path) as file:
+        report = json.load(file)
+    results = {}
+    for benchmark in report["benchmarks"]:
+        parameters = " ".join("%s=%s" % (name, value) for name, value in sorted(benchmark["parameters"].items()))
+        results[(benchmark["name"], parameters)] = benchmark
+    return report.get("label", path), results
+
+
+def main():
+    if len(sys.argv) < 3:
+        print(__doc__)
+        return 2
+
+    threshold = float(sys.argv[3]) if len(sys.argv) > 3 else 5.0
+    baseline_label, baseline = load(sys.argv[1])
+    candidate_label, candidate = load(sys.argv[2])
+    print("%s -> %s" % (baseline_label, candidate_label))
+
+    regressions = 0
+    for key in sorted(set(baseline) & set(candidate)):
+        before = baseline[key]
+        after = candidate[key]
+        change = (after["ns_per_op"] - before["ns_per_op"]) / max(before["ns_per_op"], 1e-9) * 100.0
+        marker = ""
+        if change > threshold:
+            marker = "  slower"
+            regressions += 1
+        elif change < -threshold:
+            marker = "  faster"
+        print("%-32s %-24s %14.1f -> %14.1f ns/op %+7.1f%%  allocs/op %.2f -> %.2f%s" % (
+            key[0], key[1], before["ns_per_op"], after["ns_per_op"], change,
+            before["allocs_per_op"], after["allocs_per_op"], marker))
+
+    for key in sorted(set(baseline) ^ set(candidate)):
+        print("%-32s %-24s only in %s" % (key[0], key[1], baseline_label if key in baseline else candidate_label))
+
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
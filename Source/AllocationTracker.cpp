@@ -0,0 +1,94 @@
+#include "AllocationTracker.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
+#if !defined(NDEBUG) || defined(VIRIDIAN_TRACK_ALLOCATIONS)
+#define ALLOCATION_TRACKING_ENABLED
+#endif
+
+#ifdef ALLOCATION_TRACKING_ENABLED
+static std::atomic<std::uint64_t> ourAllocationCount(0);
+static std::atomic<std::uint64_t> ourAllocatedBytes(0);
+
+static void TrackAllocation(std::size_t aSize)
+{
+	ourAllocationCount.fetch_add(1, std::memory_order_relaxed);
+	ourAllocatedBytes.fetch_add(aSize, std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t aSize)
+{
+	TrackAllocation(aSize);
+	if (void* memory = std::malloc(aSize ? aSize : 1))
+		return memory;
+
+	throw std::bad_alloc();
+}
+
+void* operator new(std::size_t aSize, std::align_val_t anAlignment)
+{
+	TrackAllocation(aSize);
+	const std::size_t alignment = static_cast<std::size_t>(anAlignment);
+#if defined(_MSC_VER)
+	void* memory = _aligned_malloc(aSize ? aSize : 1, alignment);
+#else
+	// aligned_alloc wants the size to be a multiple of the alignment
+	void* memory = std::aligned_alloc(alignment, ((aSize ? aSize : 1) + alignment - 1) / alignment * alignment);
+#endif
+	if (memory)
+		return memory;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* aMemory) noexcept
+{
+	std::free(aMemory);
+}
+
+void operator delete(void* aMemory, std::size_t) noexcept
+{
+	std::free(aMemory);
+}
+
+void operator delete(void* aMemory, std::align_val_t) noexcept
+{
+#if defined(_MSC_VER)
+	_aligned_free(aMemory);
+#else
+	std::free(aMemory);
+#endif
+}
+
+void operator delete(void* aMemory, std::size_t, std::align_val_t anAlignment) noexcept
+{
+	operator delete(aMemory, anAlignment);
+}
+#endif
+
+namespace AllocationTracker
+{
+	std::uint64_t GetAllocationCount()
+	{
+#ifdef ALLOCATION_TRACKING_ENABLED
+		return ourAllocationCount.load(std::memory_order_relaxed);
+#else
+		return 0;
+#endif
+	}
+
+	std::uint64_t GetAllocatedBytes()
+	{
+#ifdef ALLOCATION_TRACKING_ENABLED
+		return ourAllocatedBytes.load(std::memory_order_relaxed);
+#else
+		return 0;
+#endif
+	}
+} // namespace AllocationTracker
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+// Counts every call to the global operator new in debug builds, or in any build defining VIRIDIAN_TRACK_ALLOCATIONS.
+// Other release builds leave the global allocator untouched and always report zero.
+namespace AllocationTracker
+{
+	std::uint64_t GetAllocationCount();
+	std::uint64_t GetAllocatedBytes();
+} // namespace AllocationTracker
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+// On-disk layout of an asset pack, little-endian throughout:
+//   AssetPackHeader
+//   AssetPackEntry[myEntryCount], sorted by path so lookups can binary search the mapped file
+//   path table, the paths of all entries without terminators
+//   entry data, every entry starting on a multiple of AssetPack::ourAlignment
+// An entry whose stored size differs from its size is one LZ4 block.
+namespace AssetPack
+{
+	static constexpr char ourMagic[4] = { 'V', 'P', 'A', 'K' };
+	static constexpr std::uint32_t ourVersion = 1;
+	static constexpr std::uint64_t ourAlignment = 64;
+	static constexpr const char* ourDefaultFilepath = "Data.vpak";
+}
+
+struct AssetPackHeader
+{
+	char myMagic[4];
+	std::uint32_t myVersion;
+	std::uint32_t myEntryCount;
+	std::uint32_t myPathTableSize;
+};
+
+struct AssetPackEntry
+{
+	std::uint64_t myDataOffset;
+	std::uint64_t myStoredSize;
+	std::uint64_t mySize;
+	// Into the path table
+	std::uint32_t myPathOffset;
+	std::uint32_t myPathLength;
+};
+
+static_assert(sizeof(AssetPackHeader) == 16, "The pack header layout is part of the file format");
+static_assert(sizeof(AssetPackEntry) == 32, "The pack entry layout is part of the file format");
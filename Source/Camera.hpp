@@ -8,6 +8,7 @@ public:
 	Camera(const glm::vec2& aWindowSize);
 
 	void SetPosition(const glm::vec3& aPosition) { myPosition = aPosition; }
+	void SetViewportSize(const glm::vec2& aViewportSize);
 
 	[[nodiscard]] glm::mat4 GetProjectionMatrix() const { return myProjectionMatrix; }
 	[[nodiscard]] glm::mat4 GetViewMatrix() const;
@@ -0,0 +1,169 @@
+#include "EntityStore.hpp"
+
+#include <cstring>
+
+EntityStore::EntityStore()
+{}
+
+void EntityStore::Reserve(std::size_t aCapacity)
+{
+	mySlots.reserve(aCapacity);
+	myFreeSlots.reserve(aCapacity);
+	myDenseToSlot.reserve(aCapacity);
+	myPositionsX.reserve(aCapacity);
+	myPositionsY.reserve(aCapacity);
+	myVelocitiesX.reserve(aCapacity);
+	myVelocitiesY.reserve(aCapacity);
+}
+
+EntityHandle EntityStore::CreateEntity(float aPositionX, float aPositionY, float aVelocityX, float aVelocityY)
+{
+	std::uint32_t slotIndex = 0;
+	if (!myFreeSlots.empty())
+	{
+		slotIndex = myFreeSlots.back();
+		myFreeSlots.pop_back();
+	}
+	else
+	{
+		slotIndex = static_cast<std::uint32_t>(mySlots.size());
+		mySlots.push_back({ 0, 0 });
+	}
+
+	Slot& slot = mySlots[slotIndex];
+	slot.myDenseIndex = static_cast<std::uint32_t>(myDenseToSlot.size());
+
+	myDenseToSlot.push_back(slotIndex);
+	myPositionsX.push_back(aPositionX);
+	myPositionsY.push_back(aPositionY);
+	myVelocitiesX.push_back(aVelocityX);
+	myVelocitiesY.push_back(aVelocityY);
+
+	return { slotIndex, slot.myGeneration };
+}
+
+bool EntityStore::DestroyEntity(EntityHandle anEntity)
+{
+	if (!GetIsAlive(anEntity))
+		return false;
+
+	Slot& slot = mySlots[anEntity.myIndex];
+	const std::uint32_t denseIndex = slot.myDenseIndex;
+	const std::uint32_t lastIndex = static_cast<std::uint32_t>(myDenseToSlot.size() - 1);
+
+	// Move the last entity into the hole so the columns stay packed
+	if (denseIndex != lastIndex)
+	{
+		myPositionsX[denseIndex] = myPositionsX[lastIndex];
+		myPositionsY[denseIndex] = myPositionsY[lastIndex];
+		myVelocitiesX[denseIndex] = myVelocitiesX[lastIndex];
+		myVelocitiesY[denseIndex] = myVelocitiesY[lastIndex];
+
+		const std::uint32_t movedSlot = myDenseToSlot[lastIndex];
+		myDenseToSlot[denseIndex] = movedSlot;
+		mySlots[movedSlot].myDenseIndex = denseIndex;
+	}
+
+	myPositionsX.pop_back();
+	myPositionsY.pop_back();
+	myVelocitiesX.pop_back();
+	myVelocitiesY.pop_back();
+	myDenseToSlot.pop_back();
+
+	++slot.myGeneration;
+	myFreeSlots.push_back(anEntity.myIndex);
+	return true;
+}
+
+void EntityStore::Clear()
+{
+	for (const std::uint32_t slotIndex : myDenseToSlot)
+	{
+		++mySlots[slotIndex].myGeneration;
+		myFreeSlots.push_back(slotIndex);
+	}
+
+	myDenseToSlot.clear();
+	myPositionsX.clear();
+	myPositionsY.clear();
+	myVelocitiesX.clear();
+	myVelocitiesY.clear();
+}
+
+// Layout: slot, free slot and entity counts, then the slots as generation and dense index pairs, the free
+// slots, the dense to slot table and finally one column per component field
+void EntityStore::WriteState(std::vector<std::uint32_t>& someWords) const
+{
+	const std::size_t count = myDenseToSlot.size();
+	someWords.resize(3 + mySlots.size() * 2 + myFreeSlots.size() + count * 5);
+
+	std::uint32_t* words = someWords.data();
+	*words++ = static_cast<std::uint32_t>(mySlots.size());
+	*words++ = static_cast<std::uint32_t>(myFreeSlots.size());
+	*words++ = static_cast<std::uint32_t>(count);
+	for (const Slot& slot : mySlots)
+	{
+		*words++ = slot.myGeneration;
+		*words++ = slot.myDenseIndex;
+	}
+
+	std::memcpy(words, myFreeSlots.data(), myFreeSlots.size() * sizeof(std::uint32_t));
+	words += myFreeSlots.size();
+	std::memcpy(words, myDenseToSlot.data(), count * sizeof(std::uint32_t));
+	words += count;
+	for (const std::vector<float>* column : { &myPositionsX, &myPositionsY, &myVelocitiesX, &myVelocitiesY })
+	{
+		std::memcpy(words, column->data(), count * sizeof(float));
+		words += count;
+	}
+}
+
+bool EntityStore::ReadState(const std::uint32_t* someWords, std::size_t aWordCount)
+{
+	if (aWordCount < 3)
+		return false;
+
+	const std::size_t slotCount = someWords[0];
+	const std::size_t freeSlotCount = someWords[1];
+	const std::size_t count = someWords[2];
+	if (aWordCount != 3 + slotCount * 2 + freeSlotCount + count * 5)
+		return false;
+
+	const std::uint32_t* words = someWords + 3;
+	mySlots.resize(slotCount);
+	for (Slot& slot : mySlots)
+	{
+		slot.myGeneration = *words++;
+		slot.myDenseIndex = *words++;
+	}
+
+	myFreeSlots.assign(words, words + freeSlotCount);
+	words += freeSlotCount;
+	myDenseToSlot.assign(words, words + count);
+	words += count;
+	for (std::vector<float>* column : { &myPositionsX, &myPositionsY, &myVelocitiesX, &myVelocitiesY })
+	{
+		column->resize(count);
+		std::memcpy(column->data(), words, count * sizeof(float));
+		words += count;
+	}
+
+	return true;
+}
+
+bool EntityStore::GetIsAlive(EntityHandle anEntity) const
+{
+	if (anEntity.myIndex >= mySlots.size())
+		return false;
+
+	const Slot& slot = mySlots[anEntity.myIndex];
+	return slot.myGeneration == anEntity.myGeneration && slot.myDenseIndex < myDenseToSlot.size() && myDenseToSlot[slot.myDenseIndex] == anEntity.myIndex;
+}
+
+std::size_t EntityStore::GetDenseIndex(EntityHandle anEntity) const
+{
+	if (!GetIsAlive(anEntity))
+		return ourInvalidIndex;
+
+	return mySlots[anEntity.myIndex].myDenseIndex;
+}
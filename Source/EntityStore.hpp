@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct EntityHandle
+{
+	std::uint32_t myIndex;
+	std::uint32_t myGeneration;
+};
+
+// Entities are stored densely, with every component field in its own contiguous column
+// so systems can stream through them linearly. Handles point at a slot that tracks where
+// the entity currently lives and are invalidated by bumping the slot's generation.
+class EntityStore final
+{
+public:
+	EntityStore();
+
+	EntityStore(const EntityStore&) = delete;
+	EntityStore& operator=(const EntityStore&) = delete;
+
+	void Reserve(std::size_t aCapacity);
+
+	EntityHandle CreateEntity(float aPositionX, float aPositionY, float aVelocityX, float aVelocityY);
+	bool DestroyEntity(EntityHandle anEntity);
+	void Clear();
+
+	bool GetIsAlive(EntityHandle anEntity) const;
+	std::size_t GetDenseIndex(EntityHandle anEntity) const;
+	std::size_t GetCount() const { return myDenseToSlot.size(); }
+
+	float* GetPositionsX() { return myPositionsX.data(); }
+	float* GetPositionsY() { return myPositionsY.data(); }
+	float* GetVelocitiesX() { return myVelocitiesX.data(); }
+	float* GetVelocitiesY() { return myVelocitiesY.data(); }
+	const float* GetPositionsX() const { return myPositionsX.data(); }
+	const float* GetPositionsY() const { return myPositionsY.data(); }
+	const float* GetVelocitiesX() const { return myVelocitiesX.data(); }
+	const float* GetVelocitiesY() const { return myVelocitiesY.data(); }
+
+	// Flattens every table into 32-bit words, floats by their bits, so snapshots can diff and restore the store wholesale.
+	// Reading stays within the reserved capacity when the state was written by a store of the same capacity.
+	void WriteState(std::vector<std::uint32_t>& someWords) const;
+	bool ReadState(const std::uint32_t* someWords, std::size_t aWordCount);
+
+	static constexpr std::size_t ourInvalidIndex = ~static_cast<std::size_t>(0);
+
+private:
+	struct Slot
+	{
+		std::uint32_t myGeneration;
+		std::uint32_t myDenseIndex;
+	};
+
+	std::vector<Slot> mySlots;
+	std::vector<std::uint32_t> myFreeSlots;
+	std::vector<std::uint32_t> myDenseToSlot;
+
+	std::vector<float> myPositionsX;
+	std::vector<float> myPositionsY;
+	std::vector<float> myVelocitiesX;
+	std::vector<float> myVelocitiesY;
+};
@@ -1,8 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdio>
 #include <filesystem>
 #include <fstream>
-#include <sstream>
 #include <string>
 
 namespace FileUtility
@@ -30,11 +31,19 @@ namespace FileUtility
 			return "";
 		}
 
-		std::stringstream sourceStringStream;
-		sourceStringStream << filestream.rdbuf();
+		// Read straight into the result instead of going through an intermediate stream
+		filestream.seekg(0, std::ifstream::end);
+		const std::streamoff size = filestream.tellg();
+		filestream.seekg(0, std::ifstream::beg);
+
+		std::string contents(static_cast<std::size_t>(std::max<std::streamoff>(size, 0)), '\0');
+		filestream.read(contents.data(), static_cast<std::streamsize>(contents.size()));
+
+		// Text mode may translate line endings, leaving fewer characters than the file size
+		contents.resize(static_cast<std::size_t>(filestream.gcount()));
 
 		filestream.close();
 
-		return sourceStringStream.str();
+		return contents;
 	}
 } // namespace FileUtility
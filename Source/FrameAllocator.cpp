@@ -0,0 +1,41 @@
+#include "FrameAllocator.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+FrameAllocator::FrameAllocator(std::size_t aCapacityPerFrame)
+	: myCapacity(aCapacityPerFrame)
+	, myCurrentBuffer(0)
+	, myOffset(0)
+	, myHighWaterMark(0)
+	, myFailedAllocationCount(0)
+{
+	myBuffers[0] = std::make_unique<std::byte[]>(aCapacityPerFrame);
+	myBuffers[1] = std::make_unique<std::byte[]>(aCapacityPerFrame);
+}
+
+void FrameAllocator::BeginFrame()
+{
+	myCurrentBuffer = 1 - myCurrentBuffer;
+	myOffset = 0;
+}
+
+void* FrameAllocator::Allocate(std::size_t aSize, std::size_t anAlignment)
+{
+	std::byte* const buffer = myBuffers[myCurrentBuffer].get();
+	const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(buffer) + myOffset;
+	const std::uintptr_t alignedAddress = (address + (anAlignment - 1)) & ~static_cast<std::uintptr_t>(anAlignment - 1);
+	const std::size_t alignedOffset = myOffset + static_cast<std::size_t>(alignedAddress - address);
+	if (alignedOffset + aSize > myCapacity)
+	{
+		if (myFailedAllocationCount++ == 0)
+			printf("Frame allocator ran out of memory, %zu of %zu bytes in use\n", myOffset, myCapacity);
+
+		return nullptr;
+	}
+
+	myOffset = alignedOffset + aSize;
+	myHighWaterMark = std::max(myHighWaterMark, myOffset);
+	return buffer + alignedOffset;
+}
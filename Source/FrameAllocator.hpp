@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+// Double-buffered bump allocator for per-frame scratch memory. Allocations stay valid until the
+// end of the following frame, so results produced in one frame can still be consumed by the next.
+// The capacity is fixed up front; running out returns nullptr rather than touching the heap.
+class FrameAllocator final
+{
+public:
+	explicit FrameAllocator(std::size_t aCapacityPerFrame);
+
+	FrameAllocator(const FrameAllocator&) = delete;
+	FrameAllocator& operator=(const FrameAllocator&) = delete;
+
+	void BeginFrame();
+
+	void* Allocate(std::size_t aSize, std::size_t anAlignment = alignof(std::max_align_t));
+
+	template<typename T>
+	T* AllocateArray(std::size_t aCount)
+	{
+		return static_cast<T*>(Allocate(sizeof(T) * aCount, alignof(T)));
+	}
+
+	std::size_t GetCapacityPerFrame() const { return myCapacity; }
+	std::size_t GetUsedBytes() const { return myOffset; }
+	std::size_t GetHighWaterMark() const { return myHighWaterMark; }
+	std::size_t GetFailedAllocationCount() const { return myFailedAllocationCount; }
+
+private:
+	std::unique_ptr<std::byte[]> myBuffers[2];
+	std::size_t myCapacity;
+	std::size_t myCurrentBuffer;
+	std::size_t myOffset;
+	std::size_t myHighWaterMark;
+	std::size_t myFailedAllocationCount;
+};
@@ -0,0 +1,311 @@
+#include "FrameCapture.hpp"
+
+#include <glad/glad.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+namespace FrameCaptureParameters
+{
+	// Enough to cover the frames the driver may queue up before a readback completes
+	static constexpr std::size_t ourSlotCount = 3;
+	static constexpr int ourChannelCount = 4;
+}
+
+FrameCapture::FrameCapture(int aWidth, int aHeight)
+	: myNextSlotIndex(0)
+	, myInFlightCount(0)
+	, myWidth(aWidth)
+	, myHeight(aHeight)
+	, myUnfinishedEncodeCount(0)
+	, myFailedComparisonCount(0)
+	, myIsRunning(true)
+{
+	CreateBuffers();
+	myEncodeThread = std::thread(&FrameCapture::EncodeLoop, this);
+}
+
+FrameCapture::~FrameCapture()
+{
+	// Whatever has been read back so far still gets written out
+	while (myInFlightCount > 0)
+	{
+		Slot& slot = mySlots[(myNextSlotIndex + FrameCaptureParameters::ourSlotCount - myInFlightCount) % FrameCaptureParameters::ourSlotCount];
+		glClientWaitSync(static_cast<GLsync>(slot.myFence), GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		RetireSlot(slot);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(myEncodeMutex);
+		myIsRunning = false;
+	}
+	myEncodeCondition.notify_one();
+	myEncodeThread.join();
+
+	DestroyBuffers();
+}
+
+void FrameCapture::RequestScreenshot(const std::string& aFilePath)
+{
+	myPendingRequests.push_back({ RequestType::Screenshot, aFilePath, 0, 0.0f });
+	myUnfinishedEncodeCount.fetch_add(1);
+}
+
+void FrameCapture::RequestComparison(const std::string& aGoldenFilePath, int aChannelTolerance, float aMaxMismatchRatio)
+{
+	myPendingRequests.push_back({ RequestType::Comparison, aGoldenFilePath, aChannelTolerance, aMaxMismatchRatio });
+	myUnfinishedEncodeCount.fetch_add(1);
+}
+
+void FrameCapture::RequestGoldenUpdate(const std::string& aGoldenFilePath)
+{
+	myPendingRequests.push_back({ RequestType::GoldenUpdate, aGoldenFilePath, 0, 0.0f });
+	myUnfinishedEncodeCount.fetch_add(1);
+}
+
+void FrameCapture::OnFrameDrawn()
+{
+	// Retire in issue order and stop at the first readback the GPU hasn't finished yet
+	while (myInFlightCount > 0)
+	{
+		Slot& slot = mySlots[(myNextSlotIndex + FrameCaptureParameters::ourSlotCount - myInFlightCount) % FrameCaptureParameters::ourSlotCount];
+		const GLenum status = glClientWaitSync(static_cast<GLsync>(slot.myFence), 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			break;
+
+		RetireSlot(slot);
+	}
+
+	if (myPendingRequests.empty() || myInFlightCount == FrameCaptureParameters::ourSlotCount)
+		return;
+
+	Slot& slot = mySlots[myNextSlotIndex];
+	slot.myRequest = std::move(myPendingRequests.front());
+	myPendingRequests.pop_front();
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.myPixelBuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, myWidth, myHeight, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	slot.myFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	myNextSlotIndex = (myNextSlotIndex + 1) % FrameCaptureParameters::ourSlotCount;
+	++myInFlightCount;
+}
+
+void FrameCapture::Resize(int aWidth, int aHeight)
+{
+	if (aWidth == myWidth && aHeight == myHeight)
+		return;
+
+	while (myInFlightCount > 0)
+	{
+		Slot& slot = mySlots[(myNextSlotIndex + FrameCaptureParameters::ourSlotCount - myInFlightCount) % FrameCaptureParameters::ourSlotCount];
+		glDeleteSync(static_cast<GLsync>(slot.myFence));
+		slot.myFence = nullptr;
+		--myInFlightCount;
+		myUnfinishedEncodeCount.fetch_sub(1);
+	}
+
+	myUnfinishedEncodeCount.fetch_sub(myPendingRequests.size());
+	myPendingRequests.clear();
+
+	DestroyBuffers();
+	myWidth = aWidth;
+	myHeight = aHeight;
+	CreateBuffers();
+}
+
+bool FrameCapture::GetIsBusy() const
+{
+	return myUnfinishedEncodeCount.load() > 0;
+}
+
+void FrameCapture::CreateBuffers()
+{
+	const GLsizeiptr bufferSize = static_cast<GLsizeiptr>(myWidth) * myHeight * FrameCaptureParameters::ourChannelCount;
+
+	mySlots.resize(FrameCaptureParameters::ourSlotCount);
+	for (Slot& slot : mySlots)
+	{
+		slot.myFence = nullptr;
+		glGenBuffers(1, &slot.myPixelBuffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.myPixelBuffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, bufferSize, nullptr, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	myNextSlotIndex = 0;
+	myInFlightCount = 0;
+}
+
+void FrameCapture::DestroyBuffers()
+{
+	for (Slot& slot : mySlots)
+	{
+		if (slot.myFence)
+			glDeleteSync(static_cast<GLsync>(slot.myFence));
+
+		glDeleteBuffers(1, &slot.myPixelBuffer);
+	}
+
+	mySlots.clear();
+}
+
+void FrameCapture::RetireSlot(Slot& aSlot)
+{
+	glDeleteSync(static_cast<GLsync>(aSlot.myFence));
+	aSlot.myFence = nullptr;
+	--myInFlightCount;
+
+	EncodeTask task;
+	task.myRequest = std::move(aSlot.myRequest);
+	task.myWidth = myWidth;
+	task.myHeight = myHeight;
+	task.myPixels.resize(static_cast<std::size_t>(myWidth) * myHeight * FrameCaptureParameters::ourChannelCount);
+
+	const std::size_t rowSize = static_cast<std::size_t>(myWidth) * FrameCaptureParameters::ourChannelCount;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, aSlot.myPixelBuffer);
+	if (const std::uint8_t* pixels = static_cast<const std::uint8_t*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(task.myPixels.size()), GL_MAP_READ_BIT)))
+	{
+		// GL rows start at the bottom, images at the top
+		for (int y = 0; y < myHeight; ++y)
+			std::memcpy(&task.myPixels[static_cast<std::size_t>(myHeight - 1 - y) * rowSize], pixels + static_cast<std::size_t>(y) * rowSize, rowSize);
+
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	// Blending leaves whatever alpha the tiles had in the framebuffer, but what's on screen is opaque
+	for (std::size_t i = FrameCaptureParameters::ourChannelCount - 1; i < task.myPixels.size(); i += FrameCaptureParameters::ourChannelCount)
+		task.myPixels[i] = 255;
+
+	{
+		std::lock_guard<std::mutex> lock(myEncodeMutex);
+		myEncodeTasks.push_back(std::move(task));
+	}
+	myEncodeCondition.notify_one();
+}
+
+void FrameCapture::EncodeLoop()
+{
+	while (true)
+	{
+		EncodeTask task;
+		{
+			std::unique_lock<std::mutex> lock(myEncodeMutex);
+			myEncodeCondition.wait(lock, [this]() { return !myIsRunning || !myEncodeTasks.empty(); });
+			if (myEncodeTasks.empty())
+				return;
+
+			task = std::move(myEncodeTasks.front());
+			myEncodeTasks.pop_front();
+		}
+
+		if (task.myRequest.myType == RequestType::Comparison)
+		{
+			if (!Compare(task))
+				myFailedComparisonCount.fetch_add(1);
+		}
+		else
+		{
+			const bool isGolden = task.myRequest.myType == RequestType::GoldenUpdate;
+			const bool isWritten = Write(task);
+			printf("%s %s to %s\n", isWritten ? "Saved" : "Failed to save", isGolden ? "golden image" : "screenshot", task.myRequest.myFilePath.c_str());
+			if (isGolden && !isWritten)
+				myFailedComparisonCount.fetch_add(1);
+		}
+
+		myUnfinishedEncodeCount.fetch_sub(1);
+	}
+}
+
+bool FrameCapture::Compare(const EncodeTask& aTask) const
+{
+	const std::string& goldenFilePath = aTask.myRequest.myFilePath;
+	const int rowSize = aTask.myWidth * FrameCaptureParameters::ourChannelCount;
+
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	unsigned char* golden = stbi_load(goldenFilePath.c_str(), &width, &height, &channels, FrameCaptureParameters::ourChannelCount);
+	if (!golden)
+	{
+		printf("Golden image %s failed: it doesn't exist, run with --update-goldens to create it\n", goldenFilePath.c_str());
+		return false;
+	}
+
+	if (width != aTask.myWidth || height != aTask.myHeight)
+	{
+		printf("Golden image %s is %dx%d but the frame is %dx%d\n", goldenFilePath.c_str(), width, height, aTask.myWidth, aTask.myHeight);
+		stbi_image_free(golden);
+		return false;
+	}
+
+	// Mismatching pixels are marked red on a dimmed copy of the frame
+	std::vector<std::uint8_t> difference(aTask.myPixels.size());
+	std::size_t mismatchCount = 0;
+	int largestDifference = 0;
+	const std::size_t pixelCount = static_cast<std::size_t>(width) * height;
+	for (std::size_t i = 0; i < pixelCount; ++i)
+	{
+		const std::uint8_t* captured = &aTask.myPixels[i * FrameCaptureParameters::ourChannelCount];
+		const unsigned char* expected = &golden[i * FrameCaptureParameters::ourChannelCount];
+
+		int pixelDifference = 0;
+		for (int channel = 0; channel < FrameCaptureParameters::ourChannelCount; ++channel)
+			pixelDifference = std::max(pixelDifference, std::abs(static_cast<int>(captured[channel]) - static_cast<int>(expected[channel])));
+
+		largestDifference = std::max(largestDifference, pixelDifference);
+		const bool isMismatch = pixelDifference > aTask.myRequest.myChannelTolerance;
+		mismatchCount += isMismatch ? 1 : 0;
+
+		std::uint8_t* marked = &difference[i * FrameCaptureParameters::ourChannelCount];
+		const std::uint8_t luminance = static_cast<std::uint8_t>((captured[0] + captured[1] + captured[2]) / 12);
+		marked[0] = isMismatch ? 255 : luminance;
+		marked[1] = isMismatch ? 0 : luminance;
+		marked[2] = isMismatch ? 0 : luminance;
+		marked[3] = 255;
+	}
+
+	stbi_image_free(golden);
+
+	const float mismatchRatio = static_cast<float>(mismatchCount) / static_cast<float>(std::max<std::size_t>(pixelCount, 1));
+	const bool isMatch = mismatchRatio <= aTask.myRequest.myMaxMismatchRatio;
+	printf("Golden image %s %s: %zu of %zu pixels differ (%.4f%%), largest channel difference %d\n",
+		goldenFilePath.c_str(),
+		isMatch ? "passed" : "failed",
+		mismatchCount,
+		pixelCount,
+		mismatchRatio * 100.0f,
+		largestDifference);
+
+	if (!isMatch)
+	{
+		std::filesystem::path differencePath(goldenFilePath);
+		differencePath.replace_filename(differencePath.stem().string() + "_Difference.png");
+		stbi_write_png(differencePath.string().c_str(), width, height, FrameCaptureParameters::ourChannelCount, difference.data(), rowSize);
+	}
+
+	return isMatch;
+}
+
+bool FrameCapture::Write(const EncodeTask& aTask)
+{
+	const std::filesystem::path directory = std::filesystem::path(aTask.myRequest.myFilePath).parent_path();
+	std::error_code error;
+	if (!directory.empty() && !std::filesystem::create_directories(directory, error) && error)
+	{
+		printf("Failed to create %s: %s\n", directory.string().c_str(), error.message().c_str());
+		return false;
+	}
+
+	const int rowSize = aTask.myWidth * FrameCaptureParameters::ourChannelCount;
+	return stbi_write_png(aTask.myRequest.myFilePath.c_str(), aTask.myWidth, aTask.myHeight, FrameCaptureParameters::ourChannelCount, aTask.myPixels.data(), rowSize) != 0;
+}
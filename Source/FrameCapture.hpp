@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Reads finished frames back through a ring of pixel buffer objects guarded by fences, so a
+// capture never waits on the GPU. Mapped frames are handed to an encoder thread of our own rather
+// than the job system, whose calling thread only runs jobs while it waits on them.
+class FrameCapture final
+{
+public:
+	FrameCapture(int aWidth, int aHeight);
+	~FrameCapture();
+
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture& operator=(const FrameCapture&) = delete;
+
+	void RequestScreenshot(const std::string& aFilePath);
+	// Passes when at most aMaxMismatchRatio of the pixels differ by more than aChannelTolerance in any channel.
+	// A missing golden image fails the comparison.
+	void RequestComparison(const std::string& aGoldenFilePath, int aChannelTolerance, float aMaxMismatchRatio);
+	// Writes the capture as the golden image, counted as a failed comparison if it can't be written
+	void RequestGoldenUpdate(const std::string& aGoldenFilePath);
+
+	// Call once the frame is drawn and before buffers are swapped
+	void OnFrameDrawn();
+	// Reallocates the readback buffers, pending captures are dropped
+	void Resize(int aWidth, int aHeight);
+
+	bool GetIsBusy() const;
+	std::size_t GetFailedComparisonCount() const { return myFailedComparisonCount.load(); }
+
+private:
+	enum class RequestType
+	{
+		Screenshot,
+		Comparison,
+		GoldenUpdate
+	};
+
+	struct Request
+	{
+		RequestType myType;
+		std::string myFilePath;
+		int myChannelTolerance;
+		float myMaxMismatchRatio;
+	};
+
+	struct Slot
+	{
+		Request myRequest;
+		void* myFence;
+		unsigned int myPixelBuffer;
+	};
+
+	struct EncodeTask
+	{
+		Request myRequest;
+		std::vector<std::uint8_t> myPixels;
+		int myWidth;
+		int myHeight;
+	};
+
+	void CreateBuffers();
+	void DestroyBuffers();
+	void RetireSlot(Slot& aSlot);
+	void EncodeLoop();
+	bool Compare(const EncodeTask& aTask) const;
+	static bool Write(const EncodeTask& aTask);
+
+	std::vector<Slot> mySlots;
+	std::deque<Request> myPendingRequests;
+	std::size_t myNextSlotIndex;
+	std::size_t myInFlightCount;
+	int myWidth;
+	int myHeight;
+
+	std::thread myEncodeThread;
+	std::mutex myEncodeMutex;
+	std::condition_variable myEncodeCondition;
+	std::deque<EncodeTask> myEncodeTasks;
+	std::atomic<std::size_t> myUnfinishedEncodeCount;
+	std::atomic<std::size_t> myFailedComparisonCount;
+	bool myIsRunning;
+};
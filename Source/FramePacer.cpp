@@ -0,0 +1,149 @@
+#include "FramePacer.hpp"
+#include "InputManager.hpp"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+namespace FramePacerParameters
+{
+	// Sleeping stops this far ahead of the deadline and the rest is spun off
+	static constexpr std::chrono::microseconds ourSpinDuration = std::chrono::microseconds(2000);
+	static constexpr std::chrono::seconds ourReportInterval = std::chrono::seconds(1);
+	static constexpr GLuint64 ourFenceTimeout = 1000000000;
+}
+
+FramePacer::FramePacer(GLFWwindow* aWindow, PacingMode aMode, double aTargetRate, bool anIsWaitingForGPU)
+	: myWindow(aWindow)
+	, myNextFrameTime(Clock::now())
+	, myPreviousPresentTime(Clock::now())
+	, myReportTime(Clock::now())
+	, myFrameFence(nullptr)
+	, myTargetRate(aTargetRate)
+	, myFrameTimeSum(0.0)
+	, myFrameTimeMaximum(0.0)
+	, myLatencySum(0.0)
+	, myLatencyMaximum(0.0)
+	, myFrameCount(0)
+	, myLatencyCount(0)
+	, myMode(aMode)
+	, myIsWaitingForGPU(anIsWaitingForGPU)
+{
+	ApplySwapInterval();
+}
+
+FramePacer::~FramePacer()
+{
+	if (myFrameFence)
+		glDeleteSync(static_cast<GLsync>(myFrameFence));
+}
+
+void FramePacer::SetMode(PacingMode aMode)
+{
+	myMode = aMode;
+	myNextFrameTime = Clock::now();
+	ApplySwapInterval();
+}
+
+void FramePacer::SetIsWaitingForGPU(bool anIsWaitingForGPU)
+{
+	myIsWaitingForGPU = anIsWaitingForGPU;
+	if (!myIsWaitingForGPU && myFrameFence)
+	{
+		glDeleteSync(static_cast<GLsync>(myFrameFence));
+		myFrameFence = nullptr;
+	}
+}
+
+void FramePacer::BeginFrame()
+{
+	if (myMode == PacingMode::TargetRate)
+	{
+		const Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / myTargetRate));
+		myNextFrameTime += period;
+
+		// After a hitch start counting from now again instead of rushing to catch up
+		const Clock::time_point now = Clock::now();
+		if (myNextFrameTime < now - period)
+			myNextFrameTime = now;
+
+		if (myNextFrameTime - now > FramePacerParameters::ourSpinDuration)
+			std::this_thread::sleep_until(myNextFrameTime - FramePacerParameters::ourSpinDuration);
+
+		while (Clock::now() < myNextFrameTime)
+			std::this_thread::yield();
+	}
+
+	// Wait for the GPU to finish the previous frame so input sampled next isn't displayed a frame late
+	if (myFrameFence)
+	{
+		glClientWaitSync(static_cast<GLsync>(myFrameFence), GL_SYNC_FLUSH_COMMANDS_BIT, FramePacerParameters::ourFenceTimeout);
+		glDeleteSync(static_cast<GLsync>(myFrameFence));
+		myFrameFence = nullptr;
+	}
+}
+
+void FramePacer::Present()
+{
+	glfwSwapBuffers(myWindow);
+	if (myIsWaitingForGPU)
+		myFrameFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	const Clock::time_point now = Clock::now();
+	const double frameTime = std::chrono::duration<double, std::milli>(now - myPreviousPresentTime).count();
+	myPreviousPresentTime = now;
+	myFrameTimeSum += frameTime;
+	myFrameTimeMaximum = std::max(myFrameTimeMaximum, frameTime);
+	++myFrameCount;
+
+	Clock::time_point eventTime;
+	if (InputManager::GetInstance().PopEventTime(eventTime))
+	{
+		const double latency = std::chrono::duration<double, std::milli>(now - eventTime).count();
+		myLatencySum += latency;
+		myLatencyMaximum = std::max(myLatencyMaximum, latency);
+		++myLatencyCount;
+	}
+
+	if (now - myReportTime >= FramePacerParameters::ourReportInterval)
+	{
+		PrintStatistics();
+		ResetStatistics();
+		myReportTime = now;
+	}
+}
+
+void FramePacer::PrintStatistics() const
+{
+	static constexpr const char* ourModeNames[] = { "vsync", "uncapped", "target rate" };
+
+	const double averageFrameTime = myFrameCount > 0 ? myFrameTimeSum / myFrameCount : 0.0;
+	printf("Frame %.2f ms avg / %.2f ms max (%s%s)",
+		averageFrameTime,
+		myFrameTimeMaximum,
+		ourModeNames[static_cast<int>(myMode)],
+		myIsWaitingForGPU ? ", waiting for GPU" : "");
+
+	if (myLatencyCount > 0)
+		printf(", input to present %.2f ms avg / %.2f ms max over %u events\n", myLatencySum / myLatencyCount, myLatencyMaximum, myLatencyCount);
+	else
+		printf("\n");
+}
+
+void FramePacer::ApplySwapInterval() const
+{
+	glfwSwapInterval(myMode == PacingMode::VSync ? 1 : 0);
+}
+
+void FramePacer::ResetStatistics()
+{
+	myFrameTimeSum = 0.0;
+	myFrameTimeMaximum = 0.0;
+	myLatencySum = 0.0;
+	myLatencyMaximum = 0.0;
+	myFrameCount = 0;
+	myLatencyCount = 0;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+struct GLFWwindow;
+
+enum class PacingMode
+{
+	VSync,
+	Uncapped,
+	TargetRate
+};
+
+// Decides when the next frame may start. Target rate mode sleeps most of the remaining frame
+// time away and spins for the rest, since sleeps overshoot by up to a scheduler tick. Waiting
+// on the GPU keeps at most one frame queued up, trading throughput for input latency.
+class FramePacer final
+{
+public:
+	FramePacer(GLFWwindow* aWindow, PacingMode aMode, double aTargetRate, bool anIsWaitingForGPU);
+	~FramePacer();
+
+	FramePacer(const FramePacer&) = delete;
+	FramePacer& operator=(const FramePacer&) = delete;
+
+	void SetMode(PacingMode aMode);
+	void SetIsWaitingForGPU(bool anIsWaitingForGPU);
+	PacingMode GetMode() const { return myMode; }
+	bool GetIsWaitingForGPU() const { return myIsWaitingForGPU; }
+
+	// Blocks until the next frame is due, call before polling input
+	void BeginFrame();
+	// Swaps buffers and records how long the oldest input of the frame took to reach the screen at most
+	void Present();
+
+	void PrintStatistics() const;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	void ApplySwapInterval() const;
+	void ResetStatistics();
+
+	GLFWwindow* myWindow;
+	Clock::time_point myNextFrameTime;
+	Clock::time_point myPreviousPresentTime;
+	Clock::time_point myReportTime;
+	void* myFrameFence;
+	double myTargetRate;
+	double myFrameTimeSum;
+	double myFrameTimeMaximum;
+	double myLatencySum;
+	double myLatencyMaximum;
+	std::uint32_t myFrameCount;
+	std::uint32_t myLatencyCount;
+	PacingMode myMode;
+	bool myIsWaitingForGPU;
+};
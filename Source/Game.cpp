@@ -1,33 +1,112 @@
 #include "Game.hpp"
-#include "FileUtility.hpp"
+#include "AllocationTracker.hpp"
+#include "FrameCapture.hpp"
+#include "FramePacer.hpp"
 #include "Shader.hpp"
 #include "GLDebugUtility.hpp"
 #include "GLFWDebugUtility.hpp"
 #include "InputManager.hpp"
 #include "Camera.hpp"
+#include "JobSystem.hpp"
+#include "LightMap.hpp"
+#include "MemoryArena.hpp"
+#include "MovementSystem.hpp"
+#include "ParticleRenderer.hpp"
+#include "ParticleSystem.hpp"
+#include "PathfindingService.hpp"
+#include "RenderTarget.hpp"
+#include "ResolutionScaler.hpp"
+#include "SnapshotRing.hpp"
+#include "TilePropertyTable.hpp"
+#include "VirtualFileSystem.hpp"
 
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <tmxlite/Map.hpp>
+#include <tmxlite/TileLayer.hpp>
 
 namespace GameParameters
 {
 	static constexpr float ourCameraMovementSpeed = 500.0f;
 	static constexpr glm::vec3 ourHorizontalAxis = glm::vec3(1.0f, 0.0f, 0.0f);
 	static constexpr glm::vec3 ourVerticallAxis = glm::vec3(0.0f, 1.0f, 0.0f);
+	static constexpr MapLayer::GeometryMode ourMapGeometryMode = MapLayer::GeometryMode::TileRuns;
+	static constexpr std::size_t ourLoadArenaBlockSize = 16 * 1024 * 1024;
+	static constexpr std::size_t ourFrameAllocatorCapacity = 1024 * 1024;
+	static constexpr unsigned int ourAllocationWarmupFrames = 60;
+	static constexpr std::size_t ourEntityCapacity = 65536;
+	static constexpr int ourLightRadius = 10;
+	static constexpr std::uint8_t ourLightIntensity = 255;
+	static constexpr int ourViewRadius = 24;
+	// Late enough for lighting and streaming to have settled
+	static constexpr unsigned int ourGoldenCaptureFrame = 120;
+	static constexpr int ourGoldenChannelTolerance = 8;
+	static constexpr float ourGoldenMaxMismatchRatio = 0.001f;
+	// Goldens live in the source tree rather than the copy of Data next to the binaries, so updates end up in the repository
+#ifdef VIRIDIAN_SOURCE_DIRECTORY
+	static constexpr const char* ourGoldenDirectory = VIRIDIAN_SOURCE_DIRECTORY "/Data/Goldens/";
+#else
+	static constexpr const char* ourGoldenDirectory = "Data/Goldens/";
+#endif
+	static constexpr float ourTargetFrameMilliseconds = 1000.0f / 60.0f;
+	// Multisampling happens in the render target, the window itself isn't multisampled
+	static constexpr int ourSampleCount = 4;
+	static constexpr PacingMode ourPacingMode = PacingMode::VSync;
+	static constexpr double ourTargetFrameRate = 60.0;
+	static constexpr bool ourIsWaitingForGPU = true;
+	// Ten minutes of ticks at the target rate, if they fit in the memory
+	static constexpr std::size_t ourSnapshotCapacity = 64 * 1024 * 1024;
+	static constexpr std::size_t ourSnapshotRecordCount = 10 * 60 * 60;
+	static constexpr unsigned int ourSnapshotKeyframeInterval = 60;
+	static constexpr std::size_t ourParticleCapacity = 65536;
+	static constexpr float ourParticleGravity = 60.0f;
 }
 
 Game::Game()
-	: myModelMatrix(0.0f)
+	: myFrameAllocator(GameParameters::ourFrameAllocatorCapacity)
+	, myPlayerLightIndex(0)
+	, mySparkEmitterIndex(0)
+	, mySmokeEmitterIndex(0)
+	, mySolidFlag(0)
+	, myHeldGID(0)
+	, myModelMatrix(0.0f)
 	, myModelViewProjectionMatrix(0.0f)
 	, myWindowSize(0.0f)
+	, myMapTileSize(0.0f)
 	, myGLFWWindow(nullptr)
 	, myCamera(nullptr)
 	, myShaderProgramIdentifier(0)
+	, myScreenshotCount(0)
+	, mySimulationTick(0)
+	, myIsGoldenTest(false)
+	, myIsUpdatingGoldens(false)
+	, myIsMinimized(false)
+	, myHasTileEdits(false)
+	, myIsLightingEnabled(false)
+	, myWasScreenshotKeyDown(false)
+	, myWasPacingKeyDown(false)
+	, myWasGPUWaitKeyDown(false)
+	, myWasRewindKeyDown(false)
+	, myWasParticleKeyDown(false)
+	, myWasEditKeyDown(false)
+	, myWasLightingKeyDown(false)
+{}
+
+Game::DecodedTexture::DecodedTexture()
+	: myIsCompressed(false)
+	, myPixels(nullptr)
+	, myWidth(0)
+	, myHeight(0)
 {}
 
 Game::~Game()
@@ -35,8 +114,15 @@ Game::~Game()
 	if (myShaderProgramIdentifier)
 		glDeleteProgram(myShaderProgramIdentifier);
 
-	for (const unsigned int& textureIdentifier : myTileTextureIdentifiers)
-		glDeleteTextures(1, &textureIdentifier);
+	for (const TilesetTexture& tilesetTexture : myTilesetTextures)
+		glDeleteTextures(1, &tilesetTexture.myTextureIdentifier);
+
+	myLightMap.reset();
+	myParticleRenderer.reset();
+	myFrameCapture.reset();
+	myRenderTarget.reset();
+	myResolutionScaler.reset();
+	myFramePacer.reset();
 
 	glfwTerminate();
 }
@@ -57,7 +143,9 @@ void Game::Initialize()
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_COMPAT_PROFILE);
 	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
-	glfwWindowHint(GLFW_SAMPLES, 4);
+	// The render target is multisampled instead and resolved before it's scaled, a multisampled window can't receive that blit
+	glfwWindowHint(GLFW_SAMPLES, 0);
+	glfwWindowHint(GLFW_DEPTH_BITS, 24);
 
 	myWindowSize = glm::vec2(800.0f, 600.0f);
 
@@ -72,6 +160,7 @@ void Game::Initialize()
 	glfwMakeContextCurrent(myGLFWWindow);
 	glfwSetWindowUserPointer(myGLFWWindow, this);
 	glfwSetKeyCallback(myGLFWWindow, KeyCallback);
+	glfwSetFramebufferSizeCallback(myGLFWWindow, FramebufferSizeCallback);
 	glfwSetInputMode(myGLFWWindow, GLFW_STICKY_KEYS, GL_TRUE);
 
 	if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)))
@@ -88,89 +177,387 @@ void Game::Initialize()
 	glDebugMessageControl(GL_DEBUG_SOURCE_API, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_FALSE);
 	glDebugMessageCallback(GLDebugUtility::ErrorCallback, nullptr);
 
+	// Everything past here works in framebuffer pixels, which only match the window size without display scaling
+	int framebufferWidth = 0;
+	int framebufferHeight = 0;
+	glfwGetFramebufferSize(myGLFWWindow, &framebufferWidth, &framebufferHeight);
+	myWindowSize = glm::vec2(static_cast<float>(framebufferWidth), static_cast<float>(framebufferHeight));
+
 	myCamera = new Camera(myWindowSize);
+	myFrameCapture = std::make_unique<FrameCapture>(framebufferWidth, framebufferHeight);
+	myRenderTarget = std::make_unique<RenderTarget>(framebufferWidth, framebufferHeight, GameParameters::ourSampleCount);
+	myResolutionScaler = std::make_unique<ResolutionScaler>(GameParameters::ourTargetFrameMilliseconds);
+	myResolutionScaler->SetIsEnabled(!myIsGoldenTest);
+	myFramePacer = std::make_unique<FramePacer>(myGLFWWindow, GameParameters::ourPacingMode, GameParameters::ourTargetFrameRate, GameParameters::ourIsWaitingForGPU);
+
+	// Reserving up front keeps spawning within capacity from touching the heap mid-game
+	myEntityStore.Reserve(GameParameters::ourEntityCapacity);
+
+	// F8 toggles the emitters, they start out off so golden images stay free of particles
+	myParticleSystem = std::make_unique<ParticleSystem>(2, GameParameters::ourParticleCapacity);
+	myParticleSystem->SetGravity(0.0f, GameParameters::ourParticleGravity);
+
+	ParticleEmitter sparkEmitter;
+	sparkEmitter.myMaterial = 0;
+	sparkEmitter.myRate = 2000.0f;
+	sparkEmitter.mySpeedMinimum = 80.0f;
+	sparkEmitter.mySpeedMaximum = 240.0f;
+	sparkEmitter.myLifetimeMinimum = 0.5f;
+	sparkEmitter.myLifetimeMaximum = 1.5f;
+	sparkEmitter.mySize = 6.0f;
+	sparkEmitter.myIsEnabled = false;
+	mySparkEmitterIndex = myParticleSystem->AddEmitter(sparkEmitter);
+
+	ParticleEmitter smokeEmitter;
+	smokeEmitter.myMaterial = 1;
+	smokeEmitter.myRate = 60.0f;
+	smokeEmitter.myDirection = -1.5707963f;
+	smokeEmitter.mySpread = 0.8f;
+	smokeEmitter.mySpeedMinimum = 60.0f;
+	smokeEmitter.mySpeedMaximum = 120.0f;
+	smokeEmitter.myLifetimeMinimum = 1.5f;
+	smokeEmitter.myLifetimeMaximum = 2.5f;
+	smokeEmitter.mySize = 32.0f;
+	smokeEmitter.myIsEnabled = false;
+	mySmokeEmitterIndex = myParticleSystem->AddEmitter(smokeEmitter);
 }
 
 void Game::Run()
 {
 	printf("Current working directory: %s\n", std::filesystem::current_path().string().c_str());
 
+	// Files missing from the pack, or all of them without one, are read from Data as loose files
+	if (std::filesystem::exists(AssetPack::ourDefaultFilepath))
+		VirtualFileSystem::GetInstance().MountPack(AssetPack::ourDefaultFilepath);
+
 	LoadMap();
+	VirtualFileSystem::GetInstance().ReleaseCache();
 
+	mySnapshotRing = std::make_unique<SnapshotRing>(GameParameters::ourSnapshotCapacity, GameParameters::ourSnapshotRecordCount, GameParameters::ourSnapshotKeyframeInterval);
+	mySnapshotRing->Record(mySimulationTick, myEntityStore, *myTileProperties, myCamera->GetPosition());
+
+	unsigned int frameIndex = 0;
 	std::chrono::time_point<std::chrono::steady_clock> previousTime = std::chrono::high_resolution_clock::now();
 	while (!glfwWindowShouldClose(myGLFWWindow))
 	{
+		if (myIsMinimized)
+		{
+			glfwWaitEvents();
+			InputManager::GetInstance().OnEventsPolled();
+			previousTime = std::chrono::high_resolution_clock::now();
+			continue;
+		}
+
+		const std::uint64_t allocationCount = AllocationTracker::GetAllocationCount();
+		// An encode finishing partway through the frame has already been counted by the time it's no longer busy
+		const bool wasCapturing = myFrameCapture->GetIsBusy();
+		myHasTileEdits = false;
+
+		// Input is sampled as late as possible, right after waiting for the frame to be due. Polling before the
+		// wait as well dates what arrived during the last frame from before it, so latency includes the wait.
+		glfwPollEvents();
+		InputManager::GetInstance().OnEventsPolled();
+		myFramePacer->BeginFrame();
+		glfwPollEvents();
+		InputManager::GetInstance().OnEventsPolled();
+
 		std::chrono::time_point<std::chrono::steady_clock> currentTime = std::chrono::high_resolution_clock::now();
 		std::chrono::duration<long long, std::ratio<1, 1000000000>> elapsedTime = currentTime - previousTime;
 		const float deltaTime = std::chrono::duration<float>(elapsedTime).count();
 		previousTime = currentTime;
 
+		myFrameAllocator.BeginFrame();
+
 		Update(deltaTime);
+
+		const int windowWidth = static_cast<int>(myWindowSize.x);
+		const int windowHeight = static_cast<int>(myWindowSize.y);
+		int renderWidth = 0;
+		int renderHeight = 0;
+		myResolutionScaler->GetRenderSize(windowWidth, windowHeight, renderWidth, renderHeight);
+
+		myResolutionScaler->BeginFrame();
+		myRenderTarget->Bind(renderWidth, renderHeight);
 		Draw();
+		myRenderTarget->BlitToWindow(renderWidth, renderHeight, windowWidth, windowHeight);
+		myResolutionScaler->EndFrame();
+
+		if (myIsGoldenTest && frameIndex == GameParameters::ourGoldenCaptureFrame)
+		{
+			const std::string goldenFilePath = GameParameters::ourGoldenDirectory + std::filesystem::path(myMapFilePath).stem().string() + ".png";
+			if (myIsUpdatingGoldens)
+				myFrameCapture->RequestGoldenUpdate(goldenFilePath);
+			else
+				myFrameCapture->RequestComparison(goldenFilePath, GameParameters::ourGoldenChannelTolerance, GameParameters::ourGoldenMaxMismatchRatio);
+		}
+
+		const bool isCapturing = wasCapturing || myFrameCapture->GetIsBusy();
+		myFrameCapture->OnFrameDrawn();
+
+		myFramePacer->Present();
+
+		if (myIsGoldenTest && frameIndex > GameParameters::ourGoldenCaptureFrame && !myFrameCapture->GetIsBusy())
+			glfwSetWindowShouldClose(myGLFWWindow, true);
+
+		// Once warmed up, frames are expected to get by on the frame allocator alone.
+		// Captures are exempt, encoding on the side allocates and is counted too, and so are tile edits,
+		// which rebuild geometry and the pathfinding abstraction.
+		const std::uint64_t frameAllocationCount = AllocationTracker::GetAllocationCount() - allocationCount;
+		if (frameIndex >= GameParameters::ourAllocationWarmupFrames && frameAllocationCount != 0 && !isCapturing && !myHasTileEdits)
+		{
+			printf("Frame %u performed %llu heap allocations\n", frameIndex, static_cast<unsigned long long>(frameAllocationCount));
+			assert(false && "Steady-state frames must not allocate from the heap");
+		}
+
+		++frameIndex;
 	}
+
+	printf("Frame allocator high water mark: %zu of %zu bytes\n", myFrameAllocator.GetHighWaterMark(), myFrameAllocator.GetCapacityPerFrame());
+}
+
+std::size_t Game::GetFailedComparisonCount() const
+{
+	return myFrameCapture ? myFrameCapture->GetFailedComparisonCount() : 0;
 }
 
 void Game::Update(const float aDeltaTime)
 {
+	glm::vec3 movement(0.0f);
 	if (InputManager::GetInstance().GetIsKeyDown(Key::Left))
 	{
-		myCamera->SetPosition(myCamera->GetPosition() - (GameParameters::ourHorizontalAxis * aDeltaTime * GameParameters::ourCameraMovementSpeed));
+		movement -= GameParameters::ourHorizontalAxis * aDeltaTime * GameParameters::ourCameraMovementSpeed;
 	}
 
 	if (InputManager::GetInstance().GetIsKeyDown(Key::Right))
 	{
-		myCamera->SetPosition(myCamera->GetPosition() + (GameParameters::ourHorizontalAxis * aDeltaTime * GameParameters::ourCameraMovementSpeed));
+		movement += GameParameters::ourHorizontalAxis * aDeltaTime * GameParameters::ourCameraMovementSpeed;
 	}
 
 	if (InputManager::GetInstance().GetIsKeyDown(Key::Up))
 	{
-		myCamera->SetPosition(myCamera->GetPosition() - (GameParameters::ourVerticallAxis * aDeltaTime * GameParameters::ourCameraMovementSpeed));
+		movement -= GameParameters::ourVerticallAxis * aDeltaTime * GameParameters::ourCameraMovementSpeed;
 	}
 
 	if (InputManager::GetInstance().GetIsKeyDown(Key::Down))
 	{
-		myCamera->SetPosition(myCamera->GetPosition() + (GameParameters::ourVerticallAxis * aDeltaTime * GameParameters::ourCameraMovementSpeed));
+		movement += GameParameters::ourVerticallAxis * aDeltaTime * GameParameters::ourCameraMovementSpeed;
 	}
 
+	MovePlayer(movement);
+
 	if (InputManager::GetInstance().GetIsKeyDown(Key::Escape))
 	{
 		glfwSetWindowShouldClose(myGLFWWindow, true);
 	}
 
+	const bool isScreenshotKeyDown = InputManager::GetInstance().GetIsKeyDown(Key::F12);
+	if (isScreenshotKeyDown && !myWasScreenshotKeyDown)
+	{
+		myFrameCapture->RequestScreenshot("Screenshots/Screenshot" + std::to_string(myScreenshotCount) + ".png");
+		++myScreenshotCount;
+	}
+	myWasScreenshotKeyDown = isScreenshotKeyDown;
+
+	const bool isPacingKeyDown = InputManager::GetInstance().GetIsKeyDown(Key::F5);
+	if (isPacingKeyDown && !myWasPacingKeyDown)
+	{
+		switch (myFramePacer->GetMode())
+		{
+			case PacingMode::VSync : myFramePacer->SetMode(PacingMode::Uncapped); break;
+			case PacingMode::Uncapped : myFramePacer->SetMode(PacingMode::TargetRate); break;
+			case PacingMode::TargetRate : myFramePacer->SetMode(PacingMode::VSync); break;
+		}
+	}
+	myWasPacingKeyDown = isPacingKeyDown;
+
+	const bool isGPUWaitKeyDown = InputManager::GetInstance().GetIsKeyDown(Key::F6);
+	if (isGPUWaitKeyDown && !myWasGPUWaitKeyDown)
+		myFramePacer->SetIsWaitingForGPU(!myFramePacer->GetIsWaitingForGPU());
+	myWasGPUWaitKeyDown = isGPUWaitKeyDown;
+
+	// F10 picks up the tile below the player on the collision layer, or puts the held one down if the cell is empty.
+	// Edits happen before the tick is recorded, so the snapshot holds them.
+	const bool isEditKeyDown = InputManager::GetInstance().GetIsKeyDown(Key::F10);
+	if (isEditKeyDown && !myWasEditKeyDown && !myCollisionLayers.empty())
+	{
+		const GridPoint playerTile = GetPlayerTile(myCamera->GetPosition());
+		const GridPoint editedTile = { playerTile.myX, playerTile.myY + 1 };
+		const std::uint32_t gid = myTileProperties->GetGID(myCollisionLayers.front(), editedTile.myX, editedTile.myY);
+		if (gid != 0)
+		{
+			myHeldGID = gid;
+			SetTile(myCollisionLayers.front(), editedTile, 0);
+		}
+		else if (myHeldGID != 0)
+		{
+			SetTile(myCollisionLayers.front(), editedTile, myHeldGID);
+			myHeldGID = 0;
+		}
+	}
+	myWasEditKeyDown = isEditKeyDown;
+
+	// Holding F7 steps the simulation back a tick per frame instead of advancing it
+	const bool isRewindKeyDown = InputManager::GetInstance().GetIsKeyDown(Key::F7);
+	if (isRewindKeyDown)
+	{
+		// Restoring rewrites edited chunks of the tile table only, what reads it is caught up afterwards
+		const std::vector<std::uint32_t>& editedChunks = myTileProperties->GetEditedChunks();
+		for (std::size_t i = 0; i < editedChunks.size(); ++i)
+			myTileProperties->ReadChunk(editedChunks[i], &myEditedChunkGIDs[i * TilePropertyTable::ourChunkTileCount]);
+
+		glm::vec3 cameraPosition = myCamera->GetPosition();
+		if (mySimulationTick > mySnapshotRing->GetOldestTick() && mySnapshotRing->Restore(mySimulationTick - 1, myEntityStore, *myTileProperties, cameraPosition))
+		{
+			--mySimulationTick;
+			myCamera->SetPosition(cameraPosition);
+			RefreshRestoredTiles();
+		}
+	}
+	else
+	{
+		if (myWasRewindKeyDown)
+			mySnapshotRing->PrintStatistics(GameParameters::ourTargetFrameRate);
+
+		MovementSystem::Update(myEntityStore, aDeltaTime);
+		++mySimulationTick;
+		mySnapshotRing->Record(mySimulationTick, myEntityStore, *myTileProperties, myCamera->GetPosition());
+	}
+	myWasRewindKeyDown = isRewindKeyDown;
+
+	const bool isParticleKeyDown = InputManager::GetInstance().GetIsKeyDown(Key::F8);
+	if (isParticleKeyDown && !myWasParticleKeyDown)
+	{
+		ParticleEmitter& sparkEmitter = myParticleSystem->GetEmitter(mySparkEmitterIndex);
+		sparkEmitter.myIsEnabled = !sparkEmitter.myIsEnabled;
+		myParticleSystem->GetEmitter(mySmokeEmitterIndex).myIsEnabled = sparkEmitter.myIsEnabled;
+	}
+	myWasParticleKeyDown = isParticleKeyDown;
+
+	ApplyTileEdits();
+
+	const bool isLightingKeyDown = InputManager::GetInstance().GetIsKeyDown(Key::F9);
+	if (isLightingKeyDown && !myWasLightingKeyDown)
+		myIsLightingEnabled = !myIsLightingEnabled;
+	myWasLightingKeyDown = isLightingKeyDown;
+
+	// Edits made with lighting off leave the light map dirty, so it catches up once lighting is back on
+	if (myLightMap && myIsLightingEnabled)
+	{
+		// The player's light and line of sight sit at the middle of the screen for now
+		const GridPoint centerTile = GetPlayerTile(myCamera->GetPosition());
+		myLightMap->SetLightPosition(myPlayerLightIndex, centerTile);
+		myLightMap->SetViewer(centerTile, GameParameters::ourViewRadius);
+		myLightMap->Update(myFrameAllocator);
+	}
+
+	// The emitters follow the player's light
+	const glm::vec2 emitterPosition = glm::vec2(myCamera->GetPosition()) + myWindowSize * 0.5f;
+	for (const std::size_t emitterIndex : { mySparkEmitterIndex, mySmokeEmitterIndex })
+	{
+		ParticleEmitter& emitter = myParticleSystem->GetEmitter(emitterIndex);
+		emitter.myPositionX = emitterPosition.x;
+		emitter.myPositionY = emitterPosition.y;
+	}
+	myParticleSystem->Update(aDeltaTime);
+
 	myModelViewProjectionMatrix = myCamera->GetProjectionMatrix() * myCamera->GetViewMatrix() * myModelMatrix;
 }
 
 void Game::Draw() const
 {
-	glClear(GL_COLOR_BUFFER_BIT);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	glUseProgram(myShaderProgramIdentifier);
 
 	glUniformMatrix4fv(glGetUniformLocation(myShaderProgramIdentifier, "uModelViewProjection"), 1, GL_FALSE, glm::value_ptr(myModelViewProjectionMatrix));
 
+	if (myLightMap)
+	{
+		glActiveTexture(GL_TEXTURE2);
+		glBindTexture(GL_TEXTURE_2D, myLightMap->GetTextureIdentifier());
+	}
+
+	glUniform1i(glGetUniformLocation(myShaderProgramIdentifier, "uIsLit"), myIsLightingEnabled ? 1 : 0);
+
+	// Opaque tiles go front-to-back with depth writes so covered fragments are rejected before shading
+	glDisable(GL_BLEND);
+	glDepthMask(GL_TRUE);
+	for (std::vector<std::unique_ptr<MapLayer>>::const_reverse_iterator layer = myMapLayers.rbegin(); layer != myMapLayers.rend(); ++layer)
+		(*layer)->DrawOpaque();
+
+	// Transparent tiles go back-to-front on top, only testing against the opaque depth
+	glEnable(GL_BLEND);
+	glDepthMask(GL_FALSE);
 	for (const std::unique_ptr<MapLayer>& layer : myMapLayers)
-		layer->Draw();
+		layer->DrawTransparent();
 
-	glfwSwapBuffers(myGLFWWindow);
-	glfwPollEvents();
+	glDepthMask(GL_TRUE);
+
+	if (myParticleRenderer)
+		myParticleRenderer->Draw(*myParticleSystem, myModelViewProjectionMatrix);
 }
 
 void Game::LoadMap()
 {
-	const std::string filePath = FileUtility::ReadFile("Data/Settings.txt");
-	if (!FileUtility::Exists(filePath.c_str()))
+	VirtualFileSystem& fileSystem = VirtualFileSystem::GetInstance();
+	if (myMapFilePath.empty())
+		myMapFilePath = std::string(fileSystem.ReadFile("Data/Settings.txt"));
+
+	if (!fileSystem.GetExists(myMapFilePath))
+	{
+		printf("File does not exist: %s\n", myMapFilePath.c_str());
+
+		// Without a map the game still runs, with snapshots recording an empty tile table
+		myTileProperties = std::make_unique<TilePropertyTable>(std::vector<tmx::Tileset>(), 0, 0);
 		return;
+	}
 
+	// tmxlite only parses from a string, external tilesets it still reads from disk itself
 	tmx::Map map;
-	map.load(filePath);
+	map.loadFromString(std::string(fileSystem.ReadFile(myMapFilePath)), std::filesystem::path(myMapFilePath).parent_path().generic_string());
 
 	InitializeGL(map);
 
+	MemoryArena loadArena(GameParameters::ourLoadArenaBlockSize);
+	const int mapWidth = static_cast<int>(map.getTileCount().x);
+	const int mapHeight = static_cast<int>(map.getTileCount().y);
+	NavigationGrid navigationGrid(mapWidth, mapHeight);
+	myLightMap = std::make_unique<LightMap>(mapWidth, mapHeight);
+	myTileProperties = std::make_unique<TilePropertyTable>(map.getTilesets(), mapWidth, mapHeight);
+	myMapTileSize = glm::vec2(static_cast<float>(map.getTileSize().x), static_cast<float>(map.getTileSize().y));
+
+	// The start position suits one map, golden tests look at the bottom-left corner instead so any map is in view
+	if (myIsGoldenTest)
+	{
+		const tmx::FloatRect bounds = map.getBounds();
+		myCamera->SetPosition(glm::vec3(bounds.left, bounds.top + bounds.height - myWindowSize.y, 0.0f));
+	}
 	const std::vector<tmx::Layer::Ptr>& layers = map.getLayers();
 	for (unsigned int i = 0; i < layers.size(); ++i)
 	{
-		if (layers[i]->getType() == tmx::Layer::Type::Tile)
-			myMapLayers.emplace_back(std::make_unique<MapLayer>(map, i, myTileTextureIdentifiers));
+		if (layers[i]->getType() != tmx::Layer::Type::Tile)
+			continue;
+
+		// Map layers and tile table layers are added together, so they share indices
+		myMapLayers.emplace_back(std::make_unique<MapLayer>(map, i, myTilesetTextures, myOpaqueTiles, GameParameters::ourMapGeometryMode, myShaderProgramIdentifier, loadArena));
+		const std::size_t tileLayerIndex = myTileProperties->AddLayer(layers[i]->getLayerAs<tmx::TileLayer>());
+		myLightMap->AddOccludingLayer(*myTileProperties, tileLayerIndex);
+		if (GetIsCollisionLayer(*layers[i]))
+		{
+			navigationGrid.AddBlockingLayer(layers[i]->getLayerAs<tmx::TileLayer>());
+			myCollisionLayers.push_back(tileLayerIndex);
+		}
 	}
+
+	// Tiles with the bool "solid" property block movement on any layer
+	mySolidFlag = myTileProperties->GetFlag("solid");
+	navigationGrid.AddBlockingTiles(*myTileProperties, mySolidFlag);
+
+	myPathfindingService = std::make_unique<PathfindingService>(std::move(navigationGrid));
+	myPlayerLightIndex = myLightMap->AddLight({ 0, 0 }, GameParameters::ourLightRadius, GameParameters::ourLightIntensity);
+	// Placing the viewer sizes its buffers, here rather than on the frame lighting is first turned on
+	myLightMap->SetViewer({ 0, 0 }, GameParameters::ourViewRadius);
+
+	printf("Load arena high water mark: %zu of %zu bytes reserved\n", loadArena.GetHighWaterMark(), loadArena.GetReservedBytes());
 }
 
 void Game::InitializeGL(const tmx::Map& aMap)
@@ -181,15 +568,24 @@ void Game::InitializeGL(const tmx::Map& aMap)
 	glUseProgram(myShaderProgramIdentifier);
 
 	// We'll make sure the current tile texture is active in 0,
-	// and lookup texture is active in 1 in MapLayer::draw()
+	// and lookup texture is active in 1 in MapLayer::draw().
+	// The light map stays bound to 2 for the whole frame.
 	glUniform1i(glGetUniformLocation(myShaderProgramIdentifier, "uTileMap"), 0);
 	glUniform1i(glGetUniformLocation(myShaderProgramIdentifier, "uLookupMap"), 1);
+	glUniform1i(glGetUniformLocation(myShaderProgramIdentifier, "uLightMap"), 2);
+
+	LoadTextures(aMap.getTilesets());
 
-	const std::vector<tmx::Tileset>& tilesets = aMap.getTilesets();
-	for (const tmx::Tileset& tileset : tilesets)
-		LoadTexture(tileset.getImagePath());
+	// Sparks add up to a glow, smoke is blended over what's behind it
+	const std::vector<ParticleMaterial> particleMaterials = {
+		{ { 1.0f, 0.9f, 0.4f, 1.0f }, { 0.9f, 0.2f, 0.05f, 0.0f }, true },
+		{ { 0.4f, 0.4f, 0.4f, 0.5f }, { 0.2f, 0.2f, 0.2f, 0.0f }, false }
+	};
+	myParticleRenderer = std::make_unique<ParticleRenderer>(particleMaterials, myParticleSystem->GetCapacity());
 
 	glClearColor(0.6f, 0.8f, 0.92f, 1.0f);
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LESS);
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glBlendEquation(GL_FUNC_ADD);
@@ -200,10 +596,9 @@ void Game::LoadShader()
 	myShaderProgramIdentifier = glCreateProgram();
 	Shader vertexShader;
 	Shader fragmentShader;
-	const std::string vertexShaderData = FileUtility::ReadFile("Data/Shaders/VertexShader.glsl");
-	const std::string fragmentShaderData = FileUtility::ReadFile("Data/Shaders/FragmentShader.glsl");
-	vertexShader.AttachShader(myShaderProgramIdentifier, GL_VERTEX_SHADER, vertexShaderData.c_str());
-	fragmentShader.AttachShader(myShaderProgramIdentifier, GL_FRAGMENT_SHADER, fragmentShaderData.c_str());
+	VirtualFileSystem& fileSystem = VirtualFileSystem::GetInstance();
+	vertexShader.AttachShader(myShaderProgramIdentifier, GL_VERTEX_SHADER, fileSystem.ReadFile("Data/Shaders/VertexShader.glsl"));
+	fragmentShader.AttachShader(myShaderProgramIdentifier, GL_FRAGMENT_SHADER, fileSystem.ReadFile("Data/Shaders/FragmentShader.glsl"));
 
 	glLinkProgram(myShaderProgramIdentifier);
 
@@ -214,27 +609,175 @@ void Game::LoadShader()
 	glBindAttribLocation(myShaderProgramIdentifier, 1, "a_texCoord");
 }
 
-void Game::LoadTexture(const std::string& aFilepath)
+void Game::LoadTextures(const std::vector<tmx::Tileset>& someTilesets)
 {
-	myTileTextureIdentifiers.emplace_back(0);
-	unsigned int& textureIdentifier = myTileTextureIdentifiers.back();
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// Decoding is independent per tileset, only the uploads need to happen on this thread
+	std::vector<DecodedTexture> decodedTextures(someTilesets.size());
+	JobSystem::GetInstance().ParallelFor(someTilesets.size(), 1, [&someTilesets, &decodedTextures](std::size_t aBegin, std::size_t anEnd)
+	{
+		for (std::size_t i = aBegin; i < anEnd; ++i)
+			decodedTextures[i] = DecodeTexture(someTilesets[i]);
+	});
+
+	std::size_t cachedCount = 0;
+	for (const DecodedTexture& decodedTexture : decodedTextures)
+	{
+		cachedCount += decodedTexture.myCacheLevels.empty() ? 0 : 1;
+		LoadTexture(decodedTexture);
+	}
+
+	const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	printf("Loaded %zu tileset textures, %zu of them from baked caches, in %.2f ms\n", decodedTextures.size(), cachedCount, milliseconds);
+}
 
-	int width = 0;
-	int height = 0;
+Game::DecodedTexture Game::DecodeTexture(const tmx::Tileset& aTileset)
+{
+	DecodedTexture decodedTexture;
+
+	VirtualFileSystem& fileSystem = VirtualFileSystem::GetInstance();
+	const std::string& filepath = aTileset.getImagePath();
+	const std::string cachePath = TextureCache::GetCachePath(filepath);
+	if (fileSystem.GetExists(cachePath) && ReadTextureCache(aTileset, fileSystem.ReadFile(cachePath), decodedTexture))
+		return decodedTexture;
+
+	// Only decoded when there's no usable cache, a cache can be shipped without its image
+	const std::string_view encodedImage = fileSystem.ReadFile(filepath);
 	int numberOfChannels = 0;
-	unsigned char* data = stbi_load(aFilepath.c_str(), &width, &height, &numberOfChannels, 4);
-	if (!data)
+	decodedTexture.myPixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(encodedImage.data()), static_cast<int>(encodedImage.size()), &decodedTexture.myWidth, &decodedTexture.myHeight, &numberOfChannels, 4);
+	if (!decodedTexture.myPixels)
+	{
+		printf("Failed to load %s\n", filepath.c_str());
+		return decodedTexture;
+	}
+
+	const glm::vec2 size(static_cast<float>(decodedTexture.myWidth), static_cast<float>(decodedTexture.myHeight));
+	const glm::vec2 tileSize(static_cast<float>(aTileset.getTileSize().x), static_cast<float>(aTileset.getTileSize().y));
+	const float spacing = static_cast<float>(aTileset.getSpacing());
+	const unsigned int columns = std::max(aTileset.getColumnCount(), 1u);
+	TilesetTexture& tilesetTexture = decodedTexture.myTilesetTexture;
+	tilesetTexture.myTileCount = glm::vec2(static_cast<float>(columns), static_cast<float>((aTileset.getTileCount() + columns - 1) / columns));
+	tilesetTexture.myTileStride = (tileSize + spacing) / size;
+	tilesetTexture.myTileOrigin = glm::vec2(static_cast<float>(aTileset.getMargin())) / size;
+	tilesetTexture.myTileExtent = tileSize / size;
+
+	decodedTexture.myOpaqueTiles = GetOpaqueTiles(aTileset, decodedTexture.myPixels, decodedTexture.myWidth, decodedTexture.myHeight);
+	return decodedTexture;
+}
+
+bool Game::ReadTextureCache(const tmx::Tileset& aTileset, std::string_view aCache, DecodedTexture& aDecodedTexture)
+{
+	TextureCacheHeader header;
+	if (aCache.size() < sizeof(header))
+		return false;
+
+	std::memcpy(&header, aCache.data(), sizeof(header));
+
+	// Compared against the image like TextureBaker does, the size first since that doesn't need the image read.
+	// A cache shipped without its image is used as is.
+	VirtualFileSystem& fileSystem = VirtualFileSystem::GetInstance();
+	std::uint64_t imageSize = 0;
+	bool isImageChanged = false;
+	if (fileSystem.GetSize(aTileset.getImagePath(), imageSize))
 	{
-		printf("Failed to load %s\n", aFilepath.c_str());
+		const std::string_view image = imageSize == header.mySourceSize ? fileSystem.ReadFile(aTileset.getImagePath()) : std::string_view();
+		isImageChanged = image.size() != header.mySourceSize || TextureCache::GetSourceHash(image.data(), image.size()) != header.mySourceHash;
+	}
+
+	// A cache baked from another image or with other tile metrics is skipped, the image is decoded instead
+	const bool isMatching = std::memcmp(header.myMagic, TextureCache::ourMagic, sizeof(header.myMagic)) == 0
+		&& header.myVersion == TextureCache::ourVersion
+		&& header.myFormat <= static_cast<std::uint32_t>(TextureCache::Format::BC7)
+		&& header.myLevelCount > 0
+		&& header.myTileWidth == aTileset.getTileSize().x
+		&& header.myTileHeight == aTileset.getTileSize().y
+		&& header.myColumnCount == aTileset.getColumnCount()
+		&& header.myTileCount == aTileset.getTileCount()
+		&& !isImageChanged;
+	if (!isMatching)
+	{
+		printf("Ignoring stale texture cache %s\n", TextureCache::GetCachePath(aTileset.getImagePath()).c_str());
+		return false;
+	}
+
+	const std::size_t levelTableEnd = sizeof(header) + header.myLevelCount * sizeof(TextureCacheLevel);
+	const std::size_t opaqueWordCount = (header.myTileCount + 31) / 32;
+	if (aCache.size() < levelTableEnd + opaqueWordCount * sizeof(std::uint32_t))
+		return false;
+
+	std::vector<TextureCacheLevel> levels(header.myLevelCount);
+	std::memcpy(levels.data(), aCache.data() + sizeof(header), levels.size() * sizeof(TextureCacheLevel));
+	for (const TextureCacheLevel& level : levels)
+	{
+		if (level.myDataOffset > aCache.size() || level.mySize > aCache.size() - level.myDataOffset)
+			return false;
+	}
+
+	std::vector<std::uint32_t> opaqueWords(opaqueWordCount);
+	std::memcpy(opaqueWords.data(), aCache.data() + levelTableEnd, opaqueWords.size() * sizeof(std::uint32_t));
+	aDecodedTexture.myOpaqueTiles.resize(header.myTileCount);
+	for (std::uint32_t tileIndex = 0; tileIndex < header.myTileCount; ++tileIndex)
+		aDecodedTexture.myOpaqueTiles[tileIndex] = (opaqueWords[tileIndex / 32] >> (tileIndex % 32)) & 1u;
+
+	const glm::vec2 size(static_cast<float>(header.myWidth), static_cast<float>(header.myHeight));
+	TilesetTexture& tilesetTexture = aDecodedTexture.myTilesetTexture;
+	tilesetTexture.myTileCount = glm::vec2(static_cast<float>(header.myColumnCount), static_cast<float>(header.myRowCount));
+	tilesetTexture.myTileStride = glm::vec2(static_cast<float>(header.myCellWidth), static_cast<float>(header.myCellHeight)) / size;
+	tilesetTexture.myTileOrigin = glm::vec2(static_cast<float>(header.myGutter)) / size;
+	tilesetTexture.myTileExtent = glm::vec2(static_cast<float>(header.myTileWidth), static_cast<float>(header.myTileHeight)) / size;
+
+	aDecodedTexture.myCacheLevels = std::move(levels);
+	aDecodedTexture.myCache = aCache;
+	aDecodedTexture.myIsCompressed = header.myFormat == static_cast<std::uint32_t>(TextureCache::Format::BC7);
+	aDecodedTexture.myWidth = static_cast<int>(header.myWidth);
+	aDecodedTexture.myHeight = static_cast<int>(header.myHeight);
+	return true;
+}
+
+void Game::LoadTexture(const DecodedTexture& aDecodedTexture)
+{
+	myTilesetTextures.emplace_back(aDecodedTexture.myTilesetTexture);
+	unsigned int& textureIdentifier = myTilesetTextures.back().myTextureIdentifier;
+	myOpaqueTiles.emplace_back(aDecodedTexture.myOpaqueTiles);
+
+	if (!aDecodedTexture.myCacheLevels.empty())
+	{
+		glGenTextures(1, &textureIdentifier);
+		glBindTexture(GL_TEXTURE_2D, textureIdentifier);
+
+		// Baked levels are uploaded straight from the file, block compressed ones stay compressed on the GPU
+		for (std::size_t i = 0; i < aDecodedTexture.myCacheLevels.size(); ++i)
+		{
+			const TextureCacheLevel& level = aDecodedTexture.myCacheLevels[i];
+			const void* data = aDecodedTexture.myCache.data() + level.myDataOffset;
+			const GLint levelIndex = static_cast<GLint>(i);
+			if (aDecodedTexture.myIsCompressed)
+				glCompressedTexImage2D(GL_TEXTURE_2D, levelIndex, GL_COMPRESSED_RGBA_BPTC_UNORM, static_cast<GLsizei>(level.myWidth), static_cast<GLsizei>(level.myHeight), 0, static_cast<GLsizei>(level.mySize), data);
+			else
+				glTexImage2D(GL_TEXTURE_2D, levelIndex, GL_RGBA8, static_cast<GLsizei>(level.myWidth), static_cast<GLsizei>(level.myHeight), 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		}
+
+		// Every tile has its own gutter to filter into, so nothing needs to wrap
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(aDecodedTexture.myCacheLevels.size() - 1));
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		glBindTexture(GL_TEXTURE_2D, 0);
 		return;
 	}
 
+	if (!aDecodedTexture.myPixels)
+		return;
+
 	glGenTextures(1, &textureIdentifier);
 	glBindTexture(GL_TEXTURE_2D, textureIdentifier);
 
-	const GLint internalformat = numberOfChannels == 3 ? GL_RGB : GL_RGBA;
-	const GLenum format = numberOfChannels == 3 ? GL_RGB : GL_RGBA;
-	glTexImage2D(GL_TEXTURE_2D, 0, internalformat, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+	// stbi_load always expands to four channels since we requested them
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, aDecodedTexture.myWidth, aDecodedTexture.myHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, aDecodedTexture.myPixels);
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -243,7 +786,166 @@ void Game::LoadTexture(const std::string& aFilepath)
 
 	glBindTexture(GL_TEXTURE_2D, 0);
 
-	stbi_image_free(data);
+	stbi_image_free(aDecodedTexture.myPixels);
+}
+
+std::vector<bool> Game::GetOpaqueTiles(const tmx::Tileset& aTileset, const unsigned char* someRGBAPixels, int aWidth, int aHeight)
+{
+	const tmx::Vector2u& tileSize = aTileset.getTileSize();
+	const unsigned int columns = aTileset.getColumnCount();
+	const unsigned int spacing = aTileset.getSpacing();
+	const unsigned int margin = aTileset.getMargin();
+
+	std::vector<bool> opaqueTiles(aTileset.getTileCount(), false);
+	if (columns == 0)
+		return opaqueTiles;
+
+	for (unsigned int tileIndex = 0; tileIndex < aTileset.getTileCount(); ++tileIndex)
+	{
+		const unsigned int left = margin + (tileIndex % columns) * (tileSize.x + spacing);
+		const unsigned int top = margin + (tileIndex / columns) * (tileSize.y + spacing);
+		if (left + tileSize.x > static_cast<unsigned int>(aWidth) || top + tileSize.y > static_cast<unsigned int>(aHeight))
+			continue;
+
+		bool isOpaque = true;
+		for (unsigned int y = top; y < top + tileSize.y && isOpaque; ++y)
+		{
+			const unsigned char* row = someRGBAPixels + (static_cast<std::size_t>(y) * aWidth + left) * 4;
+			for (unsigned int x = 0; x < tileSize.x; ++x)
+			{
+				if (row[x * 4 + 3] != 255)
+				{
+					isOpaque = false;
+					break;
+				}
+			}
+		}
+
+		opaqueTiles[tileIndex] = isOpaque;
+	}
+
+	return opaqueTiles;
+}
+
+void Game::MovePlayer(const glm::vec3& aMovement)
+{
+	if (!myPathfindingService)
+	{
+		myCamera->SetPosition(myCamera->GetPosition() + aMovement);
+		return;
+	}
+
+	// The player stands at the middle of the screen and is stopped by the cells the navigation grid blocks.
+	// Axes move one at a time so it slides along walls, and stepping out of a blocked cell or off the map is always allowed.
+	const NavigationGrid& grid = myPathfindingService->GetGrid();
+	const auto getIsBlocked = [&grid](GridPoint aTile) { return grid.GetBounds().GetContains(aTile.myX, aTile.myY) && !grid.GetIsWalkable(aTile.myX, aTile.myY); };
+
+	glm::vec3 position = myCamera->GetPosition();
+	for (const glm::vec3& axisMovement : { glm::vec3(aMovement.x, 0.0f, 0.0f), glm::vec3(0.0f, aMovement.y, 0.0f) })
+	{
+		const GridPoint currentTile = GetPlayerTile(position);
+		const GridPoint targetTile = GetPlayerTile(position + axisMovement);
+		if (targetTile == currentTile || getIsBlocked(currentTile) || !getIsBlocked(targetTile))
+			position += axisMovement;
+	}
+
+	myCamera->SetPosition(position);
+}
+
+GridPoint Game::GetPlayerTile(const glm::vec3& aCameraPosition) const
+{
+	const glm::vec2 center = glm::vec2(aCameraPosition) + myWindowSize * 0.5f;
+	return { static_cast<int>(std::floor(center.x / myMapTileSize.x)), static_cast<int>(std::floor(center.y / myMapTileSize.y)) };
+}
+
+void Game::SetTile(std::size_t aLayerIndex, GridPoint aTile, std::uint32_t aGID)
+{
+	if (aLayerIndex >= myMapLayers.size() || myTileProperties->GetGID(aLayerIndex, aTile.myX, aTile.myY) == aGID)
+		return;
+
+	myTileProperties->SetGID(aLayerIndex, aTile.myX, aTile.myY, aGID);
+	myEditedChunkGIDs.resize(myTileProperties->GetEditedChunks().size() * TilePropertyTable::ourChunkTileCount);
+	RefreshTile(aLayerIndex, aTile);
+}
+
+void Game::RefreshTile(std::size_t aLayerIndex, GridPoint aTile)
+{
+	if (aLayerIndex >= myMapLayers.size() || aTile.myX < 0 || aTile.myY < 0 || aTile.myX >= myTileProperties->GetWidth() || aTile.myY >= myTileProperties->GetHeight())
+		return;
+
+	// The layer's geometry and pathfinding's abstraction are rebuilt once a frame by ApplyTileEdits
+	myMapLayers[aLayerIndex]->MarkDirty({ aTile.myX, aTile.myY, aTile.myX + 1, aTile.myY + 1 });
+	myLightMap->RefreshOpacity(*myTileProperties, aTile.myX, aTile.myY);
+
+	bool isBlocked = myTileProperties->GetHasAnyFlag(aTile.myX, aTile.myY, mySolidFlag);
+	for (const std::size_t collisionLayer : myCollisionLayers)
+		isBlocked |= myTileProperties->GetGID(collisionLayer, aTile.myX, aTile.myY) != 0;
+
+	myPathfindingService->SetIsWalkable(aTile.myX, aTile.myY, !isBlocked);
+	myHasTileEdits = true;
+}
+
+void Game::RefreshRestoredTiles()
+{
+	const std::vector<std::uint32_t>& editedChunks = myTileProperties->GetEditedChunks();
+	std::array<std::uint32_t, TilePropertyTable::ourChunkTileCount> gids;
+	for (std::size_t i = 0; i < editedChunks.size(); ++i)
+	{
+		myTileProperties->ReadChunk(editedChunks[i], gids.data());
+		const std::uint32_t* const previousGIDs = &myEditedChunkGIDs[i * TilePropertyTable::ourChunkTileCount];
+		const std::size_t layerIndex = myTileProperties->GetChunkLayer(editedChunks[i]);
+		const GridRect rect = myTileProperties->GetChunkRect(editedChunks[i]);
+		for (int y = rect.myTop; y < rect.myBottom; ++y)
+		{
+			for (int x = rect.myLeft; x < rect.myRight; ++x)
+			{
+				const std::size_t cell = static_cast<std::size_t>(y - rect.myTop) * TilePropertyTable::ourChunkSize + (x - rect.myLeft);
+				if (gids[cell] != previousGIDs[cell])
+					RefreshTile(layerIndex, { x, y });
+			}
+		}
+	}
+}
+
+void Game::ApplyTileEdits()
+{
+	if (!myHasTileEdits)
+		return;
+
+	for (std::size_t i = 0; i < myMapLayers.size(); ++i)
+		myMapLayers[i]->Update(*myTileProperties, i);
+
+	myPathfindingService->UpdateAbstraction();
+}
+
+bool Game::GetIsCollisionLayer(const tmx::Layer& aLayer)
+{
+	for (const tmx::Property& property : aLayer.getProperties())
+	{
+		if (property.getName() == "collision" && property.getType() == tmx::Property::Type::Boolean)
+			return property.getBoolValue();
+	}
+
+	return false;
+}
+
+void Game::OnFramebufferResized(int aWidth, int aHeight)
+{
+	// Minimizing reports an empty framebuffer, keep everything as is until it's restored
+	myIsMinimized = aWidth == 0 || aHeight == 0;
+	if (myIsMinimized)
+		return;
+
+	myWindowSize = glm::vec2(static_cast<float>(aWidth), static_cast<float>(aHeight));
+	myCamera->SetViewportSize(myWindowSize);
+	myRenderTarget->Resize(aWidth, aHeight);
+	myFrameCapture->Resize(aWidth, aHeight);
+}
+
+void Game::FramebufferSizeCallback(GLFWwindow* aWindow, int aWidth, int aHeight)
+{
+	if (Game* game = static_cast<Game*>(glfwGetWindowUserPointer(aWindow)))
+		game->OnFramebufferResized(aWidth, aHeight);
 }
 
 void Game::KeyCallback(GLFWwindow* aWindow, int aKey, int aScancode, int anAction, int aMode)
@@ -1,15 +1,30 @@
 #pragma once
 
+#include "EntityStore.hpp"
+#include "FrameAllocator.hpp"
 #include "MapLayer.hpp"
+#include "TextureCache.hpp"
 
 #include <glm/matrix.hpp>
 
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 struct GLFWwindow;
 class Camera;
+class FrameCapture;
+class FramePacer;
+class RenderTarget;
+class ResolutionScaler;
+class SnapshotRing;
+class LightMap;
+class ParticleRenderer;
+class ParticleSystem;
+class PathfindingService;
+class TilePropertyTable;
+struct GridPoint;
 
 class Game final
 {
@@ -20,22 +35,99 @@ public:
 	void Initialize();
 	void Run();
 
+	// Overrides the map named in Data/Settings.txt
+	void SetMapFilePath(const std::string& aFilePath) { myMapFilePath = aFilePath; }
+	// Compares a frame against Data/Goldens/<map name>.png and closes once the result is in
+	void SetIsGoldenTest(bool anIsGoldenTest) { myIsGoldenTest = anIsGoldenTest; }
+	// Writes the frame of a golden test as its golden image instead of comparing against it
+	void SetIsUpdatingGoldens(bool anIsUpdatingGoldens) { myIsUpdatingGoldens = anIsUpdatingGoldens; }
+	std::size_t GetFailedComparisonCount() const;
+
 private:
+	struct DecodedTexture
+	{
+		DecodedTexture();
+
+		std::vector<bool> myOpaqueTiles;
+		// Levels of a baked texture in myCache, empty when the image was decoded into myPixels instead
+		std::vector<TextureCacheLevel> myCacheLevels;
+		std::string_view myCache;
+		TilesetTexture myTilesetTexture;
+		bool myIsCompressed;
+		unsigned char* myPixels;
+		int myWidth;
+		int myHeight;
+	};
+
 	void Update(const float aDeltaTime);
 	void Draw() const;
+	void MovePlayer(const glm::vec3& aMovement);
+	GridPoint GetPlayerTile(const glm::vec3& aCameraPosition) const;
+	// Every tile edit goes through here, so the tile table, the layer's geometry, the light map and pathfinding agree
+	void SetTile(std::size_t aLayerIndex, GridPoint aTile, std::uint32_t aGID);
+	// Catches everything that reads the tile table up with the cell as the table holds it now
+	void RefreshTile(std::size_t aLayerIndex, GridPoint aTile);
+	void ApplyTileEdits();
+	// Refreshes the cells a snapshot restore changed, comparing edited chunks against myEditedChunkGIDs
+	void RefreshRestoredTiles();
 	void LoadMap();
 	void InitializeGL(const tmx::Map& aMap);
 	void LoadShader();
-	void LoadTexture(const std::string& aFilepath);
+	void LoadTextures(const std::vector<tmx::Tileset>& someTilesets);
+	void LoadTexture(const DecodedTexture& aDecodedTexture);
+	static DecodedTexture DecodeTexture(const tmx::Tileset& aTileset);
+	static bool ReadTextureCache(const tmx::Tileset& aTileset, std::string_view aCache, DecodedTexture& aDecodedTexture);
+	static std::vector<bool> GetOpaqueTiles(const tmx::Tileset& aTileset, const unsigned char* someRGBAPixels, int aWidth, int aHeight);
+	static bool GetIsCollisionLayer(const tmx::Layer& aLayer);
+	void OnFramebufferResized(int aWidth, int aHeight);
+	static void FramebufferSizeCallback(GLFWwindow* aWindow, int aWidth, int aHeight);
 	static void KeyCallback(GLFWwindow* aWindow, int aKey, int aScancode, int anAction, int aMode);
 	static void PrintDebugInfo();
 
 	std::vector<std::unique_ptr<MapLayer>> myMapLayers;
-	std::vector<unsigned int> myTileTextureIdentifiers;
+	std::vector<TilesetTexture> myTilesetTextures;
+	std::vector<std::vector<bool>> myOpaqueTiles;
+	// Tile table layers whose tiles block movement
+	std::vector<std::size_t> myCollisionLayers;
+	// The edited chunks' GIDs from before a restore, grown as chunks are first edited
+	std::vector<std::uint32_t> myEditedChunkGIDs;
+	FrameAllocator myFrameAllocator;
+	EntityStore myEntityStore;
+	std::unique_ptr<PathfindingService> myPathfindingService;
+	std::unique_ptr<TilePropertyTable> myTileProperties;
+	std::unique_ptr<LightMap> myLightMap;
+	std::unique_ptr<FrameCapture> myFrameCapture;
+	std::unique_ptr<RenderTarget> myRenderTarget;
+	std::unique_ptr<ResolutionScaler> myResolutionScaler;
+	std::unique_ptr<FramePacer> myFramePacer;
+	std::unique_ptr<SnapshotRing> mySnapshotRing;
+	std::unique_ptr<ParticleSystem> myParticleSystem;
+	std::unique_ptr<ParticleRenderer> myParticleRenderer;
+	std::string myMapFilePath;
+	std::size_t myPlayerLightIndex;
+	std::size_t mySparkEmitterIndex;
+	std::size_t mySmokeEmitterIndex;
+	std::uint64_t mySolidFlag;
+	std::uint32_t myHeldGID;
 	glm::mat4 myModelMatrix;
 	glm::mat4 myModelViewProjectionMatrix;
 	glm::vec2 myWindowSize;
+	glm::vec2 myMapTileSize;
 	GLFWwindow* myGLFWWindow;
 	Camera* myCamera;
 	unsigned int myShaderProgramIdentifier;
+	unsigned int myScreenshotCount;
+	std::uint32_t mySimulationTick;
+	bool myIsGoldenTest;
+	bool myIsUpdatingGoldens;
+	bool myIsMinimized;
+	bool myHasTileEdits;
+	bool myIsLightingEnabled;
+	bool myWasScreenshotKeyDown;
+	bool myWasPacingKeyDown;
+	bool myWasGPUWaitKeyDown;
+	bool myWasRewindKeyDown;
+	bool myWasParticleKeyDown;
+	bool myWasEditKeyDown;
+	bool myWasLightingKeyDown;
 };
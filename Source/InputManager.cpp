@@ -2,14 +2,17 @@
 
 #include <GLFW/glfw3.h>
 
-#include <algorithm>
 
 InputManager::InputManager()
 	: myCursorXPosition(0.0f)
 	, myCursorYPosition(0.0f)
 	, myScrollXOffset(0.0f)
 	, myScrollYOffset(0.0f)
+	, myPreviousPollTime(std::chrono::steady_clock::now())
+	, myHasPendingEvent(false)
 {
+	myKeys.fill(false);
+	myMouseButtons.fill(false);
 }
 
 InputManager::~InputManager()
@@ -18,25 +21,33 @@ InputManager::~InputManager()
 
 bool InputManager::GetIsKeyDown(Key aKey) const
 {
-	std::map<Key, bool>::const_iterator iterator = myKeys.find(aKey);
-	if (iterator == myKeys.end())
-		return false;
-
-	return iterator->second;
+	return myKeys[static_cast<std::size_t>(aKey)];
 }
 
 bool InputManager::GetIsMouseButtonDown(MouseButtons aMouseButton) const
 {
-	std::map<MouseButtons, bool>::const_iterator iterator = myMouseButtons.find(aMouseButton);
-	if (iterator == myMouseButtons.end())
+	return myMouseButtons[static_cast<std::size_t>(aMouseButton)];
+}
+
+bool InputManager::PopEventTime(std::chrono::steady_clock::time_point& anEventTime)
+{
+	if (!myHasPendingEvent)
 		return false;
 
-	return iterator->second;
+	anEventTime = myOldestEventTime;
+	myHasPendingEvent = false;
+	return true;
+}
+
+void InputManager::OnEventsPolled()
+{
+	myPreviousPollTime = std::chrono::steady_clock::now();
 }
 
 void InputManager::OnKeyAction(int aKey, int /*aScancode*/, bool aIsKeyDown, int /*aMode*/)
 {
-	myKeys[GetTranslatedKey(aKey)] = aIsKeyDown;
+	RecordEvent();
+	myKeys[static_cast<std::size_t>(GetTranslatedKey(aKey))] = aIsKeyDown;
 }
 
 void InputManager::OnCursorAction(double aXPosition, double aYPosition)
@@ -53,7 +64,19 @@ void InputManager::OnScrollAction(double aXOffset, double aYOffset)
 
 void InputManager::OnMouseButtonAction(int aButton, int anAction, int /*aModifier*/)
 {
-	myMouseButtons[GetTranslatedMouseButton(aButton)] = anAction;
+	RecordEvent();
+	myMouseButtons[static_cast<std::size_t>(GetTranslatedMouseButton(aButton))] = anAction != GLFW_RELEASE;
+}
+
+void InputManager::RecordEvent()
+{
+	if (myHasPendingEvent)
+		return;
+
+	// Events are only delivered while polling, so the callback's own time would hide however long the event
+	// sat queued behind frame pacing. It can have arrived any time after the previous poll, assume the earliest.
+	myOldestEventTime = myPreviousPollTime;
+	myHasPendingEvent = true;
 }
 
 Key InputManager::GetTranslatedKey(int aKey) const
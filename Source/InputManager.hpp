@@ -1,6 +1,8 @@
 #pragma once
 
-#include <map>
+#include <array>
+#include <chrono>
+#include <cstddef>
 
 enum class Key
 {
@@ -122,7 +124,8 @@ enum class Key
 	RightControl,
 	RightAlt,
 	RightSuper,
-	Menu
+	Menu,
+	Count
 };
 
 enum class MouseButtons
@@ -130,7 +133,8 @@ enum class MouseButtons
 	Undefined,
 	Left,
 	Right,
-	Middle
+	Middle,
+	Count
 };
 
 class InputManager
@@ -153,6 +157,11 @@ public:
 	bool GetIsKeyDown(Key aKey) const;
 	bool GetIsMouseButtonDown(MouseButtons aMouseButton) const;
 
+	// Hands out the earliest the oldest key or button event since the last call can have arrived, for latency measurements
+	bool PopEventTime(std::chrono::steady_clock::time_point& anEventTime);
+	// Call after every poll for events, events delivered by the next poll are dated back to it
+	void OnEventsPolled();
+
 	float myCursorXPosition;
 	float myCursorYPosition;
 	float myScrollXOffset;
@@ -164,8 +173,12 @@ private:
 
 	Key GetTranslatedKey(int aKey) const;
 	MouseButtons GetTranslatedMouseButton(int aButton) const;
+	void RecordEvent();
 
 private:
-	std::map<Key, bool> myKeys;
-	std::map<MouseButtons, bool> myMouseButtons;
+	std::array<bool, static_cast<std::size_t>(Key::Count)> myKeys;
+	std::array<bool, static_cast<std::size_t>(MouseButtons::Count)> myMouseButtons;
+	std::chrono::steady_clock::time_point myOldestEventTime;
+	std::chrono::steady_clock::time_point myPreviousPollTime;
+	bool myHasPendingEvent;
 };
@@ -0,0 +1,337 @@
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace JobSystemParameters
+{
+	static constexpr std::size_t ourJobPoolSize = 4096;
+	static constexpr std::size_t ourMaxJobsPerParallelFor = ourJobPoolSize / 4;
+	static constexpr std::chrono::milliseconds ourIdleTimeout = std::chrono::milliseconds(1);
+}
+
+// Threads the system didn't start, other than the one that created it, share a locked queue and job pool
+static constexpr std::size_t ourForeignWorkerIndex = static_cast<std::size_t>(-1);
+static thread_local std::size_t ourWorkerIndex = ourForeignWorkerIndex;
+
+JobSystem::Job::Job()
+	: myRangeFunction(nullptr)
+	, myRangeBegin(0)
+	, myRangeEnd(0)
+	, myParent(nullptr)
+	, myUnfinishedJobs(0)
+	, myGeneration(0)
+{}
+
+JobSystem::Worker::Worker()
+	: myQueue(std::make_unique<Job*[]>(JobSystemParameters::ourJobPoolSize))
+	, myQueueFront(0)
+	, myQueueSize(0)
+	, myJobPool(std::make_unique<Job[]>(JobSystemParameters::ourJobPoolSize))
+	, myNextJobIndex(0)
+	, myExecutedJobs(0)
+	, myStolenJobs(0)
+	, myIdleNanoseconds(0)
+{}
+
+JobSystem::JobSystem()
+	: myQueuedJobs(0)
+	, myIsRunning(true)
+{
+	const std::size_t workerCount = std::max(std::thread::hardware_concurrency(), 1u);
+	for (std::size_t i = 0; i < workerCount; ++i)
+		myWorkers.emplace_back(std::make_unique<Worker>());
+
+	// Worker 0 is the calling thread
+	ourWorkerIndex = 0;
+	for (std::size_t i = 1; i < workerCount; ++i)
+		myWorkers[i]->myThread = std::thread(&JobSystem::WorkerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(myWakeMutex);
+		myIsRunning = false;
+	}
+	myWakeCondition.notify_all();
+
+	for (const std::unique_ptr<Worker>& worker : myWorkers)
+	{
+		if (worker->myThread.joinable())
+			worker->myThread.join();
+	}
+}
+
+JobSystem::JobHandle JobSystem::CreateJob(JobFunction aFunction)
+{
+	Job* job = AllocateJob();
+	job->myFunction = std::move(aFunction);
+	job->myRangeFunction = nullptr;
+	job->myParent = nullptr;
+	job->myUnfinishedJobs = 1;
+	return { job, job->myGeneration.load() };
+}
+
+JobSystem::JobHandle JobSystem::CreateChildJob(const JobHandle& aParent, JobFunction aFunction)
+{
+	// Only a parent that hasn't run yet can take children, so its slot is still the one the handle refers to
+	aParent.myJob->myUnfinishedJobs.fetch_add(1);
+
+	Job* job = AllocateJob();
+	job->myFunction = std::move(aFunction);
+	job->myRangeFunction = nullptr;
+	job->myParent = aParent.myJob;
+	job->myUnfinishedJobs = 1;
+	return { job, job->myGeneration.load() };
+}
+
+JobSystem::Job* JobSystem::CreateRangeJob(Job* aParent, const RangeFunction& aFunction, std::size_t aBegin, std::size_t anEnd)
+{
+	aParent->myUnfinishedJobs.fetch_add(1);
+
+	// Range jobs refer to the caller's function instead of wrapping it, so they never allocate
+	Job* job = AllocateJob();
+	job->myFunction = nullptr;
+	job->myRangeFunction = &aFunction;
+	job->myRangeBegin = aBegin;
+	job->myRangeEnd = anEnd;
+	job->myParent = aParent;
+	job->myUnfinishedJobs = 1;
+	return job;
+}
+
+void JobSystem::Run(const JobHandle& aJob)
+{
+	Push(aJob.myJob);
+}
+
+void JobSystem::Push(Job* aJob)
+{
+	Worker& worker = GetWorker(ourWorkerIndex);
+	{
+		std::lock_guard<std::mutex> lock(worker.myQueueMutex);
+		if (worker.myQueueSize < JobSystemParameters::ourJobPoolSize)
+		{
+			worker.myQueue[(worker.myQueueFront + worker.myQueueSize) & (JobSystemParameters::ourJobPoolSize - 1)] = aJob;
+			++worker.myQueueSize;
+			aJob = nullptr;
+		}
+	}
+
+	// A full queue means we're better off doing the work right away
+	if (aJob)
+	{
+		Execute(aJob, ourWorkerIndex);
+		return;
+	}
+
+	myQueuedJobs.fetch_add(1);
+	myWakeCondition.notify_one();
+}
+
+void JobSystem::Wait(const JobHandle& aJob)
+{
+	const std::size_t workerIndex = ourWorkerIndex;
+	while (!GetIsFinished(aJob))
+	{
+		if (Job* job = GetJob(workerIndex))
+		{
+			Execute(job, workerIndex);
+		}
+		else
+		{
+			const std::chrono::steady_clock::time_point idleStart = std::chrono::steady_clock::now();
+			std::this_thread::yield();
+			const std::chrono::nanoseconds idleTime = std::chrono::steady_clock::now() - idleStart;
+			GetWorker(workerIndex).myIdleNanoseconds.fetch_add(static_cast<std::uint64_t>(idleTime.count()));
+		}
+	}
+}
+
+bool JobSystem::GetIsFinished(const JobHandle& aJob) const
+{
+	// Checked in this order so a slot freed and claimed again in between still reads as finished
+	return aJob.myJob->myUnfinishedJobs.load() == 0 || aJob.myJob->myGeneration.load() != aJob.myGeneration;
+}
+
+void JobSystem::ParallelFor(std::size_t aCount, std::size_t aGrainSize, const RangeFunction& aFunction)
+{
+	if (aCount == 0)
+		return;
+
+	// Keep the number of chunks well within the job pool
+	const std::size_t minimumGrainSize = (aCount + JobSystemParameters::ourMaxJobsPerParallelFor - 1) / JobSystemParameters::ourMaxJobsPerParallelFor;
+	const std::size_t grainSize = std::max({ aGrainSize, minimumGrainSize, static_cast<std::size_t>(1) });
+	if (aCount <= grainSize || myWorkers.size() == 1)
+	{
+		aFunction(0, aCount);
+		return;
+	}
+
+	const JobHandle root = CreateJob(nullptr);
+	for (std::size_t begin = 0; begin < aCount; begin += grainSize)
+	{
+		const std::size_t end = std::min(begin + grainSize, aCount);
+		Push(CreateRangeJob(root.myJob, aFunction, begin, end));
+	}
+
+	Run(root);
+	Wait(root);
+}
+
+std::vector<JobSystem::WorkerStatistics> JobSystem::GetStatistics() const
+{
+	std::vector<WorkerStatistics> statistics;
+	statistics.reserve(myWorkers.size());
+	for (const std::unique_ptr<Worker>& worker : myWorkers)
+		statistics.push_back({ worker->myExecutedJobs.load(), worker->myStolenJobs.load(), worker->myIdleNanoseconds.load() });
+
+	return statistics;
+}
+
+void JobSystem::ResetStatistics()
+{
+	for (const std::unique_ptr<Worker>& worker : myWorkers)
+	{
+		worker->myExecutedJobs = 0;
+		worker->myStolenJobs = 0;
+		worker->myIdleNanoseconds = 0;
+	}
+}
+
+void JobSystem::PrintStatistics() const
+{
+	const std::vector<WorkerStatistics> statistics = GetStatistics();
+	for (std::size_t i = 0; i < statistics.size(); ++i)
+	{
+		printf("Worker %zu: %llu jobs, %llu stolen, %.2f ms idle\n",
+			i,
+			static_cast<unsigned long long>(statistics[i].myExecutedJobs),
+			static_cast<unsigned long long>(statistics[i].myStolenJobs),
+			static_cast<double>(statistics[i].myIdleNanoseconds) / 1000000.0);
+	}
+}
+
+void JobSystem::WorkerLoop(std::size_t aWorkerIndex)
+{
+	ourWorkerIndex = aWorkerIndex;
+	Worker& worker = *myWorkers[aWorkerIndex];
+
+	while (myIsRunning)
+	{
+		if (Job* job = GetJob(aWorkerIndex))
+		{
+			Execute(job, aWorkerIndex);
+			continue;
+		}
+
+		const std::chrono::steady_clock::time_point idleStart = std::chrono::steady_clock::now();
+		{
+			std::unique_lock<std::mutex> lock(myWakeMutex);
+			myWakeCondition.wait_for(lock, JobSystemParameters::ourIdleTimeout, [this]() { return !myIsRunning || myQueuedJobs.load() > 0; });
+		}
+		const std::chrono::nanoseconds idleTime = std::chrono::steady_clock::now() - idleStart;
+		worker.myIdleNanoseconds.fetch_add(static_cast<std::uint64_t>(idleTime.count()));
+	}
+}
+
+JobSystem::Job* JobSystem::AllocateJob()
+{
+	Worker& worker = GetWorker(ourWorkerIndex);
+	while (true)
+	{
+		for (std::size_t attempt = 0; attempt < JobSystemParameters::ourJobPoolSize; ++attempt)
+		{
+			const std::size_t index = worker.myNextJobIndex.fetch_add(1) & (JobSystemParameters::ourJobPoolSize - 1);
+			Job& job = worker.myJobPool[index];
+
+			// Claimed rather than just checked, foreign threads allocate from the same pool
+			int unfinishedJobs = 0;
+			if (job.myUnfinishedJobs.compare_exchange_strong(unfinishedJobs, 1))
+			{
+				job.myGeneration.fetch_add(1);
+				return &job;
+			}
+		}
+
+		// Every slot is still in flight, help out until one frees up
+		if (Job* pendingJob = GetJob(ourWorkerIndex))
+			Execute(pendingJob, ourWorkerIndex);
+		else
+			std::this_thread::yield();
+	}
+}
+
+JobSystem::Job* JobSystem::GetJob(std::size_t aWorkerIndex)
+{
+	if (myQueuedJobs.load() == 0)
+		return nullptr;
+
+	{
+		Worker& worker = GetWorker(aWorkerIndex);
+		std::lock_guard<std::mutex> lock(worker.myQueueMutex);
+		if (worker.myQueueSize > 0)
+		{
+			--worker.myQueueSize;
+			Job* job = worker.myQueue[(worker.myQueueFront + worker.myQueueSize) & (JobSystemParameters::ourJobPoolSize - 1)];
+			myQueuedJobs.fetch_sub(1);
+			return job;
+		}
+	}
+
+	// Steal the oldest job from another worker, starting next to ourselves to spread contention
+	const bool isForeign = aWorkerIndex == ourForeignWorkerIndex;
+	for (std::size_t offset = isForeign ? 0 : 1; offset < myWorkers.size(); ++offset)
+	{
+		const std::size_t victimIndex = isForeign ? offset : (aWorkerIndex + offset) % myWorkers.size();
+		if (Job* job = StealJob(*myWorkers[victimIndex], aWorkerIndex))
+			return job;
+	}
+
+	if (!isForeign)
+		return StealJob(myForeignWorker, aWorkerIndex);
+
+	return nullptr;
+}
+
+JobSystem::Job* JobSystem::StealJob(Worker& aVictim, std::size_t aWorkerIndex)
+{
+	std::lock_guard<std::mutex> lock(aVictim.myQueueMutex);
+	if (aVictim.myQueueSize == 0)
+		return nullptr;
+
+	Job* job = aVictim.myQueue[aVictim.myQueueFront];
+	aVictim.myQueueFront = (aVictim.myQueueFront + 1) & (JobSystemParameters::ourJobPoolSize - 1);
+	--aVictim.myQueueSize;
+	myQueuedJobs.fetch_sub(1);
+	GetWorker(aWorkerIndex).myStolenJobs.fetch_add(1);
+	return job;
+}
+
+JobSystem::Worker& JobSystem::GetWorker(std::size_t aWorkerIndex)
+{
+	return aWorkerIndex == ourForeignWorkerIndex ? myForeignWorker : *myWorkers[aWorkerIndex];
+}
+
+void JobSystem::Execute(Job* aJob, std::size_t aWorkerIndex)
+{
+	if (aJob->myRangeFunction)
+		(*aJob->myRangeFunction)(aJob->myRangeBegin, aJob->myRangeEnd);
+	else if (aJob->myFunction)
+		aJob->myFunction();
+
+	GetWorker(aWorkerIndex).myExecutedJobs.fetch_add(1);
+	Finish(aJob);
+}
+
+void JobSystem::Finish(Job* aJob)
+{
+	Job* parent = aJob->myParent;
+	if (aJob->myUnfinishedJobs.fetch_sub(1) == 1)
+	{
+		if (parent)
+			Finish(parent);
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing scheduler with one worker per hardware thread. The thread that first
+// calls GetInstance() acts as worker 0 and only executes jobs while it waits. Any other
+// thread queues its jobs on a shared, locked queue that the workers steal from.
+class JobSystem final
+{
+public:
+	using JobFunction = std::function<void()>;
+	using RangeFunction = std::function<void(std::size_t aBegin, std::size_t anEnd)>;
+
+	struct Job
+	{
+		Job();
+
+		JobFunction myFunction;
+		const RangeFunction* myRangeFunction;
+		std::size_t myRangeBegin;
+		std::size_t myRangeEnd;
+		Job* myParent;
+		std::atomic<int> myUnfinishedJobs;
+		// Bumped every time the slot is handed out, so a handle to an earlier use reads as finished
+		std::atomic<std::uint32_t> myGeneration;
+	};
+
+	struct JobHandle
+	{
+		Job* myJob;
+		std::uint32_t myGeneration;
+	};
+
+	struct WorkerStatistics
+	{
+		std::uint64_t myExecutedJobs;
+		std::uint64_t myStolenJobs;
+		std::uint64_t myIdleNanoseconds;
+	};
+
+	static JobSystem& GetInstance()
+	{
+		static JobSystem instance;
+		return instance;
+	}
+
+	JobSystem(JobSystem const&) = delete;
+	void operator=(JobSystem const&) = delete;
+
+	// Jobs live in a fixed ring per worker and are recycled once finished. Handles remember which
+	// use of a slot they refer to, so waiting on one whose slot was reused returns right away.
+	JobHandle CreateJob(JobFunction aFunction);
+	JobHandle CreateChildJob(const JobHandle& aParent, JobFunction aFunction);
+	void Run(const JobHandle& aJob);
+	void Wait(const JobHandle& aJob);
+	bool GetIsFinished(const JobHandle& aJob) const;
+
+	// Splits [0, aCount) into chunks of at least aGrainSize and blocks until all of them ran
+	void ParallelFor(std::size_t aCount, std::size_t aGrainSize, const RangeFunction& aFunction);
+
+	std::size_t GetWorkerCount() const { return myWorkers.size(); }
+	std::vector<WorkerStatistics> GetStatistics() const;
+	void ResetStatistics();
+	void PrintStatistics() const;
+
+private:
+	struct Worker
+	{
+		Worker();
+
+		// Fixed ring of queued jobs, the owner works at the back and thieves take from the front
+		std::unique_ptr<Job*[]> myQueue;
+		std::size_t myQueueFront;
+		std::size_t myQueueSize;
+		std::mutex myQueueMutex;
+		std::unique_ptr<Job[]> myJobPool;
+		std::atomic<std::size_t> myNextJobIndex;
+		std::atomic<std::uint64_t> myExecutedJobs;
+		std::atomic<std::uint64_t> myStolenJobs;
+		std::atomic<std::uint64_t> myIdleNanoseconds;
+		std::thread myThread;
+	};
+
+	JobSystem();
+	~JobSystem();
+
+	void WorkerLoop(std::size_t aWorkerIndex);
+	void Push(Job* aJob);
+	Job* AllocateJob();
+	Job* CreateRangeJob(Job* aParent, const RangeFunction& aFunction, std::size_t aBegin, std::size_t anEnd);
+	Job* GetJob(std::size_t aWorkerIndex);
+	Job* StealJob(Worker& aVictim, std::size_t aWorkerIndex);
+	Worker& GetWorker(std::size_t aWorkerIndex);
+	void Execute(Job* aJob, std::size_t aWorkerIndex);
+	void Finish(Job* aJob);
+
+	std::vector<std::unique_ptr<Worker>> myWorkers;
+	Worker myForeignWorker;
+	std::mutex myWakeMutex;
+	std::condition_variable myWakeCondition;
+	std::atomic<int> myQueuedJobs;
+	std::atomic<bool> myIsRunning;
+};
@@ -0,0 +1,288 @@
+#include "JumpPointSearch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <queue>
+#include <unordered_map>
+
+namespace JumpPointSearch
+{
+	namespace
+	{
+		struct SearchContext
+		{
+			const NavigationGrid& myGrid;
+			const GridRect& myBounds;
+			GridPoint myGoal;
+
+			bool GetIsWalkable(int anX, int anY) const { return myBounds.GetContains(anX, anY) && myGrid.GetIsWalkable(anX, anY); }
+		};
+
+		struct NodeRecord
+		{
+			float myCost;
+			std::int64_t myParent;
+			bool myIsClosed;
+		};
+
+		struct OpenNode
+		{
+			float myEstimate;
+			float myCost;
+			std::int64_t myIndex;
+
+			bool operator>(const OpenNode& anOther) const { return myEstimate > anOther.myEstimate; }
+		};
+
+		int GetSign(int aValue)
+		{
+			return (aValue > 0) - (aValue < 0);
+		}
+
+		// Walks from (anX, anY) in direction (aDeltaX, aDeltaY) until it reaches the goal,
+		// a cell with a forced neighbour, or a wall. Diagonal moves probe both straight
+		// directions at every step and stop as soon as either of them finds something.
+		bool Jump(const SearchContext& aContext, int anX, int anY, int aDeltaX, int aDeltaY, GridPoint& aJumpPoint)
+		{
+			while (true)
+			{
+				if (!aContext.GetIsWalkable(anX, anY))
+					return false;
+
+				if (anX == aContext.myGoal.myX && anY == aContext.myGoal.myY)
+				{
+					aJumpPoint = { anX, anY };
+					return true;
+				}
+
+				if (aDeltaX != 0 && aDeltaY != 0)
+				{
+					GridPoint straightJumpPoint;
+					if (Jump(aContext, anX + aDeltaX, anY, aDeltaX, 0, straightJumpPoint) || Jump(aContext, anX, anY + aDeltaY, 0, aDeltaY, straightJumpPoint))
+					{
+						aJumpPoint = { anX, anY };
+						return true;
+					}
+
+					// Both sides have to be open to move on diagonally
+					if (!aContext.GetIsWalkable(anX + aDeltaX, anY) || !aContext.GetIsWalkable(anX, anY + aDeltaY))
+						return false;
+				}
+				else if (aDeltaX != 0)
+				{
+					if ((aContext.GetIsWalkable(anX, anY - 1) && !aContext.GetIsWalkable(anX - aDeltaX, anY - 1))
+						|| (aContext.GetIsWalkable(anX, anY + 1) && !aContext.GetIsWalkable(anX - aDeltaX, anY + 1)))
+					{
+						aJumpPoint = { anX, anY };
+						return true;
+					}
+				}
+				else
+				{
+					if ((aContext.GetIsWalkable(anX - 1, anY) && !aContext.GetIsWalkable(anX - 1, anY - aDeltaY))
+						|| (aContext.GetIsWalkable(anX + 1, anY) && !aContext.GetIsWalkable(anX + 1, anY - aDeltaY)))
+					{
+						aJumpPoint = { anX, anY };
+						return true;
+					}
+				}
+
+				anX += aDeltaX;
+				anY += aDeltaY;
+			}
+		}
+
+		// Directions worth exploring from a node, pruned by the direction we arrived from
+		int GetDirections(const SearchContext& aContext, GridPoint aPosition, int aDeltaX, int aDeltaY, GridPoint someDirections[8])
+		{
+			const int x = aPosition.myX;
+			const int y = aPosition.myY;
+			int count = 0;
+
+			if (aDeltaX == 0 && aDeltaY == 0)
+			{
+				for (int directionY = -1; directionY <= 1; ++directionY)
+				{
+					for (int directionX = -1; directionX <= 1; ++directionX)
+					{
+						if (directionX == 0 && directionY == 0)
+							continue;
+
+						if (directionX != 0 && directionY != 0 && (!aContext.GetIsWalkable(x + directionX, y) || !aContext.GetIsWalkable(x, y + directionY)))
+							continue;
+
+						if (aContext.GetIsWalkable(x + directionX, y + directionY))
+							someDirections[count++] = { directionX, directionY };
+					}
+				}
+			}
+			else if (aDeltaX != 0 && aDeltaY != 0)
+			{
+				const bool isVerticalWalkable = aContext.GetIsWalkable(x, y + aDeltaY);
+				const bool isHorizontalWalkable = aContext.GetIsWalkable(x + aDeltaX, y);
+				if (isVerticalWalkable)
+					someDirections[count++] = { 0, aDeltaY };
+				if (isHorizontalWalkable)
+					someDirections[count++] = { aDeltaX, 0 };
+				if (isVerticalWalkable && isHorizontalWalkable)
+					someDirections[count++] = { aDeltaX, aDeltaY };
+			}
+			else if (aDeltaX != 0)
+			{
+				const bool isNextWalkable = aContext.GetIsWalkable(x + aDeltaX, y);
+				const bool isAboveWalkable = aContext.GetIsWalkable(x, y - 1);
+				const bool isBelowWalkable = aContext.GetIsWalkable(x, y + 1);
+				if (isNextWalkable)
+				{
+					someDirections[count++] = { aDeltaX, 0 };
+					if (isAboveWalkable)
+						someDirections[count++] = { aDeltaX, -1 };
+					if (isBelowWalkable)
+						someDirections[count++] = { aDeltaX, 1 };
+				}
+				if (isAboveWalkable)
+					someDirections[count++] = { 0, -1 };
+				if (isBelowWalkable)
+					someDirections[count++] = { 0, 1 };
+			}
+			else
+			{
+				const bool isNextWalkable = aContext.GetIsWalkable(x, y + aDeltaY);
+				const bool isLeftWalkable = aContext.GetIsWalkable(x - 1, y);
+				const bool isRightWalkable = aContext.GetIsWalkable(x + 1, y);
+				if (isNextWalkable)
+				{
+					someDirections[count++] = { 0, aDeltaY };
+					if (isLeftWalkable)
+						someDirections[count++] = { -1, aDeltaY };
+					if (isRightWalkable)
+						someDirections[count++] = { 1, aDeltaY };
+				}
+				if (isLeftWalkable)
+					someDirections[count++] = { -1, 0 };
+				if (isRightWalkable)
+					someDirections[count++] = { 1, 0 };
+			}
+
+			return count;
+		}
+	} // namespace
+
+	float GetDistance(GridPoint aFrom, GridPoint aTo)
+	{
+		static const float diagonalCost = std::sqrt(2.0f);
+		const int deltaX = std::abs(aTo.myX - aFrom.myX);
+		const int deltaY = std::abs(aTo.myY - aFrom.myY);
+		const int diagonalSteps = std::min(deltaX, deltaY);
+		return static_cast<float>(std::max(deltaX, deltaY) - diagonalSteps) + static_cast<float>(diagonalSteps) * diagonalCost;
+	}
+
+	bool FindPath(const NavigationGrid& aGrid,
+		const GridRect& aBounds,
+		GridPoint aStart,
+		GridPoint aGoal,
+		std::vector<GridPoint>& aPath,
+		float& aCost,
+		std::size_t& anExpandedNodeCount)
+	{
+		aPath.clear();
+		aCost = 0.0f;
+
+		const SearchContext context { aGrid, aBounds, aGoal };
+		if (!context.GetIsWalkable(aStart.myX, aStart.myY) || !context.GetIsWalkable(aGoal.myX, aGoal.myY))
+			return false;
+
+		const std::int64_t width = aGrid.GetWidth();
+		const auto toIndex = [width](GridPoint aPoint) { return static_cast<std::int64_t>(aPoint.myY) * width + aPoint.myX; };
+		const auto toPoint = [width](std::int64_t anIndex) { return GridPoint { static_cast<int>(anIndex % width), static_cast<int>(anIndex / width) }; };
+
+		std::unordered_map<std::int64_t, NodeRecord> records;
+		std::priority_queue<OpenNode, std::vector<OpenNode>, std::greater<OpenNode>> openNodes;
+
+		const std::int64_t startIndex = toIndex(aStart);
+		const std::int64_t goalIndex = toIndex(aGoal);
+		records[startIndex] = { 0.0f, -1, false };
+		openNodes.push({ GetDistance(aStart, aGoal), 0.0f, startIndex });
+
+		while (!openNodes.empty())
+		{
+			const OpenNode current = openNodes.top();
+			openNodes.pop();
+
+			NodeRecord& currentRecord = records[current.myIndex];
+			if (currentRecord.myIsClosed || current.myCost > currentRecord.myCost)
+				continue;
+
+			currentRecord.myIsClosed = true;
+			++anExpandedNodeCount;
+
+			if (current.myIndex == goalIndex)
+				break;
+
+			const GridPoint position = toPoint(current.myIndex);
+			int deltaX = 0;
+			int deltaY = 0;
+			if (currentRecord.myParent >= 0)
+			{
+				const GridPoint parent = toPoint(currentRecord.myParent);
+				deltaX = GetSign(position.myX - parent.myX);
+				deltaY = GetSign(position.myY - parent.myY);
+			}
+
+			GridPoint directions[8];
+			const int directionCount = GetDirections(context, position, deltaX, deltaY, directions);
+			for (int i = 0; i < directionCount; ++i)
+			{
+				GridPoint jumpPoint;
+				if (!Jump(context, position.myX + directions[i].myX, position.myY + directions[i].myY, directions[i].myX, directions[i].myY, jumpPoint))
+					continue;
+
+				const std::int64_t jumpIndex = toIndex(jumpPoint);
+				const float cost = current.myCost + GetDistance(position, jumpPoint);
+				std::unordered_map<std::int64_t, NodeRecord>::iterator record = records.find(jumpIndex);
+				if (record == records.end())
+				{
+					records[jumpIndex] = { cost, current.myIndex, false };
+				}
+				else
+				{
+					if (record->second.myIsClosed || cost >= record->second.myCost)
+						continue;
+
+					record->second = { cost, current.myIndex, false };
+				}
+
+				openNodes.push({ cost + GetDistance(jumpPoint, aGoal), cost, jumpIndex });
+			}
+		}
+
+		const std::unordered_map<std::int64_t, NodeRecord>::const_iterator goalRecord = records.find(goalIndex);
+		if (goalRecord == records.end() || !goalRecord->second.myIsClosed)
+			return false;
+
+		aCost = goalRecord->second.myCost;
+
+		// Jump points are joined by straight or diagonal lines, so fill in the cells between them
+		std::vector<GridPoint> jumpPoints;
+		for (std::int64_t index = goalIndex; index >= 0; index = records[index].myParent)
+			jumpPoints.push_back(toPoint(index));
+
+		std::reverse(jumpPoints.begin(), jumpPoints.end());
+		aPath.push_back(jumpPoints.front());
+		for (std::size_t i = 1; i < jumpPoints.size(); ++i)
+		{
+			GridPoint position = jumpPoints[i - 1];
+			const int deltaX = GetSign(jumpPoints[i].myX - position.myX);
+			const int deltaY = GetSign(jumpPoints[i].myY - position.myY);
+			while (position != jumpPoints[i])
+			{
+				position.myX += deltaX;
+				position.myY += deltaY;
+				aPath.push_back(position);
+			}
+		}
+
+		return true;
+	}
+} // namespace JumpPointSearch
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "NavigationGrid.hpp"
+
+#include <cstddef>
+#include <vector>
+
+// Jump point search over an 8-connected grid where diagonal moves may not cut corners
+namespace JumpPointSearch
+{
+	// Finds a shortest path from aStart to aGoal without leaving aBounds. On success aPath holds
+	// every cell along the way, including both ends, and aCost its length in straight steps.
+	// The number of expanded jump points is added to anExpandedNodeCount either way.
+	bool FindPath(const NavigationGrid& aGrid,
+		const GridRect& aBounds,
+		GridPoint aStart,
+		GridPoint aGoal,
+		std::vector<GridPoint>& aPath,
+		float& aCost,
+		std::size_t& anExpandedNodeCount);
+
+	// Octile distance, which is exact on an empty 8-connected grid
+	float GetDistance(GridPoint aFrom, GridPoint aTo);
+} // namespace JumpPointSearch
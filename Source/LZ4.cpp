@@ -0,0 +1,186 @@
+#include "LZ4.hpp"
+
+#include <cstring>
+#include <vector>
+
+namespace LZ4Parameters
+{
+	static constexpr std::size_t ourMinimumMatch = 4;
+	// The format requires the last five bytes to be literals and the last match to start twelve bytes before the end
+	static constexpr std::size_t ourLastLiterals = 5;
+	static constexpr std::size_t ourMatchFindLimit = 12;
+	static constexpr std::size_t ourMaximumOffset = 65535;
+	static constexpr unsigned int ourHashBits = 16;
+	static constexpr std::uint32_t ourNoPosition = 0xFFFFFFFF;
+}
+
+static std::uint32_t Read32(const std::uint8_t* someBytes)
+{
+	std::uint32_t value;
+	std::memcpy(&value, someBytes, sizeof(value));
+	return value;
+}
+
+static std::uint32_t Hash(std::uint32_t aSequence)
+{
+	return (aSequence * 2654435761u) >> (32 - LZ4Parameters::ourHashBits);
+}
+
+static std::uint8_t* WriteLength(std::size_t aLength, std::uint8_t* someDestination)
+{
+	for (; aLength >= 255; aLength -= 255)
+		*someDestination++ = 255;
+
+	*someDestination++ = static_cast<std::uint8_t>(aLength);
+	return someDestination;
+}
+
+static std::uint8_t* WriteSequence(const std::uint8_t* someLiterals, std::size_t aLiteralCount, std::size_t anOffset, std::size_t aMatchLength, std::uint8_t* someDestination)
+{
+	std::uint8_t* token = someDestination++;
+	*token = static_cast<std::uint8_t>((aLiteralCount < 15 ? aLiteralCount : 15) << 4);
+	if (aLiteralCount >= 15)
+		someDestination = WriteLength(aLiteralCount - 15, someDestination);
+
+	if (aLiteralCount > 0)
+		std::memcpy(someDestination, someLiterals, aLiteralCount);
+	someDestination += aLiteralCount;
+
+	// The last sequence of a block is only literals
+	if (aMatchLength == 0)
+		return someDestination;
+
+	*someDestination++ = static_cast<std::uint8_t>(anOffset);
+	*someDestination++ = static_cast<std::uint8_t>(anOffset >> 8);
+
+	const std::size_t matchCode = aMatchLength - LZ4Parameters::ourMinimumMatch;
+	*token |= static_cast<std::uint8_t>(matchCode < 15 ? matchCode : 15);
+	if (matchCode >= 15)
+		someDestination = WriteLength(matchCode - 15, someDestination);
+
+	return someDestination;
+}
+
+static bool ReadLength(const std::uint8_t* someSource, std::size_t aSize, std::size_t& aPosition, std::size_t& aLength)
+{
+	std::uint8_t byte = 255;
+	while (byte == 255)
+	{
+		if (aPosition >= aSize)
+			return false;
+
+		byte = someSource[aPosition++];
+		aLength += byte;
+	}
+
+	return true;
+}
+
+std::size_t LZ4::GetMaximumCompressedSize(std::size_t aSize)
+{
+	return aSize + aSize / 255 + 16;
+}
+
+std::size_t LZ4::Compress(const std::uint8_t* someSource, std::size_t aSize, std::uint8_t* someDestination, std::size_t aCapacity)
+{
+	if (aCapacity < GetMaximumCompressedSize(aSize))
+		return 0;
+
+	std::uint8_t* destination = someDestination;
+	std::size_t anchor = 0;
+	if (aSize > LZ4Parameters::ourMatchFindLimit)
+	{
+		std::vector<std::uint32_t> positions(std::size_t(1) << LZ4Parameters::ourHashBits, LZ4Parameters::ourNoPosition);
+		const std::size_t matchLimit = aSize - LZ4Parameters::ourLastLiterals;
+
+		std::size_t position = 0;
+		while (position + LZ4Parameters::ourMatchFindLimit <= aSize)
+		{
+			const std::uint32_t sequence = Read32(someSource + position);
+			const std::uint32_t hash = Hash(sequence);
+			std::size_t reference = positions[hash];
+			positions[hash] = static_cast<std::uint32_t>(position);
+
+			if (reference == LZ4Parameters::ourNoPosition || position - reference > LZ4Parameters::ourMaximumOffset || Read32(someSource + reference) != sequence)
+			{
+				++position;
+				continue;
+			}
+
+			// Grow the match backwards into the pending literals, then forwards as far as it goes
+			while (position > anchor && reference > 0 && someSource[position - 1] == someSource[reference - 1])
+			{
+				--position;
+				--reference;
+			}
+
+			std::size_t matchLength = LZ4Parameters::ourMinimumMatch;
+			while (position + matchLength < matchLimit && someSource[reference + matchLength] == someSource[position + matchLength])
+				++matchLength;
+
+			destination = WriteSequence(someSource + anchor, position - anchor, position - reference, matchLength, destination);
+			position += matchLength;
+			anchor = position;
+		}
+	}
+
+	destination = WriteSequence(someSource + anchor, aSize - anchor, 0, 0, destination);
+	return static_cast<std::size_t>(destination - someDestination);
+}
+
+bool LZ4::Decompress(const std::uint8_t* someSource, std::size_t aSize, std::uint8_t* someDestination, std::size_t aDecompressedSize)
+{
+	std::size_t source = 0;
+	std::size_t destination = 0;
+	while (source < aSize)
+	{
+		const std::uint8_t token = someSource[source++];
+
+		std::size_t literalCount = token >> 4;
+		if (literalCount == 15 && !ReadLength(someSource, aSize, source, literalCount))
+			return false;
+
+		if (literalCount > aSize - source || literalCount > aDecompressedSize - destination)
+			return false;
+
+		if (literalCount > 0)
+			std::memcpy(someDestination + destination, someSource + source, literalCount);
+		source += literalCount;
+		destination += literalCount;
+
+		if (source == aSize)
+			break;
+
+		if (aSize - source < 2)
+			return false;
+
+		const std::size_t offset = someSource[source] | (static_cast<std::size_t>(someSource[source + 1]) << 8);
+		source += 2;
+		if (offset == 0 || offset > destination)
+			return false;
+
+		std::size_t matchLength = token & 15;
+		if (matchLength == 15 && !ReadLength(someSource, aSize, source, matchLength))
+			return false;
+
+		matchLength += LZ4Parameters::ourMinimumMatch;
+		if (matchLength > aDecompressedSize - destination)
+			return false;
+
+		// Overlapping matches repeat the bytes they're still writing, so they have to go one at a time
+		const std::uint8_t* match = someDestination + destination - offset;
+		if (offset >= matchLength)
+		{
+			std::memcpy(someDestination + destination, match, matchLength);
+		}
+		else
+		{
+			for (std::size_t i = 0; i < matchLength; ++i)
+				someDestination[destination + i] = match[i];
+		}
+
+		destination += matchLength;
+	}
+
+	return destination == aDecompressedSize;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Compression and decompression of raw LZ4 blocks, without the frame format around them.
+// The compressor is the plain greedy one, ratio matters less than how fast entries decompress.
+namespace LZ4
+{
+	std::size_t GetMaximumCompressedSize(std::size_t aSize);
+
+	// Returns the compressed size, or 0 if aCapacity is below GetMaximumCompressedSize(aSize)
+	std::size_t Compress(const std::uint8_t* someSource, std::size_t aSize, std::uint8_t* someDestination, std::size_t aCapacity);
+
+	// Fails unless the block decompresses to exactly aDecompressedSize bytes, malformed input is never read or written out of bounds
+	bool Decompress(const std::uint8_t* someSource, std::size_t aSize, std::uint8_t* someDestination, std::size_t aDecompressedSize);
+} // namespace LZ4
@@ -0,0 +1,521 @@
+#include "LightMap.hpp"
+#include "FrameAllocator.hpp"
+#include "JobSystem.hpp"
+#include "TilePropertyTable.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+
+namespace LightMapParameters
+{
+	static constexpr int ourChunkSize = 32;
+	static constexpr std::size_t ourLightsPerJob = 4;
+	static constexpr std::size_t ourChunksPerJob = 8;
+	static constexpr std::uint8_t ourBlockingOpacity = 255;
+	// Partially transparent tiles still stop the eye once they're at least this opaque
+	static constexpr std::uint8_t ourSightBlockingOpacity = 128;
+	static constexpr std::uint8_t ourVisible = 255;
+}
+
+LightMap::LightMap(int aWidth, int aHeight)
+	: myOpacities(static_cast<std::size_t>(aWidth) * aHeight, 0)
+	, myWidth(aWidth)
+	, myHeight(aHeight)
+	, myChunkColumns((aWidth + LightMapParameters::ourChunkSize - 1) / LightMapParameters::ourChunkSize)
+	, myChunkRows((aHeight + LightMapParameters::ourChunkSize - 1) / LightMapParameters::ourChunkSize)
+	, myTextureIdentifier(0)
+{
+	myViewer.myPosition = { 0, 0 };
+	myViewer.myRadius = 0;
+	myViewer.myIsEnabled = false;
+	myViewer.myIsDirty = false;
+
+	// Everything starts out unlit but visible, until a viewer is placed
+	myTexels.resize(myOpacities.size() * 2, 0);
+	for (std::size_t i = 0; i < myOpacities.size(); ++i)
+		myTexels[i * 2 + 1] = LightMapParameters::ourVisible;
+
+	const std::size_t chunkCount = static_cast<std::size_t>(myChunkColumns) * myChunkRows;
+	myDirtyChunks.assign(chunkCount, false);
+	myDirtyChunkIndices.reserve(chunkCount);
+
+	glGenTextures(1, &myTextureIdentifier);
+	glBindTexture(GL_TEXTURE_2D, myTextureIdentifier);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, myWidth, myHeight, 0, GL_RG, GL_UNSIGNED_BYTE, myTexels.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+LightMap::~LightMap()
+{
+	if (myTextureIdentifier)
+		glDeleteTextures(1, &myTextureIdentifier);
+}
+
+void LightMap::AddOccludingLayer(const TilePropertyTable& someTileProperties, std::size_t aLayerIndex)
+{
+	if (myTileOpacities.empty())
+		myTileOpacities = GetTileOpacities(someTileProperties);
+
+	myOccludingLayers.push_back(aLayerIndex);
+	for (int y = 0; y < myHeight; ++y)
+	{
+		for (int x = 0; x < myWidth; ++x)
+		{
+			const std::uint32_t gid = someTileProperties.GetGID(aLayerIndex, x, y);
+			std::uint8_t& opacity = myOpacities[static_cast<std::size_t>(y) * myWidth + x];
+			opacity = std::max(opacity, gid < myTileOpacities.size() ? myTileOpacities[gid] : static_cast<std::uint8_t>(0));
+		}
+	}
+
+	for (Light& light : myLights)
+		light.myIsDirty = true;
+
+	myViewer.myIsDirty = myViewer.myIsEnabled;
+	MarkDirty({ 0, 0, myWidth, myHeight });
+}
+
+void LightMap::SetOpacity(int anX, int anY, std::uint8_t anOpacity)
+{
+	if (anX < 0 || anY < 0 || anX >= myWidth || anY >= myHeight)
+		return;
+
+	std::uint8_t& opacity = myOpacities[static_cast<std::size_t>(anY) * myWidth + anX];
+	if (opacity == anOpacity)
+		return;
+
+	opacity = anOpacity;
+	MarkDirty({ anX, anY, anX + 1, anY + 1 });
+
+	// Only lights and the viewer that can reach the tile have to be redone
+	for (Light& light : myLights)
+	{
+		const GridRect bounds = GetBounds(light.myPosition, light.myRadius);
+		if (light.myIsEnabled && bounds.GetContains(anX, anY))
+		{
+			light.myIsDirty = true;
+			MarkDirty(bounds);
+		}
+	}
+
+	const GridRect viewerBounds = GetBounds(myViewer.myPosition, myViewer.myRadius);
+	if (myViewer.myIsEnabled && viewerBounds.GetContains(anX, anY))
+	{
+		myViewer.myIsDirty = true;
+		MarkDirty(viewerBounds);
+	}
+}
+
+void LightMap::RefreshOpacity(const TilePropertyTable& someTileProperties, int anX, int anY)
+{
+	std::uint8_t opacity = 0;
+	for (const std::size_t layerIndex : myOccludingLayers)
+	{
+		const std::uint32_t gid = someTileProperties.GetGID(layerIndex, anX, anY);
+		opacity = std::max(opacity, gid < myTileOpacities.size() ? myTileOpacities[gid] : static_cast<std::uint8_t>(0));
+	}
+
+	SetOpacity(anX, anY, opacity);
+}
+
+std::size_t LightMap::AddLight(GridPoint aPosition, int aRadius, std::uint8_t anIntensity)
+{
+	const std::size_t side = static_cast<std::size_t>(aRadius) * 2 + 1;
+
+	Light light;
+	light.myLevels.resize(side * side, 0);
+	// Each cell is queued at most once at a time, so the ring never needs more room than the area
+	light.myQueue.resize(side * side, 0);
+	light.myIsQueued.resize(side * side, false);
+	light.myPosition = aPosition;
+	light.myRadius = aRadius;
+	light.myIntensity = anIntensity;
+	light.myIsEnabled = true;
+	light.myIsDirty = true;
+	myLights.push_back(std::move(light));
+
+	MarkDirty(GetBounds(aPosition, aRadius));
+	return myLights.size() - 1;
+}
+
+void LightMap::SetLightPosition(std::size_t aLightIndex, GridPoint aPosition)
+{
+	Light& light = myLights[aLightIndex];
+	if (light.myPosition == aPosition)
+		return;
+
+	MarkDirty(GetBounds(light.myPosition, light.myRadius));
+	light.myPosition = aPosition;
+	light.myIsDirty = true;
+	MarkDirty(GetBounds(light.myPosition, light.myRadius));
+}
+
+void LightMap::SetLightIsEnabled(std::size_t aLightIndex, bool anIsEnabled)
+{
+	Light& light = myLights[aLightIndex];
+	if (light.myIsEnabled == anIsEnabled)
+		return;
+
+	light.myIsEnabled = anIsEnabled;
+	light.myIsDirty = anIsEnabled;
+	MarkDirty(GetBounds(light.myPosition, light.myRadius));
+}
+
+void LightMap::SetViewer(GridPoint aPosition, int aRadius)
+{
+	if (myViewer.myIsEnabled && myViewer.myPosition == aPosition && myViewer.myRadius == aRadius)
+		return;
+
+	// Without a viewer everything counted as visible
+	MarkDirty(myViewer.myIsEnabled ? GetBounds(myViewer.myPosition, myViewer.myRadius) : GridRect{ 0, 0, myWidth, myHeight });
+
+	const std::size_t side = static_cast<std::size_t>(aRadius) * 2 + 1;
+	if (myViewer.myVisibility.size() != side * side)
+		myViewer.myVisibility.resize(side * side);
+
+	myViewer.myPosition = aPosition;
+	myViewer.myRadius = aRadius;
+	myViewer.myIsEnabled = true;
+	myViewer.myIsDirty = true;
+	MarkDirty(GetBounds(aPosition, aRadius));
+}
+
+void LightMap::Update(FrameAllocator& aFrameAllocator)
+{
+	// Without frame memory left the dirty lights are propagated right here instead of being spread over the workers
+	std::size_t* dirtyLightIndices = aFrameAllocator.AllocateArray<std::size_t>(myLights.size());
+	std::size_t dirtyLightCount = 0;
+	for (std::size_t i = 0; i < myLights.size(); ++i)
+	{
+		if (!myLights[i].myIsEnabled || !myLights[i].myIsDirty)
+			continue;
+
+		if (dirtyLightIndices)
+			dirtyLightIndices[dirtyLightCount++] = i;
+		else
+			PropagateLight(myLights[i]);
+	}
+
+	JobSystem::GetInstance().ParallelFor(dirtyLightCount, LightMapParameters::ourLightsPerJob, [this, dirtyLightIndices](std::size_t aBegin, std::size_t anEnd)
+		{
+			for (std::size_t i = aBegin; i < anEnd; ++i)
+				PropagateLight(myLights[dirtyLightIndices[i]]);
+		});
+
+	if (myViewer.myIsDirty)
+		ComputeFieldOfView(myViewer);
+
+	if (myDirtyChunkIndices.empty())
+		return;
+
+	JobSystem::GetInstance().ParallelFor(myDirtyChunkIndices.size(), LightMapParameters::ourChunksPerJob, [this](std::size_t aBegin, std::size_t anEnd)
+		{
+			for (std::size_t i = aBegin; i < anEnd; ++i)
+				ResolveChunk(myDirtyChunkIndices[i]);
+		});
+
+	glBindTexture(GL_TEXTURE_2D, myTextureIdentifier);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, myWidth);
+	for (const std::size_t chunkIndex : myDirtyChunkIndices)
+	{
+		const int left = static_cast<int>(chunkIndex % myChunkColumns) * LightMapParameters::ourChunkSize;
+		const int top = static_cast<int>(chunkIndex / myChunkColumns) * LightMapParameters::ourChunkSize;
+		const int width = std::min(LightMapParameters::ourChunkSize, myWidth - left);
+		const int height = std::min(LightMapParameters::ourChunkSize, myHeight - top);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, left, top, width, height, GL_RG, GL_UNSIGNED_BYTE, &myTexels[(static_cast<std::size_t>(top) * myWidth + left) * 2]);
+
+		myDirtyChunks[chunkIndex] = false;
+	}
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	myDirtyChunkIndices.clear();
+}
+
+bool LightMap::GetIsVisible(int anX, int anY) const
+{
+	if (anX < 0 || anY < 0 || anX >= myWidth || anY >= myHeight)
+		return false;
+
+	return myTexels[(static_cast<std::size_t>(anY) * myWidth + anX) * 2 + 1] != 0;
+}
+
+std::uint8_t LightMap::GetLightLevel(int anX, int anY) const
+{
+	if (anX < 0 || anY < 0 || anX >= myWidth || anY >= myHeight)
+		return 0;
+
+	return myTexels[(static_cast<std::size_t>(anY) * myWidth + anX) * 2];
+}
+
+GridRect LightMap::GetBounds(GridPoint aPosition, int aRadius)
+{
+	return { aPosition.myX - aRadius, aPosition.myY - aRadius, aPosition.myX + aRadius + 1, aPosition.myY + aRadius + 1 };
+}
+
+std::vector<std::uint8_t> LightMap::GetTileOpacities(const TilePropertyTable& someTileProperties)
+{
+	const std::size_t opacityColumn = someTileProperties.GetFloatColumn("opacity");
+	const TilePropertyTable::FlagMask opaqueFlag = someTileProperties.GetFlag("opaque");
+
+	std::vector<std::uint8_t> opacities(someTileProperties.GetGIDCount(), 0);
+	for (std::uint32_t gid = 0; gid < opacities.size(); ++gid)
+	{
+		if ((someTileProperties.GetFlags(gid) & opaqueFlag) != 0)
+			opacities[gid] = LightMapParameters::ourBlockingOpacity;
+		else
+			opacities[gid] = static_cast<std::uint8_t>(std::clamp(someTileProperties.GetFloat(opacityColumn, gid), 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+
+	return opacities;
+}
+
+bool LightMap::GetIsOpaque(int anX, int anY) const
+{
+	if (anX < 0 || anY < 0 || anX >= myWidth || anY >= myHeight)
+		return true;
+
+	return myOpacities[static_cast<std::size_t>(anY) * myWidth + anX] >= LightMapParameters::ourSightBlockingOpacity;
+}
+
+void LightMap::MarkDirty(const GridRect& aRect)
+{
+	const int left = std::max(aRect.myLeft, 0);
+	const int top = std::max(aRect.myTop, 0);
+	const int right = std::min(aRect.myRight, myWidth);
+	const int bottom = std::min(aRect.myBottom, myHeight);
+	if (left >= right || top >= bottom)
+		return;
+
+	for (int chunkY = top / LightMapParameters::ourChunkSize; chunkY <= (bottom - 1) / LightMapParameters::ourChunkSize; ++chunkY)
+	{
+		for (int chunkX = left / LightMapParameters::ourChunkSize; chunkX <= (right - 1) / LightMapParameters::ourChunkSize; ++chunkX)
+		{
+			const std::size_t chunkIndex = static_cast<std::size_t>(chunkY) * myChunkColumns + chunkX;
+			if (!myDirtyChunks[chunkIndex])
+			{
+				myDirtyChunks[chunkIndex] = true;
+				myDirtyChunkIndices.push_back(chunkIndex);
+			}
+		}
+	}
+}
+
+void LightMap::PropagateLight(Light& aLight) const
+{
+	const int radius = aLight.myRadius;
+	const int side = radius * 2 + 1;
+	const std::size_t queueCapacity = aLight.myQueue.size();
+	const GridRect bounds = GetBounds(aLight.myPosition, radius);
+
+	// Light fades out linearly over the radius, diagonal steps cost roughly sqrt(2) as much
+	const int straightCost = std::max(1, aLight.myIntensity / (radius + 1));
+	const int diagonalCost = (straightCost * 181 + 64) / 128;
+
+	std::fill(aLight.myLevels.begin(), aLight.myLevels.end(), static_cast<std::uint8_t>(0));
+	aLight.myIsDirty = false;
+	if (aLight.myPosition.myX < 0 || aLight.myPosition.myY < 0 || aLight.myPosition.myX >= myWidth || aLight.myPosition.myY >= myHeight)
+		return;
+
+	const std::uint32_t center = static_cast<std::uint32_t>(radius * side + radius);
+	aLight.myLevels[center] = aLight.myIntensity;
+
+	std::size_t queueFront = 0;
+	std::size_t queueSize = 1;
+	aLight.myQueue[0] = center;
+	std::vector<std::uint8_t>& levels = aLight.myLevels;
+	std::vector<char>& isQueued = aLight.myIsQueued;
+	isQueued[center] = true;
+
+	while (queueSize > 0)
+	{
+		const std::uint32_t cell = aLight.myQueue[queueFront];
+		queueFront = (queueFront + 1) % queueCapacity;
+		--queueSize;
+		isQueued[cell] = false;
+
+		const int localX = static_cast<int>(cell % side);
+		const int localY = static_cast<int>(cell / side);
+		const int x = bounds.myLeft + localX;
+		const int y = bounds.myTop + localY;
+		const std::uint8_t opacity = myOpacities[static_cast<std::size_t>(y) * myWidth + x];
+
+		// Walls catch the light but don't pass it on, unless the light sits inside them, which passes it on undimmed
+		if (opacity >= LightMapParameters::ourBlockingOpacity && cell != center)
+			continue;
+
+		const int transmitted = cell == center ? levels[cell] : levels[cell] * (255 - opacity) / 255;
+		for (int offsetY = -1; offsetY <= 1; ++offsetY)
+		{
+			for (int offsetX = -1; offsetX <= 1; ++offsetX)
+			{
+				if (offsetX == 0 && offsetY == 0)
+					continue;
+
+				const int neighbourX = localX + offsetX;
+				const int neighbourY = localY + offsetY;
+				if (neighbourX < 0 || neighbourY < 0 || neighbourX >= side || neighbourY >= side)
+					continue;
+
+				const int mapX = bounds.myLeft + neighbourX;
+				const int mapY = bounds.myTop + neighbourY;
+				if (mapX < 0 || mapY < 0 || mapX >= myWidth || mapY >= myHeight)
+					continue;
+
+				const bool isDiagonal = offsetX != 0 && offsetY != 0;
+				if (isDiagonal && (myOpacities[static_cast<std::size_t>(y) * myWidth + mapX] >= LightMapParameters::ourBlockingOpacity
+					|| myOpacities[static_cast<std::size_t>(mapY) * myWidth + x] >= LightMapParameters::ourBlockingOpacity))
+					continue;
+
+				const int level = transmitted - (isDiagonal ? diagonalCost : straightCost);
+				const std::uint32_t neighbour = static_cast<std::uint32_t>(neighbourY * side + neighbourX);
+				if (level <= levels[neighbour])
+					continue;
+
+				// A brighter path to a queued cell just raises what it will pass on once it's popped
+				levels[neighbour] = static_cast<std::uint8_t>(level);
+				if (isQueued[neighbour])
+					continue;
+
+				isQueued[neighbour] = true;
+				aLight.myQueue[(queueFront + queueSize) % queueCapacity] = neighbour;
+				++queueSize;
+			}
+		}
+	}
+}
+
+void LightMap::ComputeFieldOfView(Viewer& aViewer) const
+{
+	// Octant transforms from Björn Bergström's recursive shadowcasting
+	static constexpr int ourMultipliers[4][8] =
+	{
+		{ 1, 0, 0, -1, -1, 0, 0, 1 },
+		{ 0, 1, -1, 0, 0, -1, 1, 0 },
+		{ 0, 1, 1, 0, 0, -1, -1, 0 },
+		{ 1, 0, 0, 1, -1, 0, 0, -1 }
+	};
+
+	std::fill(aViewer.myVisibility.begin(), aViewer.myVisibility.end(), static_cast<std::uint8_t>(0));
+	aViewer.myIsDirty = false;
+
+	const int side = aViewer.myRadius * 2 + 1;
+	aViewer.myVisibility[static_cast<std::size_t>(aViewer.myRadius) * side + aViewer.myRadius] = 1;
+	for (int octant = 0; octant < 8; ++octant)
+		CastLight(aViewer, 1, 1.0f, 0.0f, ourMultipliers[0][octant], ourMultipliers[1][octant], ourMultipliers[2][octant], ourMultipliers[3][octant]);
+}
+
+void LightMap::CastLight(Viewer& aViewer, int aRow, float aStartSlope, float anEndSlope, int anXX, int anXY, int anYX, int anYY) const
+{
+	if (aStartSlope < anEndSlope)
+		return;
+
+	const int radius = aViewer.myRadius;
+	const int side = radius * 2 + 1;
+	const int radiusSquared = radius * radius;
+	float startSlope = aStartSlope;
+	float nextStartSlope = aStartSlope;
+
+	for (int row = aRow; row <= radius; ++row)
+	{
+		bool isBlocked = false;
+		for (int deltaX = -row, deltaY = -row; deltaX <= 0; ++deltaX)
+		{
+			const float leftSlope = (deltaX - 0.5f) / (deltaY + 0.5f);
+			const float rightSlope = (deltaX + 0.5f) / (deltaY - 0.5f);
+			if (startSlope < rightSlope)
+				continue;
+			if (anEndSlope > leftSlope)
+				break;
+
+			const int localX = deltaX * anXX + deltaY * anXY;
+			const int localY = deltaX * anYX + deltaY * anYY;
+			const int x = aViewer.myPosition.myX + localX;
+			const int y = aViewer.myPosition.myY + localY;
+
+			if (localX * localX + localY * localY <= radiusSquared)
+				aViewer.myVisibility[static_cast<std::size_t>(localY + radius) * side + localX + radius] = 1;
+
+			const bool isOpaque = GetIsOpaque(x, y);
+			if (isBlocked)
+			{
+				if (isOpaque)
+				{
+					nextStartSlope = rightSlope;
+					continue;
+				}
+
+				isBlocked = false;
+				startSlope = nextStartSlope;
+			}
+			else if (isOpaque && row < radius)
+			{
+				isBlocked = true;
+				CastLight(aViewer, row + 1, startSlope, leftSlope, anXX, anXY, anYX, anYY);
+				nextStartSlope = rightSlope;
+			}
+		}
+
+		if (isBlocked)
+			break;
+	}
+}
+
+void LightMap::ResolveChunk(std::size_t aChunkIndex)
+{
+	const int left = static_cast<int>(aChunkIndex % myChunkColumns) * LightMapParameters::ourChunkSize;
+	const int top = static_cast<int>(aChunkIndex / myChunkColumns) * LightMapParameters::ourChunkSize;
+	const int right = std::min(left + LightMapParameters::ourChunkSize, myWidth);
+	const int bottom = std::min(top + LightMapParameters::ourChunkSize, myHeight);
+
+	for (int y = top; y < bottom; ++y)
+	{
+		std::uint8_t* texels = &myTexels[(static_cast<std::size_t>(y) * myWidth + left) * 2];
+		for (int x = 0; x < right - left; ++x)
+			texels[x * 2] = 0;
+	}
+
+	// Overlapping lights don't add up, the brightest one wins
+	for (const Light& light : myLights)
+	{
+		if (!light.myIsEnabled)
+			continue;
+
+		const GridRect bounds = GetBounds(light.myPosition, light.myRadius);
+		const int side = light.myRadius * 2 + 1;
+		for (int y = std::max(top, bounds.myTop); y < std::min(bottom, bounds.myBottom); ++y)
+		{
+			for (int x = std::max(left, bounds.myLeft); x < std::min(right, bounds.myRight); ++x)
+			{
+				std::uint8_t& texel = myTexels[(static_cast<std::size_t>(y) * myWidth + x) * 2];
+				texel = std::max(texel, light.myLevels[static_cast<std::size_t>(y - bounds.myTop) * side + x - bounds.myLeft]);
+			}
+		}
+	}
+
+	const GridRect viewerBounds = GetBounds(myViewer.myPosition, myViewer.myRadius);
+	const int viewerSide = myViewer.myRadius * 2 + 1;
+	for (int y = top; y < bottom; ++y)
+	{
+		for (int x = left; x < right; ++x)
+		{
+			std::uint8_t visibility = LightMapParameters::ourVisible;
+			if (myViewer.myIsEnabled)
+			{
+				visibility = viewerBounds.GetContains(x, y) && myViewer.myVisibility[static_cast<std::size_t>(y - viewerBounds.myTop) * viewerSide + x - viewerBounds.myLeft] != 0
+					? LightMapParameters::ourVisible
+					: 0;
+			}
+
+			myTexels[(static_cast<std::size_t>(y) * myWidth + x) * 2 + 1] = visibility;
+		}
+	}
+}
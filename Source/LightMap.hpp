@@ -0,0 +1,91 @@
+#pragma once
+
+#include "NavigationGrid.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class FrameAllocator;
+class TilePropertyTable;
+
+// Per tile light and visibility for a map, kept in a two channel texture with one texel per tile.
+// Light spreads from each light by flood fill and the viewer's field of view comes from recursive
+// shadowcasting, both stopped by tile opacity. Every light and the viewer cache their own result,
+// so moving one or editing a tile only recomputes what it touches and re-uploads the dirty chunks.
+class LightMap final
+{
+public:
+	LightMap(int aWidth, int aHeight);
+	~LightMap();
+
+	LightMap(const LightMap&) = delete;
+	LightMap& operator=(const LightMap&) = delete;
+
+	// Tiles block light by their float "opacity" property in [0, 1], or fully if their bool "opaque" property is set
+	void AddOccludingLayer(const TilePropertyTable& someTileProperties, std::size_t aLayerIndex);
+	void SetOpacity(int anX, int anY, std::uint8_t anOpacity);
+	// Sets the cell's opacity from what the occluding layers hold now, after their tiles have been edited
+	void RefreshOpacity(const TilePropertyTable& someTileProperties, int anX, int anY);
+
+	std::size_t AddLight(GridPoint aPosition, int aRadius, std::uint8_t anIntensity);
+	void SetLightPosition(std::size_t aLightIndex, GridPoint aPosition);
+	void SetLightIsEnabled(std::size_t aLightIndex, bool anIsEnabled);
+	void SetViewer(GridPoint aPosition, int aRadius);
+
+	// Recomputes dirty lights, the field of view and dirty chunks, then uploads the chunks that changed.
+	// The list of dirty lights is taken from the frame allocator.
+	void Update(FrameAllocator& aFrameAllocator);
+
+	unsigned int GetTextureIdentifier() const { return myTextureIdentifier; }
+	bool GetIsVisible(int anX, int anY) const;
+	std::uint8_t GetLightLevel(int anX, int anY) const;
+
+private:
+	struct Light
+	{
+		std::vector<std::uint8_t> myLevels;
+		std::vector<std::uint32_t> myQueue;
+		std::vector<char> myIsQueued;
+		GridPoint myPosition;
+		int myRadius;
+		std::uint8_t myIntensity;
+		bool myIsEnabled;
+		bool myIsDirty;
+	};
+
+	struct Viewer
+	{
+		std::vector<std::uint8_t> myVisibility;
+		GridPoint myPosition;
+		int myRadius;
+		bool myIsEnabled;
+		bool myIsDirty;
+	};
+
+	static GridRect GetBounds(GridPoint aPosition, int aRadius);
+	static std::vector<std::uint8_t> GetTileOpacities(const TilePropertyTable& someTileProperties);
+
+	bool GetIsOpaque(int anX, int anY) const;
+	void MarkDirty(const GridRect& aRect);
+	void PropagateLight(Light& aLight) const;
+	void ComputeFieldOfView(Viewer& aViewer) const;
+	void CastLight(Viewer& aViewer, int aRow, float aStartSlope, float anEndSlope, int anXX, int anXY, int anYX, int anYY) const;
+	void ResolveChunk(std::size_t aChunkIndex);
+
+	std::vector<Light> myLights;
+	Viewer myViewer;
+	std::vector<std::uint8_t> myOpacities;
+	// Per GID, looked up again when occluding tiles are edited
+	std::vector<std::uint8_t> myTileOpacities;
+	std::vector<std::size_t> myOccludingLayers;
+	// Interleaved light level and visibility, laid out exactly like the texture
+	std::vector<std::uint8_t> myTexels;
+	std::vector<char> myDirtyChunks;
+	std::vector<std::size_t> myDirtyChunkIndices;
+	int myWidth;
+	int myHeight;
+	int myChunkColumns;
+	int myChunkRows;
+	unsigned int myTextureIdentifier;
+};
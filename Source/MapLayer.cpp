@@ -1,12 +1,40 @@
 #include "MapLayer.hpp"
+#include "JobSystem.hpp"
+#include "MemoryArena.hpp"
+#include "TilePropertyTable.hpp"
 
 #include <glad/glad.h>
+#include <glm/gtc/type_ptr.hpp>
 #include <tmxlite/TileLayer.hpp>
 
-MapLayer::MapLayer(const tmx::Map& aMap, std::size_t aLayerIndex, const std::vector<unsigned int>& aTextureIdentifier)
-	: myTilesetTextureIdentifiers(aTextureIdentifier)
+#include <algorithm>
+
+namespace MapLayerParameters
+{
+	static constexpr unsigned int ourRowsPerJob = 64;
+}
+
+MapLayer::MapLayer(const tmx::Map& aMap,
+	std::size_t aLayerIndex,
+	const std::vector<TilesetTexture>& someTilesetTextures,
+	const std::vector<std::vector<bool>>& someOpaqueTiles,
+	GeometryMode aGeometryMode,
+	unsigned int aShaderProgramIdentifier,
+	MemoryArena& aScratchArena)
+	: myTilesetTextures(someTilesetTextures)
+	, myOpaqueTiles(someOpaqueTiles)
+	, myPlacement{}
+	, myGeometryMode(aGeometryMode)
+	, myWidth(0)
+	, myHeight(0)
+	, myChunkCount(0)
+	, myIsOpaque(false)
+	, myTilesetCountLocation(glGetUniformLocation(aShaderProgramIdentifier, "uTilesetCount"))
+	, myTileStrideLocation(glGetUniformLocation(aShaderProgramIdentifier, "uTileStride"))
+	, myTileOriginLocation(glGetUniformLocation(aShaderProgramIdentifier, "uTileOrigin"))
+	, myTileExtentLocation(glGetUniformLocation(aShaderProgramIdentifier, "uTileExtent"))
 {
-	CreateSubsets(aMap, aLayerIndex);
+	CreateSubsets(aMap, aLayerIndex, aScratchArena);
 }
 
 MapLayer::~MapLayer()
@@ -21,36 +49,94 @@ MapLayer::~MapLayer()
 	}
 }
 
-void MapLayer::Draw() const
+void MapLayer::DrawOpaque() const
+{
+	DrawSubsets(true);
+}
+
+void MapLayer::DrawTransparent() const
+{
+	DrawSubsets(false);
+}
+
+void MapLayer::MarkDirty(const GridRect& aRect)
+{
+	const int top = std::max(aRect.myTop, 0);
+	const int bottom = std::min(aRect.myBottom, static_cast<int>(myHeight));
+	if (top >= bottom || aRect.myLeft >= aRect.myRight)
+		return;
+
+	for (int chunk = top / static_cast<int>(MapLayerParameters::ourRowsPerJob); chunk <= (bottom - 1) / static_cast<int>(MapLayerParameters::ourRowsPerJob); ++chunk)
+	{
+		if (!myIsChunkDirty[chunk])
+		{
+			myIsChunkDirty[chunk] = true;
+			myDirtyChunks.push_back(static_cast<std::size_t>(chunk));
+		}
+	}
+}
+
+void MapLayer::Update(const TilePropertyTable& someTileProperties, std::size_t aTableLayerIndex)
+{
+	for (const std::size_t chunk : myDirtyChunks)
+	{
+		UpdateChunk(someTileProperties, aTableLayerIndex, chunk);
+		myIsChunkDirty[chunk] = false;
+	}
+
+	myDirtyChunks.clear();
+}
+
+TilesetTexture::TilesetTexture()
+	: myTileCount(1.0f)
+	, myTileStride(1.0f)
+	, myTileOrigin(0.0f)
+	, myTileExtent(1.0f)
+	, myTextureIdentifier(0)
+{}
+
+MapLayer::Subset::Subset()
+	: myVertexBufferObject(0)
+	, myTilesetIndex(0)
+	, myLookup(0)
+	, myVertexCount(0)
+	, myVertexCapacity(0)
+{}
+
+void MapLayer::DrawSubsets(bool anIsOpaquePass) const
 {
 	glEnableVertexAttribArray(0);
 	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), nullptr);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), reinterpret_cast<void*>(3 * sizeof(float)));
 
+	constexpr GLsizei stride = TileGeometry::ourFloatsPerVertex * sizeof(float);
+	const std::size_t rangeOffset = anIsOpaquePass ? 0 : myChunkCount;
 	for (const Subset& subset : mySubsets)
 	{
+		if (subset.myVertexCount == 0)
+			continue;
+
+		const TilesetTexture& tilesetTexture = myTilesetTextures[subset.myTilesetIndex];
 		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, subset.myTextureIdentifier);
+		glBindTexture(GL_TEXTURE_2D, tilesetTexture.myTextureIdentifier);
+		glUniform2fv(myTilesetCountLocation, 1, glm::value_ptr(tilesetTexture.myTileCount));
+		glUniform2fv(myTileStrideLocation, 1, glm::value_ptr(tilesetTexture.myTileStride));
+		glUniform2fv(myTileOriginLocation, 1, glm::value_ptr(tilesetTexture.myTileOrigin));
+		glUniform2fv(myTileExtentLocation, 1, glm::value_ptr(tilesetTexture.myTileExtent));
 
 		glActiveTexture(GL_TEXTURE1);
 		glBindTexture(GL_TEXTURE_2D, subset.myLookup);
 
 		glBindBuffer(GL_ARRAY_BUFFER, subset.myVertexBufferObject);
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, nullptr);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(3 * sizeof(float)));
+		glMultiDrawArrays(GL_TRIANGLES, subset.myFirsts.data() + rangeOffset, subset.myCounts.data() + rangeOffset, static_cast<GLsizei>(myChunkCount));
 	}
 
 	glDisableVertexAttribArray(0);
 	glDisableVertexAttribArray(1);
 }
 
-MapLayer::Subset::Subset()
-	: myVertexBufferObject(0)
-	, myTextureIdentifier(0)
-	, myLookup(0)
-{}
-
-void MapLayer::CreateSubsets(const tmx::Map& aMap, std::size_t aLayerIndex)
+void MapLayer::CreateSubsets(const tmx::Map& aMap, std::size_t aLayerIndex, MemoryArena& aScratchArena)
 {
 	const std::vector<tmx::Layer::Ptr>& layers = aMap.getLayers();
 	if (aLayerIndex >= layers.size() || (layers[aLayerIndex]->getType() != tmx::Layer::Type::Tile))
@@ -62,63 +148,221 @@ void MapLayer::CreateSubsets(const tmx::Map& aMap, std::size_t aLayerIndex)
 	const tmx::TileLayer* const layer = dynamic_cast<const tmx::TileLayer*>(layers[aLayerIndex].get());
 
 	const tmx::FloatRect bounds = aMap.getBounds();
-	const float verts[] =
-	{
-		bounds.left, bounds.top, 0.0f, 0.0f, 0.0f,
-		bounds.left + bounds.width, bounds.top, 0.0f, 1.0f, 0.0f,
-		bounds.left, bounds.top + bounds.height, 0.0f, 0.0f, 1.0f,
-		bounds.left + bounds.width, bounds.top + bounds.height, 0.0f, 1.0f, 1.0f
-	};
-
 	const tmx::Vector2u& mapSize = aMap.getTileCount();
+	myWidth = mapSize.x;
+	myHeight = mapSize.y;
+
+	// Later layers sit closer to the camera so the depth test rejects whatever they cover
+	myPlacement.myLeft = bounds.left;
+	myPlacement.myTop = bounds.top;
+	myPlacement.myTileWidth = bounds.width / static_cast<float>(mapSize.x);
+	myPlacement.myTileHeight = bounds.height / static_cast<float>(mapSize.y);
+	myPlacement.myDepth = -static_cast<float>(layers.size() - aLayerIndex);
+
+	// A translucent layer can't occlude anything, regardless of its tiles
+	myIsOpaque = layer->getOpacity() >= 1.0f;
+
+	const std::vector<tmx::TileLayer::Tile>& tileIDs = layer->getTiles();
 	const std::vector<tmx::Tileset>& tilesets = aMap.getTilesets();
+	for (const tmx::Tileset& tileset : tilesets)
+		myTilesetRanges.push_back({ tileset.getFirstGID(), tileset.getTileCount() });
+
+	const bool isFlipped = std::any_of(tileIDs.begin(), tileIDs.end(), [](const tmx::TileLayer::Tile& aTile) { return aTile.flipFlags != 0; });
+	if (isFlipped)
+	{
+		myFlipFlags.resize(static_cast<std::size_t>(mapSize.x) * mapSize.y, 0);
+		for (std::size_t i = 0; i < std::min(tileIDs.size(), myFlipFlags.size()); ++i)
+			myFlipFlags[i] = tileIDs[i].flipFlags;
+	}
+
+	// The lookup is only needed until it has been uploaded
+	ArenaScope scratchScope(aScratchArena);
+	std::uint16_t* const pixelData = aScratchArena.AllocateArray<std::uint16_t>(static_cast<std::size_t>(mapSize.x) * mapSize.y * 2);
+
+	// Every chunk of rows is built by its own job into its own vertex lists, which are joined in order afterwards
+	myChunkCount = (mapSize.y + MapLayerParameters::ourRowsPerJob - 1) / MapLayerParameters::ourRowsPerJob;
+	myIsChunkDirty.assign(myChunkCount, false);
+	std::vector<char> chunkUsed(myChunkCount);
+	std::vector<std::vector<float>> chunkOpaqueVertices(myChunkCount);
+	std::vector<std::vector<float>> chunkTransparentVertices(myChunkCount);
 	for (unsigned int i = 0; i < tilesets.size(); ++i)
 	{
 		const tmx::Tileset& tileset = tilesets[i];
-		const std::vector<tmx::TileLayer::Tile>& tileIDs = layer->getTiles();
-		std::vector<std::uint16_t> pixelData;
-		bool tsUsed = false;
+		const std::vector<bool>& opaqueTiles = GetOpaqueTiles(i);
 
-		for (unsigned int y = 0; y < mapSize.y; ++y)
+		JobSystem::GetInstance().ParallelFor(myChunkCount, 1, [&](std::size_t aBegin, std::size_t anEnd)
 		{
-			for (unsigned int x = 0; x < mapSize.x; ++x)
+			for (std::size_t chunk = aBegin; chunk < anEnd; ++chunk)
 			{
-				const unsigned index = y * mapSize.x + x;
-				if (index < tileIDs.size()
-					&& tileIDs[index].ID >= tileset.getFirstGID()
-					&& tileIDs[index].ID < (tileset.getFirstGID() + tileset.getTileCount()))
-				{
-					pixelData.push_back(static_cast<std::uint16_t>((tileIDs[index].ID - tileset.getFirstGID()) + 1)); // Red channel - making sure to index relative to the tileset
-					pixelData.push_back(tileIDs[index].flipFlags); // Green channel - tile flips are performed on the shader
-					tsUsed = true;
-				}
-				else
+				const unsigned int firstRow = static_cast<unsigned int>(chunk * MapLayerParameters::ourRowsPerJob);
+				const unsigned int rowEnd = std::min(firstRow + MapLayerParameters::ourRowsPerJob, mapSize.y);
+				chunkUsed[chunk] = TileGeometry::BuildLookup(tileIDs, mapSize.x, firstRow, rowEnd, tileset.getFirstGID(), tileset.getTileCount(), pixelData);
+
+				chunkOpaqueVertices[chunk].clear();
+				chunkTransparentVertices[chunk].clear();
+				if (chunkUsed[chunk] && myGeometryMode == GeometryMode::TileRuns)
 				{
-					// Pad with empty space
-					pixelData.push_back(0);
-					pixelData.push_back(0);
+					TileGeometry::BuildRuns(pixelData + static_cast<std::size_t>(firstRow) * mapSize.x * 2,
+						mapSize.x,
+						mapSize.y,
+						firstRow,
+						rowEnd,
+						myPlacement,
+						opaqueTiles,
+						chunkOpaqueVertices[chunk],
+						chunkTransparentVertices[chunk]);
 				}
 			}
-		}
+		});
 
 		// If we have some data for this tile set, create the resources
-		if (tsUsed)
+		if (std::find(chunkUsed.begin(), chunkUsed.end(), static_cast<char>(true)) != chunkUsed.end())
+			CreateSubset(i, pixelData, chunkOpaqueVertices, chunkTransparentVertices);
+	}
+}
+
+MapLayer::Subset& MapLayer::CreateSubset(unsigned int aTilesetIndex, const std::uint16_t* aLookup, const std::vector<std::vector<float>>& someChunkOpaqueVertices, const std::vector<std::vector<float>>& someChunkTransparentVertices)
+{
+	mySubsets.emplace_back();
+	Subset& subset = mySubsets.back();
+	subset.myTilesetIndex = aTilesetIndex;
+	subset.myFirsts.assign(myChunkCount * 2, 0);
+	subset.myCounts.assign(myChunkCount * 2, 0);
+	subset.myCapacities.assign(myChunkCount * 2, 0);
+
+	// Opaque vertices of every chunk first, followed by the transparent ones
+	std::vector<float> vertices;
+	if (myGeometryMode == GeometryMode::TileRuns)
+	{
+		for (std::size_t range = 0; range < myChunkCount * 2; ++range)
+		{
+			const std::vector<float>& chunkVertices = range < myChunkCount ? someChunkOpaqueVertices[range] : someChunkTransparentVertices[range - myChunkCount];
+			subset.myFirsts[range] = static_cast<int>(vertices.size() / TileGeometry::ourFloatsPerVertex);
+			subset.myCounts[range] = static_cast<int>(chunkVertices.size() / TileGeometry::ourFloatsPerVertex);
+			subset.myCapacities[range] = subset.myCounts[range];
+			vertices.insert(vertices.end(), chunkVertices.begin(), chunkVertices.end());
+		}
+	}
+	else
+	{
+		// The quad covers the whole layer whatever its tiles, it's drawn as the first chunk's transparent range
+		TileGeometry::BuildQuad(myWidth, myHeight, myPlacement, vertices);
+		subset.myCounts[myChunkCount] = static_cast<int>(vertices.size() / TileGeometry::ourFloatsPerVertex);
+		subset.myCapacities[myChunkCount] = subset.myCounts[myChunkCount];
+	}
+
+	subset.myVertexCount = static_cast<int>(vertices.size() / TileGeometry::ourFloatsPerVertex);
+	subset.myVertexCapacity = subset.myVertexCount;
+
+	glGenBuffers(1, &subset.myVertexBufferObject);
+	glBindBuffer(GL_ARRAY_BUFFER, subset.myVertexBufferObject);
+	glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertices.size() * sizeof(float)), vertices.data(), GL_STATIC_DRAW);
+
+	glGenTextures(1, &subset.myLookup);
+	glBindTexture(GL_TEXTURE_2D, subset.myLookup);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16UI, static_cast<GLsizei>(myWidth), static_cast<GLsizei>(myHeight), 0, GL_RG_INTEGER, GL_UNSIGNED_SHORT, static_cast<const void*>(aLookup));
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	return subset;
+}
+
+void MapLayer::UpdateChunk(const TilePropertyTable& someTileProperties, std::size_t aTableLayerIndex, std::size_t aChunk)
+{
+	const unsigned int firstRow = static_cast<unsigned int>(aChunk * MapLayerParameters::ourRowsPerJob);
+	const unsigned int rowEnd = std::min(firstRow + MapLayerParameters::ourRowsPerJob, myHeight);
+	const std::size_t cellCount = static_cast<std::size_t>(rowEnd - firstRow) * myWidth;
+
+	myChunkTiles.resize(cellCount);
+	myChunkLookup.resize(cellCount * 2);
+	for (unsigned int y = firstRow; y < rowEnd; ++y)
+	{
+		for (unsigned int x = 0; x < myWidth; ++x)
+		{
+			const std::size_t cell = static_cast<std::size_t>(y) * myWidth + x;
+			tmx::TileLayer::Tile& tile = myChunkTiles[cell - static_cast<std::size_t>(firstRow) * myWidth];
+			tile.ID = someTileProperties.GetGID(aTableLayerIndex, static_cast<int>(x), static_cast<int>(y));
+			tile.flipFlags = 0;
+			if (!myFlipFlags.empty() && myFlipFlags[cell] != 0 && someTileProperties.GetOriginalGID(aTableLayerIndex, static_cast<int>(x), static_cast<int>(y)) == tile.ID)
+				tile.flipFlags = myFlipFlags[cell];
+		}
+	}
+
+	for (unsigned int i = 0; i < myTilesetRanges.size(); ++i)
+	{
+		const bool isUsed = TileGeometry::BuildLookup(myChunkTiles, myWidth, 0, rowEnd - firstRow, myTilesetRanges[i].myFirstGID, myTilesetRanges[i].myTileCount, myChunkLookup.data());
+		std::vector<Subset>::iterator subset = std::find_if(mySubsets.begin(), mySubsets.end(), [i](const Subset& aSubset) { return aSubset.myTilesetIndex == i; });
+		if (subset == mySubsets.end())
 		{
-			mySubsets.emplace_back();
-			mySubsets.back().myTextureIdentifier = myTilesetTextureIdentifiers[i];
+			if (!isUsed)
+				continue;
+
+			// The first tile of a tileset the layer didn't use yet, everything outside this chunk is still empty
+			const std::vector<std::uint16_t> emptyLookup(static_cast<std::size_t>(myWidth) * myHeight * 2, 0);
+			const std::vector<std::vector<float>> noVertices(myChunkCount);
+			CreateSubset(i, emptyLookup.data(), noVertices, noVertices);
+			subset = mySubsets.end() - 1;
+		}
+
+		glBindTexture(GL_TEXTURE_2D, subset->myLookup);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, static_cast<GLint>(firstRow), static_cast<GLsizei>(myWidth), static_cast<GLsizei>(rowEnd - firstRow), GL_RG_INTEGER, GL_UNSIGNED_SHORT, myChunkLookup.data());
+
+		if (myGeometryMode != GeometryMode::TileRuns)
+			continue;
+
+		myOpaqueVertices.clear();
+		myTransparentVertices.clear();
+		if (isUsed)
+			TileGeometry::BuildRuns(myChunkLookup.data(), myWidth, myHeight, firstRow, rowEnd, myPlacement, GetOpaqueTiles(i), myOpaqueVertices, myTransparentVertices);
 
-			glGenBuffers(1, &mySubsets.back().myVertexBufferObject);
-			glBindBuffer(GL_ARRAY_BUFFER, mySubsets.back().myVertexBufferObject);
-			glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
+		WriteVertices(*subset, aChunk, myOpaqueVertices);
+		WriteVertices(*subset, myChunkCount + aChunk, myTransparentVertices);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
 
-			glGenTextures(1, &mySubsets.back().myLookup);
-			glBindTexture(GL_TEXTURE_2D, mySubsets.back().myLookup);
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16UI, static_cast<GLsizei>(mapSize.x), static_cast<GLsizei>(mapSize.y), 0, GL_RG_INTEGER, GL_UNSIGNED_SHORT, static_cast<void*>(pixelData.data()));
+void MapLayer::WriteVertices(Subset& aSubset, std::size_t aRange, const std::vector<float>& someVertices)
+{
+	const int count = static_cast<int>(someVertices.size() / TileGeometry::ourFloatsPerVertex);
+	constexpr GLsizeiptr vertexSize = TileGeometry::ourFloatsPerVertex * sizeof(float);
+	glBindBuffer(GL_ARRAY_BUFFER, aSubset.myVertexBufferObject);
+
+	// A range that outgrew its room moves to the end of the buffer, the buffer doubles when that's full too
+	if (count > aSubset.myCapacities[aRange])
+	{
+		if (aSubset.myVertexCount + count > aSubset.myVertexCapacity)
+		{
+			const int capacity = std::max(aSubset.myVertexCapacity * 2, aSubset.myVertexCount + count);
+			unsigned int buffer = 0;
+			glGenBuffers(1, &buffer);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+			glBufferData(GL_COPY_WRITE_BUFFER, capacity * vertexSize, nullptr, GL_STATIC_DRAW);
+			glBindBuffer(GL_COPY_READ_BUFFER, aSubset.myVertexBufferObject);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, aSubset.myVertexCount * vertexSize);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			glDeleteBuffers(1, &aSubset.myVertexBufferObject);
 
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			aSubset.myVertexBufferObject = buffer;
+			aSubset.myVertexCapacity = capacity;
+			glBindBuffer(GL_ARRAY_BUFFER, buffer);
 		}
+
+		aSubset.myFirsts[aRange] = aSubset.myVertexCount;
+		aSubset.myCapacities[aRange] = count;
+		aSubset.myVertexCount += count;
 	}
+
+	aSubset.myCounts[aRange] = count;
+	if (count > 0)
+		glBufferSubData(GL_ARRAY_BUFFER, aSubset.myFirsts[aRange] * vertexSize, count * vertexSize, someVertices.data());
+}
+
+const std::vector<bool>& MapLayer::GetOpaqueTiles(unsigned int aTilesetIndex) const
+{
+	static const std::vector<bool> ourNoOpaqueTiles;
+	return myIsOpaque && aTilesetIndex < myOpaqueTiles.size() ? myOpaqueTiles[aTilesetIndex] : ourNoOpaqueTiles;
 }
@@ -1,19 +1,59 @@
 #pragma once
 
+#include "TileGeometry.hpp"
+
+#include <glm/vec2.hpp>
 #include <tmxlite/Map.hpp>
 
 #include <vector>
 
+class MemoryArena;
+class TilePropertyTable;
+struct GridRect;
+
+// A tileset's texture and where its tiles are in it, in texture coordinates so baked and plain images are
+// drawn the same way
+struct TilesetTexture
+{
+	TilesetTexture();
+
+	glm::vec2 myTileCount;
+	// From the top left of one tile to the next
+	glm::vec2 myTileStride;
+	// Top left of the first tile
+	glm::vec2 myTileOrigin;
+	glm::vec2 myTileExtent;
+	unsigned int myTextureIdentifier;
+};
+
 class MapLayer final
 {
 public:
-	MapLayer(const tmx::Map& aMap, std::size_t aLayerIndex, const std::vector<unsigned>& aTextureIdentifier);
+	enum class GeometryMode
+	{
+		FullQuad,
+		TileRuns
+	};
+
+	MapLayer(const tmx::Map& aMap,
+		std::size_t aLayerIndex,
+		const std::vector<TilesetTexture>& someTilesetTextures,
+		const std::vector<std::vector<bool>>& someOpaqueTiles,
+		GeometryMode aGeometryMode,
+		unsigned int aShaderProgramIdentifier,
+		MemoryArena& aScratchArena);
 	~MapLayer();
 
 	MapLayer(const MapLayer&) = delete;
 	MapLayer& operator=(const MapLayer&) = delete;
 
-	void Draw() const;
+	void DrawOpaque() const;
+	void DrawTransparent() const;
+
+	// Edited tiles are rebuilt from the tile table by Update, a chunk of rows at a time. Flip flags only stay on
+	// tiles that are still the ones loaded, anything placed by an edit is drawn unflipped.
+	void MarkDirty(const GridRect& aRect);
+	void Update(const TilePropertyTable& someTileProperties, std::size_t aTableLayerIndex);
 
 private:
 	struct Subset
@@ -21,12 +61,51 @@ private:
 		Subset();
 
 		unsigned int myVertexBufferObject;
-		unsigned int myTextureIdentifier;
+		unsigned int myTilesetIndex;
 		unsigned int myLookup;
+		// Where every chunk's opaque vertices are in the buffer, followed by where its transparent ones are.
+		// A chunk keeps the room it was given, so a rebuilt chunk that still fits is written in place.
+		std::vector<int> myFirsts;
+		std::vector<int> myCounts;
+		std::vector<int> myCapacities;
+		int myVertexCount;
+		int myVertexCapacity;
+	};
+
+	struct TilesetRange
+	{
+		std::uint32_t myFirstGID;
+		std::uint32_t myTileCount;
 	};
 
-	void CreateSubsets(const tmx::Map& aMap, std::size_t aLayerIndex);
+	void CreateSubsets(const tmx::Map& aMap, std::size_t aLayerIndex, MemoryArena& aScratchArena);
+	Subset& CreateSubset(unsigned int aTilesetIndex, const std::uint16_t* aLookup, const std::vector<std::vector<float>>& someChunkOpaqueVertices, const std::vector<std::vector<float>>& someChunkTransparentVertices);
+	void UpdateChunk(const TilePropertyTable& someTileProperties, std::size_t aTableLayerIndex, std::size_t aChunk);
+	void WriteVertices(Subset& aSubset, std::size_t aRange, const std::vector<float>& someVertices);
+	const std::vector<bool>& GetOpaqueTiles(unsigned int aTilesetIndex) const;
+	void DrawSubsets(bool anIsOpaquePass) const;
 
 	std::vector<Subset> mySubsets;
-	const std::vector<unsigned int>& myTilesetTextureIdentifiers;
+	std::vector<TilesetRange> myTilesetRanges;
+	// Flip flags as loaded, empty when the layer has no flipped tiles
+	std::vector<std::uint8_t> myFlipFlags;
+	std::vector<char> myIsChunkDirty;
+	std::vector<std::size_t> myDirtyChunks;
+	// Reused between updates so editing doesn't allocate once they've grown
+	std::vector<tmx::TileLayer::Tile> myChunkTiles;
+	std::vector<std::uint16_t> myChunkLookup;
+	std::vector<float> myOpaqueVertices;
+	std::vector<float> myTransparentVertices;
+	const std::vector<TilesetTexture>& myTilesetTextures;
+	const std::vector<std::vector<bool>>& myOpaqueTiles;
+	TileGeometry::Placement myPlacement;
+	GeometryMode myGeometryMode;
+	unsigned int myWidth;
+	unsigned int myHeight;
+	std::size_t myChunkCount;
+	bool myIsOpaque;
+	int myTilesetCountLocation;
+	int myTileStrideLocation;
+	int myTileOriginLocation;
+	int myTileExtentLocation;
 };
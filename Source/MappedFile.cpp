@@ -0,0 +1,128 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <utility>
+
+MappedFile::MappedFile()
+	: myData(nullptr)
+	, mySize(0)
+	, myIsOpen(false)
+{}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+MappedFile::MappedFile(MappedFile&& anOther) noexcept
+	: myData(std::exchange(anOther.myData, nullptr))
+	, mySize(std::exchange(anOther.mySize, 0))
+	, myIsOpen(std::exchange(anOther.myIsOpen, false))
+{}
+
+MappedFile& MappedFile::operator=(MappedFile&& anOther) noexcept
+{
+	if (this != &anOther)
+	{
+		Close();
+		myData = std::exchange(anOther.myData, nullptr);
+		mySize = std::exchange(anOther.mySize, 0);
+		myIsOpen = std::exchange(anOther.myIsOpen, false);
+	}
+
+	return *this;
+}
+
+// The file and mapping handles are closed as soon as the view exists, the view alone keeps the file mapped
+bool MappedFile::Open(const char* aFilepath)
+{
+	Close();
+
+#ifdef _WIN32
+	const HANDLE file = CreateFileA(aFilepath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	// Empty files can't be mapped but are still valid files
+	if (size.QuadPart > 0)
+	{
+		const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping)
+		{
+			myData = static_cast<const std::uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			CloseHandle(mapping);
+		}
+
+		if (!myData)
+		{
+			CloseHandle(file);
+			return false;
+		}
+	}
+
+	CloseHandle(file);
+	mySize = static_cast<std::size_t>(size.QuadPart);
+#else
+	const int file = open(aFilepath, O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat status;
+	if (fstat(file, &status) != 0)
+	{
+		close(file);
+		return false;
+	}
+
+	if (status.st_size > 0)
+	{
+		void* data = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		if (data == MAP_FAILED)
+		{
+			close(file);
+			return false;
+		}
+
+		myData = static_cast<const std::uint8_t*>(data);
+	}
+
+	close(file);
+	mySize = static_cast<std::size_t>(status.st_size);
+#endif
+
+	myIsOpen = true;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (myData)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(myData);
+#else
+		munmap(const_cast<std::uint8_t*>(myData), mySize);
+#endif
+	}
+
+	myData = nullptr;
+	mySize = 0;
+	myIsOpen = false;
+}
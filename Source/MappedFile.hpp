@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// A read-only view of a whole file mapped into memory, pages are only read once they're touched
+class MappedFile final
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(MappedFile&& anOther) noexcept;
+	MappedFile& operator=(MappedFile&& anOther) noexcept;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const char* aFilepath);
+	void Close();
+
+	bool GetIsOpen() const { return myIsOpen; }
+	const std::uint8_t* GetData() const { return myData; }
+	std::size_t GetSize() const { return mySize; }
+
+private:
+	const std::uint8_t* myData;
+	std::size_t mySize;
+	bool myIsOpen;
+};
@@ -0,0 +1,79 @@
+#include "MemoryArena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+static std::size_t GetAlignedOffset(const std::byte* aBase, std::size_t anOffset, std::size_t anAlignment)
+{
+	const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(aBase) + anOffset;
+	const std::uintptr_t alignedAddress = (address + (anAlignment - 1)) & ~static_cast<std::uintptr_t>(anAlignment - 1);
+	return anOffset + static_cast<std::size_t>(alignedAddress - address);
+}
+
+MemoryArena::MemoryArena(std::size_t aBlockSize)
+	: myBlockSize(aBlockSize)
+	, myCurrentBlock(0)
+	, myOffset(0)
+	, myUsedBytes(0)
+	, myHighWaterMark(0)
+{}
+
+void* MemoryArena::Allocate(std::size_t aSize, std::size_t anAlignment)
+{
+	// Try the current block first, then any blocks kept around from before a rewind
+	while (myCurrentBlock < myBlocks.size())
+	{
+		Block& block = myBlocks[myCurrentBlock];
+		const std::size_t alignedOffset = GetAlignedOffset(block.myMemory.get(), myOffset, anAlignment);
+		if (alignedOffset + aSize <= block.mySize)
+		{
+			myUsedBytes += (alignedOffset - myOffset) + aSize;
+			myHighWaterMark = std::max(myHighWaterMark, myUsedBytes);
+			myOffset = alignedOffset + aSize;
+			return block.myMemory.get() + alignedOffset;
+		}
+
+		myUsedBytes += block.mySize - myOffset;
+		++myCurrentBlock;
+		myOffset = 0;
+	}
+
+	Block block;
+	block.mySize = std::max(myBlockSize, aSize + anAlignment);
+	block.myMemory = std::make_unique<std::byte[]>(block.mySize);
+	myBlocks.emplace_back(std::move(block));
+	myCurrentBlock = myBlocks.size() - 1;
+	myOffset = 0;
+
+	return Allocate(aSize, anAlignment);
+}
+
+MemoryArena::Marker MemoryArena::GetMarker() const
+{
+	return { myCurrentBlock, myOffset };
+}
+
+void MemoryArena::Rewind(const Marker& aMarker)
+{
+	std::size_t usedBytes = aMarker.myOffset;
+	for (std::size_t i = 0; i < aMarker.myBlockIndex && i < myBlocks.size(); ++i)
+		usedBytes += myBlocks[i].mySize;
+
+	myCurrentBlock = aMarker.myBlockIndex;
+	myOffset = aMarker.myOffset;
+	myUsedBytes = usedBytes;
+}
+
+void MemoryArena::Reset()
+{
+	Rewind({ 0, 0 });
+}
+
+std::size_t MemoryArena::GetReservedBytes() const
+{
+	std::size_t reservedBytes = 0;
+	for (const Block& block : myBlocks)
+		reservedBytes += block.mySize;
+
+	return reservedBytes;
+}
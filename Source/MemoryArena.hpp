@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Linear allocator for load-time temporaries. Memory is handed out from large blocks
+// and only returned in bulk, either by rewinding to a marker or by resetting the arena.
+class MemoryArena final
+{
+public:
+	struct Marker
+	{
+		std::size_t myBlockIndex;
+		std::size_t myOffset;
+	};
+
+	explicit MemoryArena(std::size_t aBlockSize);
+
+	MemoryArena(const MemoryArena&) = delete;
+	MemoryArena& operator=(const MemoryArena&) = delete;
+
+	void* Allocate(std::size_t aSize, std::size_t anAlignment = alignof(std::max_align_t));
+
+	template<typename T>
+	T* AllocateArray(std::size_t aCount)
+	{
+		return static_cast<T*>(Allocate(sizeof(T) * aCount, alignof(T)));
+	}
+
+	Marker GetMarker() const;
+	void Rewind(const Marker& aMarker);
+	void Reset();
+
+	std::size_t GetUsedBytes() const { return myUsedBytes; }
+	std::size_t GetReservedBytes() const;
+	std::size_t GetHighWaterMark() const { return myHighWaterMark; }
+
+private:
+	struct Block
+	{
+		std::unique_ptr<std::byte[]> myMemory;
+		std::size_t mySize;
+	};
+
+	std::vector<Block> myBlocks;
+	std::size_t myBlockSize;
+	std::size_t myCurrentBlock;
+	std::size_t myOffset;
+	std::size_t myUsedBytes;
+	std::size_t myHighWaterMark;
+};
+
+// Rewinds the arena to where it was when the scope was entered
+class ArenaScope final
+{
+public:
+	explicit ArenaScope(MemoryArena& anArena)
+		: myArena(anArena)
+		, myMarker(anArena.GetMarker())
+	{}
+
+	~ArenaScope() { myArena.Rewind(myMarker); }
+
+	ArenaScope(const ArenaScope&) = delete;
+	ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+	MemoryArena& myArena;
+	MemoryArena::Marker myMarker;
+};
+
+// Lets standard containers draw from an arena; deallocation is a no-op until the arena rewinds
+template<typename T>
+class ArenaAllocator
+{
+public:
+	using value_type = T;
+
+	explicit ArenaAllocator(MemoryArena& anArena)
+		: myArena(&anArena)
+	{}
+
+	template<typename U>
+	ArenaAllocator(const ArenaAllocator<U>& anOther)
+		: myArena(anOther.GetArena())
+	{}
+
+	T* allocate(std::size_t aCount) { return myArena->AllocateArray<T>(aCount); }
+	void deallocate(T*, std::size_t) {}
+
+	MemoryArena* GetArena() const { return myArena; }
+
+	template<typename U>
+	bool operator==(const ArenaAllocator<U>& anOther) const { return myArena == anOther.GetArena(); }
+
+	template<typename U>
+	bool operator!=(const ArenaAllocator<U>& anOther) const { return myArena != anOther.GetArena(); }
+
+private:
+	MemoryArena* myArena;
+};
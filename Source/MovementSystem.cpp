@@ -0,0 +1,34 @@
+#include "MovementSystem.hpp"
+#include "EntityStore.hpp"
+#include "JobSystem.hpp"
+
+namespace MovementSystemParameters
+{
+	static constexpr std::size_t ourEntitiesPerJob = 16384;
+}
+
+namespace MovementSystem
+{
+	void UpdateRange(EntityStore& aStore, float aDeltaTime, std::size_t aBegin, std::size_t anEnd)
+	{
+		// Separate, non-aliasing columns let the compiler vectorise this loop
+		float* __restrict positionsX = aStore.GetPositionsX();
+		float* __restrict positionsY = aStore.GetPositionsY();
+		const float* __restrict velocitiesX = aStore.GetVelocitiesX();
+		const float* __restrict velocitiesY = aStore.GetVelocitiesY();
+
+		for (std::size_t i = aBegin; i < anEnd; ++i)
+		{
+			positionsX[i] += velocitiesX[i] * aDeltaTime;
+			positionsY[i] += velocitiesY[i] * aDeltaTime;
+		}
+	}
+
+	void Update(EntityStore& aStore, float aDeltaTime)
+	{
+		JobSystem::GetInstance().ParallelFor(aStore.GetCount(), MovementSystemParameters::ourEntitiesPerJob, [&aStore, aDeltaTime](std::size_t aBegin, std::size_t anEnd)
+		{
+			UpdateRange(aStore, aDeltaTime, aBegin, anEnd);
+		});
+	}
+} // namespace MovementSystem
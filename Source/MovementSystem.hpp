@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+
+class EntityStore;
+
+namespace MovementSystem
+{
+	// Integrates velocity into position for the entities in [aBegin, anEnd)
+	void UpdateRange(EntityStore& aStore, float aDeltaTime, std::size_t aBegin, std::size_t anEnd);
+
+	// Splits the store into chunks and updates them on the job system
+	void Update(EntityStore& aStore, float aDeltaTime);
+} // namespace MovementSystem
@@ -0,0 +1,46 @@
+#include "NavigationGrid.hpp"
+#include "TilePropertyTable.hpp"
+
+#include <tmxlite/TileLayer.hpp>
+
+#include <algorithm>
+
+NavigationGrid::NavigationGrid(int aWidth, int aHeight)
+	: myCells(static_cast<std::size_t>(aWidth) * aHeight, 1)
+	, myWidth(aWidth)
+	, myHeight(aHeight)
+{}
+
+void NavigationGrid::AddBlockingLayer(const tmx::TileLayer& aLayer)
+{
+	const std::vector<tmx::TileLayer::Tile>& tiles = aLayer.getTiles();
+	const std::size_t cellCount = std::min(tiles.size(), myCells.size());
+	for (std::size_t i = 0; i < cellCount; ++i)
+	{
+		if (tiles[i].ID != 0)
+			myCells[i] = 0;
+	}
+}
+
+void NavigationGrid::AddBlockingTiles(const TilePropertyTable& someTileProperties, std::uint64_t aFlagMask)
+{
+	if (aFlagMask == 0)
+		return;
+
+	for (int y = 0; y < myHeight; ++y)
+	{
+		for (int x = 0; x < myWidth; ++x)
+		{
+			if (someTileProperties.GetHasAnyFlag(x, y, aFlagMask))
+				myCells[static_cast<std::size_t>(y) * myWidth + x] = 0;
+		}
+	}
+}
+
+void NavigationGrid::SetIsWalkable(int anX, int anY, bool anIsWalkable)
+{
+	if (anX < 0 || anY < 0 || anX >= myWidth || anY >= myHeight)
+		return;
+
+	myCells[static_cast<std::size_t>(anY) * myWidth + anX] = anIsWalkable ? 1 : 0;
+}
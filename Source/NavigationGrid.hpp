@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tmx
+{
+	class TileLayer;
+}
+
+class TilePropertyTable;
+
+struct GridPoint
+{
+	int myX;
+	int myY;
+
+	bool operator==(const GridPoint& anOther) const { return myX == anOther.myX && myY == anOther.myY; }
+	bool operator!=(const GridPoint& anOther) const { return !(*this == anOther); }
+};
+
+// Half-open rectangle of cells, [myLeft, myRight) x [myTop, myBottom)
+struct GridRect
+{
+	int myLeft;
+	int myTop;
+	int myRight;
+	int myBottom;
+
+	bool GetContains(int anX, int anY) const { return anX >= myLeft && anX < myRight && anY >= myTop && anY < myBottom; }
+};
+
+class NavigationGrid final
+{
+public:
+	NavigationGrid(int aWidth, int aHeight);
+
+	// Every non-empty tile in the layer blocks movement
+	void AddBlockingLayer(const tmx::TileLayer& aLayer);
+	// Every cell where a tile on any layer has one of the flags blocks movement
+	void AddBlockingTiles(const TilePropertyTable& someTileProperties, std::uint64_t aFlagMask);
+
+	bool GetIsWalkable(int anX, int anY) const
+	{
+		return anX >= 0 && anY >= 0 && anX < myWidth && anY < myHeight && myCells[static_cast<std::size_t>(anY) * myWidth + anX] != 0;
+	}
+
+	void SetIsWalkable(int anX, int anY, bool anIsWalkable);
+
+	int GetWidth() const { return myWidth; }
+	int GetHeight() const { return myHeight; }
+	GridRect GetBounds() const { return { 0, 0, myWidth, myHeight }; }
+
+private:
+	std::vector<std::uint8_t> myCells;
+	int myWidth;
+	int myHeight;
+};
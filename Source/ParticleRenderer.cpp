@@ -0,0 +1,174 @@
+#include "ParticleRenderer.hpp"
+#include "ParticleSystem.hpp"
+#include "Shader.hpp"
+#include "VirtualFileSystem.hpp"
+
+#include <glad/glad.h>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace ParticleRendererParameters
+{
+	static constexpr GLuint64 ourFenceTimeout = 1000000000;
+	static constexpr GLsizei ourVerticesPerParticle = 4;
+}
+
+ParticleRenderer::ParticleRenderer(const std::vector<ParticleMaterial>& someMaterials, std::size_t aCapacityPerMaterial)
+	: myMaterials(someMaterials)
+	, myMappedInstances(nullptr)
+	, myCapacity(aCapacityPerMaterial)
+	, myRegionIndex(0)
+	, myBufferIdentifier(0)
+	, myVertexArrayIdentifier(0)
+	, myShaderProgramIdentifier(0)
+	, myModelViewProjectionLocation(-1)
+	, myStartColorLocation(-1)
+	, myEndColorLocation(-1)
+	, myIsPersistent(GLAD_GL_VERSION_4_4 != 0)
+{
+	myFences.fill(nullptr);
+	LoadShader();
+
+	const GLsizeiptr regionSize = static_cast<GLsizeiptr>(myMaterials.size() * myCapacity * ParticleSystem::ourFloatsPerInstance * sizeof(float));
+	glGenBuffers(1, &myBufferIdentifier);
+	glBindBuffer(GL_ARRAY_BUFFER, myBufferIdentifier);
+	if (myIsPersistent)
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER, regionSize * ourRegionCount, nullptr, flags);
+		myMappedInstances = static_cast<float*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, regionSize * ourRegionCount, flags));
+	}
+	else
+	{
+		glBufferData(GL_ARRAY_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+	}
+
+	// The tile layers draw without a vertex array object of their own, so the instance divisor is kept out of theirs
+	glGenVertexArrays(1, &myVertexArrayIdentifier);
+	glBindVertexArray(myVertexArrayIdentifier);
+	glEnableVertexAttribArray(0);
+	glVertexAttribDivisor(0, 1);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+ParticleRenderer::~ParticleRenderer()
+{
+	for (void* fence : myFences)
+	{
+		if (fence)
+			glDeleteSync(static_cast<GLsync>(fence));
+	}
+
+	if (myMappedInstances)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, myBufferIdentifier);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	if (myBufferIdentifier)
+		glDeleteBuffers(1, &myBufferIdentifier);
+
+	if (myVertexArrayIdentifier)
+		glDeleteVertexArrays(1, &myVertexArrayIdentifier);
+
+	if (myShaderProgramIdentifier)
+		glDeleteProgram(myShaderProgramIdentifier);
+}
+
+void ParticleRenderer::Draw(const ParticleSystem& aParticleSystem, const glm::mat4& aModelViewProjection)
+{
+	const std::size_t materialFloatCount = myCapacity * ParticleSystem::ourFloatsPerInstance;
+	const std::size_t regionFloatCount = myMaterials.size() * materialFloatCount;
+
+	glBindBuffer(GL_ARRAY_BUFFER, myBufferIdentifier);
+
+	// Writing a region the GPU may still read from has to wait for the frame that last used it
+	float* instances = nullptr;
+	std::size_t regionOffset = 0;
+	if (myIsPersistent)
+	{
+		void*& fence = myFences[myRegionIndex];
+		if (fence)
+		{
+			glClientWaitSync(static_cast<GLsync>(fence), GL_SYNC_FLUSH_COMMANDS_BIT, ParticleRendererParameters::ourFenceTimeout);
+			glDeleteSync(static_cast<GLsync>(fence));
+			fence = nullptr;
+		}
+
+		regionOffset = myRegionIndex * regionFloatCount;
+		instances = myMappedInstances + regionOffset;
+	}
+	else
+	{
+		const GLsizeiptr regionSize = static_cast<GLsizeiptr>(regionFloatCount * sizeof(float));
+		glBufferData(GL_ARRAY_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+		instances = static_cast<float*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, regionSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+		if (!instances)
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			return;
+		}
+	}
+
+	for (std::size_t material = 0; material < myMaterials.size(); ++material)
+		aParticleSystem.WriteInstances(material, instances + material * materialFloatCount);
+
+	if (!myIsPersistent)
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+
+	// Particles draw over the map without testing or writing depth
+	glUseProgram(myShaderProgramIdentifier);
+	glUniformMatrix4fv(myModelViewProjectionLocation, 1, GL_FALSE, glm::value_ptr(aModelViewProjection));
+	glBindVertexArray(myVertexArrayIdentifier);
+	glDisable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+	glEnable(GL_BLEND);
+
+	constexpr GLsizei stride = ParticleSystem::ourFloatsPerInstance * sizeof(float);
+	for (std::size_t material = 0; material < myMaterials.size(); ++material)
+	{
+		const std::size_t count = aParticleSystem.GetCount(material);
+		if (count == 0)
+			continue;
+
+		const ParticleMaterial& particleMaterial = myMaterials[material];
+		glBlendFunc(GL_SRC_ALPHA, particleMaterial.myIsAdditive ? GL_ONE : GL_ONE_MINUS_SRC_ALPHA);
+		glUniform4fv(myStartColorLocation, 1, particleMaterial.myStartColor.data());
+		glUniform4fv(myEndColorLocation, 1, particleMaterial.myEndColor.data());
+		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>((regionOffset + material * materialFloatCount) * sizeof(float)));
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, ParticleRendererParameters::ourVerticesPerParticle, static_cast<GLsizei>(count));
+	}
+
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDepthMask(GL_TRUE);
+	glEnable(GL_DEPTH_TEST);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (myIsPersistent)
+	{
+		myFences[myRegionIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		myRegionIndex = (myRegionIndex + 1) % ourRegionCount;
+	}
+}
+
+void ParticleRenderer::LoadShader()
+{
+	myShaderProgramIdentifier = glCreateProgram();
+	Shader vertexShader;
+	Shader fragmentShader;
+	VirtualFileSystem& fileSystem = VirtualFileSystem::GetInstance();
+	vertexShader.AttachShader(myShaderProgramIdentifier, GL_VERTEX_SHADER, fileSystem.ReadFile("Data/Shaders/ParticleVertexShader.glsl"));
+	fragmentShader.AttachShader(myShaderProgramIdentifier, GL_FRAGMENT_SHADER, fileSystem.ReadFile("Data/Shaders/ParticleFragmentShader.glsl"));
+
+	glBindAttribLocation(myShaderProgramIdentifier, 0, "aInstance");
+	glLinkProgram(myShaderProgramIdentifier);
+
+	vertexShader.CheckShaderLinkStatus(myShaderProgramIdentifier);
+	fragmentShader.CheckShaderLinkStatus(myShaderProgramIdentifier);
+
+	myModelViewProjectionLocation = glGetUniformLocation(myShaderProgramIdentifier, "uModelViewProjection");
+	myStartColorLocation = glGetUniformLocation(myShaderProgramIdentifier, "uStartColor");
+	myEndColorLocation = glGetUniformLocation(myShaderProgramIdentifier, "uEndColor");
+}
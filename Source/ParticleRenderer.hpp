@@ -0,0 +1,52 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+class ParticleSystem;
+
+struct ParticleMaterial
+{
+	// Particles fade from the start to the end colour over their life
+	std::array<float, 4> myStartColor;
+	std::array<float, 4> myEndColor;
+	bool myIsAdditive;
+};
+
+// Draws every material of a particle system with one instanced draw of a quad per particle. Instances are
+// written straight into a persistently mapped buffer split into a few regions, each guarded by a fence so a
+// region is only rewritten once the GPU is done drawing from it. Without buffer storage the buffer is orphaned
+// and mapped again every frame instead.
+class ParticleRenderer final
+{
+public:
+	ParticleRenderer(const std::vector<ParticleMaterial>& someMaterials, std::size_t aCapacityPerMaterial);
+	~ParticleRenderer();
+
+	ParticleRenderer(const ParticleRenderer&) = delete;
+	ParticleRenderer& operator=(const ParticleRenderer&) = delete;
+
+	// Expects the system to have as many materials and as much capacity as the renderer
+	void Draw(const ParticleSystem& aParticleSystem, const glm::mat4& aModelViewProjection);
+
+private:
+	static constexpr std::size_t ourRegionCount = 3;
+
+	void LoadShader();
+
+	std::vector<ParticleMaterial> myMaterials;
+	std::array<void*, ourRegionCount> myFences;
+	float* myMappedInstances;
+	std::size_t myCapacity;
+	std::size_t myRegionIndex;
+	unsigned int myBufferIdentifier;
+	unsigned int myVertexArrayIdentifier;
+	unsigned int myShaderProgramIdentifier;
+	int myModelViewProjectionLocation;
+	int myStartColorLocation;
+	int myEndColorLocation;
+	bool myIsPersistent;
+};
@@ -0,0 +1,227 @@
+#include "ParticleSystem.hpp"
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define PARTICLE_SYSTEM_USE_SSE 1
+#include <xmmintrin.h>
+#else
+#define PARTICLE_SYSTEM_USE_SSE 0
+#endif
+
+namespace ParticleSystemParameters
+{
+	// Multiples of four so only the last job of a pool has a scalar tail
+	static constexpr std::size_t ourParticlesPerJob = 16384;
+	static constexpr std::size_t ourInstancesPerJob = 16384;
+	static constexpr std::uint32_t ourRandomSeed = 0x9E3779B9u;
+}
+
+ParticleSystem::ParticleSystem(std::size_t aMaterialCount, std::size_t aCapacityPerMaterial)
+	: myPools(aMaterialCount)
+	, myCapacity(aCapacityPerMaterial)
+	, myDeltaTime(0.0f)
+	, myGravityX(0.0f)
+	, myGravityY(0.0f)
+	, myRandomState(ParticleSystemParameters::ourRandomSeed)
+{
+	for (Pool& pool : myPools)
+	{
+		for (std::vector<float>* column : { &pool.myPositionsX, &pool.myPositionsY, &pool.myVelocitiesX, &pool.myVelocitiesY, &pool.myLives, &pool.myLifeRates, &pool.mySizes })
+			column->assign(aCapacityPerMaterial, 0.0f);
+
+		pool.myCount = 0;
+	}
+}
+
+std::size_t ParticleSystem::AddEmitter(const ParticleEmitter& anEmitter)
+{
+	myEmitters.push_back(anEmitter);
+	myEmitAccumulators.push_back(0.0f);
+	return myEmitters.size() - 1;
+}
+
+void ParticleSystem::Emit(std::size_t anEmitterIndex, std::size_t aCount)
+{
+	Spawn(myEmitters[anEmitterIndex], aCount);
+}
+
+void ParticleSystem::SetGravity(float anX, float aY)
+{
+	myGravityX = anX;
+	myGravityY = aY;
+}
+
+void ParticleSystem::Update(float aDeltaTime)
+{
+	for (std::size_t i = 0; i < myEmitters.size(); ++i)
+	{
+		const ParticleEmitter& emitter = myEmitters[i];
+		if (!emitter.myIsEnabled)
+		{
+			myEmitAccumulators[i] = 0.0f;
+			continue;
+		}
+
+		myEmitAccumulators[i] += emitter.myRate * aDeltaTime;
+		const float count = std::floor(myEmitAccumulators[i]);
+		myEmitAccumulators[i] -= count;
+		Spawn(emitter, static_cast<std::size_t>(count));
+	}
+
+	// The delta time is a member so the lambda's captures fit std::function's inline storage and don't allocate
+	myDeltaTime = aDeltaTime;
+	for (Pool& pool : myPools)
+	{
+		JobSystem::GetInstance().ParallelFor(pool.myCount, ParticleSystemParameters::ourParticlesPerJob, [this, &pool](std::size_t aBegin, std::size_t anEnd)
+			{
+				Integrate(pool, aBegin, anEnd);
+			});
+
+		RemoveDead(pool);
+	}
+}
+
+void ParticleSystem::WriteInstances(std::size_t aMaterial, float* someInstances) const
+{
+	const Pool& pool = myPools[aMaterial];
+	JobSystem::GetInstance().ParallelFor(pool.myCount, ParticleSystemParameters::ourInstancesPerJob, [&pool, someInstances](std::size_t aBegin, std::size_t anEnd)
+		{
+			const float* positionsX = pool.myPositionsX.data();
+			const float* positionsY = pool.myPositionsY.data();
+			const float* sizes = pool.mySizes.data();
+			const float* lives = pool.myLives.data();
+
+			std::size_t i = aBegin;
+#if PARTICLE_SYSTEM_USE_SSE
+			// Transposing four columns of four particles gives four instances in a row
+			for (; i + 4 <= anEnd; i += 4)
+			{
+				__m128 x = _mm_loadu_ps(positionsX + i);
+				__m128 y = _mm_loadu_ps(positionsY + i);
+				__m128 size = _mm_loadu_ps(sizes + i);
+				__m128 life = _mm_loadu_ps(lives + i);
+				_MM_TRANSPOSE4_PS(x, y, size, life);
+
+				float* instances = someInstances + i * ourFloatsPerInstance;
+				_mm_storeu_ps(instances, x);
+				_mm_storeu_ps(instances + 4, y);
+				_mm_storeu_ps(instances + 8, size);
+				_mm_storeu_ps(instances + 12, life);
+			}
+#endif
+			for (; i < anEnd; ++i)
+			{
+				float* instance = someInstances + i * ourFloatsPerInstance;
+				instance[0] = positionsX[i];
+				instance[1] = positionsY[i];
+				instance[2] = sizes[i];
+				instance[3] = lives[i];
+			}
+		});
+}
+
+void ParticleSystem::Spawn(const ParticleEmitter& anEmitter, std::size_t aCount)
+{
+	Pool& pool = myPools[anEmitter.myMaterial];
+	const std::size_t count = std::min(aCount, myCapacity - pool.myCount);
+	for (std::size_t i = pool.myCount; i < pool.myCount + count; ++i)
+	{
+		const float angle = anEmitter.myDirection + GetRandom(-0.5f, 0.5f) * anEmitter.mySpread;
+		const float speed = GetRandom(anEmitter.mySpeedMinimum, anEmitter.mySpeedMaximum);
+		pool.myPositionsX[i] = anEmitter.myPositionX;
+		pool.myPositionsY[i] = anEmitter.myPositionY;
+		pool.myVelocitiesX[i] = std::cos(angle) * speed;
+		pool.myVelocitiesY[i] = std::sin(angle) * speed;
+		pool.myLives[i] = 0.0f;
+		pool.myLifeRates[i] = 1.0f / std::max(GetRandom(anEmitter.myLifetimeMinimum, anEmitter.myLifetimeMaximum), 0.001f);
+		pool.mySizes[i] = anEmitter.mySize;
+	}
+
+	pool.myCount += count;
+}
+
+void ParticleSystem::Integrate(Pool& aPool, std::size_t aBegin, std::size_t anEnd) const
+{
+	float* __restrict positionsX = aPool.myPositionsX.data();
+	float* __restrict positionsY = aPool.myPositionsY.data();
+	float* __restrict velocitiesX = aPool.myVelocitiesX.data();
+	float* __restrict velocitiesY = aPool.myVelocitiesY.data();
+	float* __restrict lives = aPool.myLives.data();
+	const float* __restrict lifeRates = aPool.myLifeRates.data();
+
+	const float deltaTime = myDeltaTime;
+	const float gravityX = myGravityX * deltaTime;
+	const float gravityY = myGravityY * deltaTime;
+
+	std::size_t i = aBegin;
+#if PARTICLE_SYSTEM_USE_SSE
+	const __m128 deltaTimes = _mm_set1_ps(deltaTime);
+	const __m128 gravitiesX = _mm_set1_ps(gravityX);
+	const __m128 gravitiesY = _mm_set1_ps(gravityY);
+	for (; i + 4 <= anEnd; i += 4)
+	{
+		const __m128 velocityX = _mm_add_ps(_mm_loadu_ps(velocitiesX + i), gravitiesX);
+		const __m128 velocityY = _mm_add_ps(_mm_loadu_ps(velocitiesY + i), gravitiesY);
+		_mm_storeu_ps(velocitiesX + i, velocityX);
+		_mm_storeu_ps(velocitiesY + i, velocityY);
+		_mm_storeu_ps(positionsX + i, _mm_add_ps(_mm_loadu_ps(positionsX + i), _mm_mul_ps(velocityX, deltaTimes)));
+		_mm_storeu_ps(positionsY + i, _mm_add_ps(_mm_loadu_ps(positionsY + i), _mm_mul_ps(velocityY, deltaTimes)));
+		_mm_storeu_ps(lives + i, _mm_add_ps(_mm_loadu_ps(lives + i), _mm_mul_ps(_mm_loadu_ps(lifeRates + i), deltaTimes)));
+	}
+#endif
+	for (; i < anEnd; ++i)
+	{
+		velocitiesX[i] += gravityX;
+		velocitiesY[i] += gravityY;
+		positionsX[i] += velocitiesX[i] * deltaTime;
+		positionsY[i] += velocitiesY[i] * deltaTime;
+		lives[i] += lifeRates[i] * deltaTime;
+	}
+}
+
+void ParticleSystem::RemoveDead(Pool& aPool)
+{
+	float* const columns[] = { aPool.myPositionsX.data(), aPool.myPositionsY.data(), aPool.myVelocitiesX.data(), aPool.myVelocitiesY.data(), aPool.myLives.data(), aPool.myLifeRates.data(), aPool.mySizes.data() };
+	const float* lives = aPool.myLives.data();
+
+	std::size_t count = aPool.myCount;
+	std::size_t i = 0;
+#if PARTICLE_SYSTEM_USE_SSE
+	const __m128 ones = _mm_set1_ps(1.0f);
+#endif
+	while (i < count)
+	{
+#if PARTICLE_SYSTEM_USE_SSE
+		// Most particles outlive the update, so four at a time are skipped when none of them died
+		if (i + 4 <= count && _mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(lives + i), ones)) == 0)
+		{
+			i += 4;
+			continue;
+		}
+#endif
+		if (lives[i] < 1.0f)
+		{
+			++i;
+			continue;
+		}
+
+		// The last particle may be dead too, it's checked again once it has moved here
+		--count;
+		for (float* column : columns)
+			column[i] = column[count];
+	}
+
+	aPool.myCount = count;
+}
+
+float ParticleSystem::GetRandom(float aMinimum, float aMaximum)
+{
+	// xorshift32, plenty for scattering particles and cheap enough to call per particle
+	myRandomState ^= myRandomState << 13;
+	myRandomState ^= myRandomState >> 17;
+	myRandomState ^= myRandomState << 5;
+	return aMinimum + (aMaximum - aMinimum) * static_cast<float>(myRandomState >> 8) * (1.0f / 16777216.0f);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct ParticleEmitter
+{
+	std::size_t myMaterial = 0;
+	float myPositionX = 0.0f;
+	float myPositionY = 0.0f;
+	// Particles per second, the fraction left over carries to the next update
+	float myRate = 0.0f;
+	// Radians, particles leave within half the spread to either side of the direction
+	float myDirection = 0.0f;
+	float mySpread = 6.2831853f;
+	float mySpeedMinimum = 0.0f;
+	float mySpeedMaximum = 0.0f;
+	float myLifetimeMinimum = 1.0f;
+	float myLifetimeMaximum = 1.0f;
+	float mySize = 1.0f;
+	bool myIsEnabled = true;
+};
+
+// Particles of each material live in their own fixed capacity pool, with every field in its own column so
+// updates run four particles at a time with SSE and split across the job system. Dead particles are swapped
+// out for the last live one, which keeps every pool dense and ready to be copied out as draw instances.
+// Nothing is allocated after construction, particles emitted into a full pool are dropped.
+class ParticleSystem final
+{
+public:
+	// Position, size and life in [0, 1) per particle
+	static constexpr std::size_t ourFloatsPerInstance = 4;
+
+	ParticleSystem(std::size_t aMaterialCount, std::size_t aCapacityPerMaterial);
+
+	ParticleSystem(const ParticleSystem&) = delete;
+	ParticleSystem& operator=(const ParticleSystem&) = delete;
+
+	// Emitters should all be added up front, adding one may allocate
+	std::size_t AddEmitter(const ParticleEmitter& anEmitter);
+	ParticleEmitter& GetEmitter(std::size_t anEmitterIndex) { return myEmitters[anEmitterIndex]; }
+	// Spawns particles at once, regardless of the emitter's rate and whether it's enabled
+	void Emit(std::size_t anEmitterIndex, std::size_t aCount);
+
+	void SetGravity(float anX, float aY);
+
+	// Spawns from the enabled emitters, then integrates and ages every particle and removes the dead ones
+	void Update(float aDeltaTime);
+
+	// Writes ourFloatsPerInstance floats per live particle of the material, someInstances may be a mapped buffer
+	void WriteInstances(std::size_t aMaterial, float* someInstances) const;
+
+	std::size_t GetCount(std::size_t aMaterial) const { return myPools[aMaterial].myCount; }
+	std::size_t GetMaterialCount() const { return myPools.size(); }
+	std::size_t GetCapacity() const { return myCapacity; }
+
+private:
+	struct Pool
+	{
+		std::vector<float> myPositionsX;
+		std::vector<float> myPositionsY;
+		std::vector<float> myVelocitiesX;
+		std::vector<float> myVelocitiesY;
+		std::vector<float> myLives;
+		std::vector<float> myLifeRates;
+		std::vector<float> mySizes;
+		std::size_t myCount;
+	};
+
+	void Spawn(const ParticleEmitter& anEmitter, std::size_t aCount);
+	void Integrate(Pool& aPool, std::size_t aBegin, std::size_t anEnd) const;
+	static void RemoveDead(Pool& aPool);
+	float GetRandom(float aMinimum, float aMaximum);
+
+	std::vector<Pool> myPools;
+	std::vector<ParticleEmitter> myEmitters;
+	std::vector<float> myEmitAccumulators;
+	std::size_t myCapacity;
+	float myDeltaTime;
+	float myGravityX;
+	float myGravityY;
+	std::uint32_t myRandomState;
+};
@@ -0,0 +1,611 @@
+#include "PathfindingService.hpp"
+#include "JobSystem.hpp"
+#include "JumpPointSearch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <queue>
+
+namespace PathfindingParameters
+{
+	static constexpr int ourClusterSize = 16;
+	// Goals closer than this are searched for directly instead of through the abstraction
+	static constexpr int ourDirectSearchDistance = ourClusterSize * 2;
+	// Border openings at least this long get an entrance at both ends instead of one in the middle
+	static constexpr int ourLongEntranceLength = 6;
+	static constexpr std::size_t ourRequestsPerJob = 4;
+	static constexpr std::int64_t ourStartNode = -2;
+	static constexpr std::int64_t ourGoalNode = -3;
+	static constexpr float ourInfiniteCost = std::numeric_limits<float>::infinity();
+}
+
+namespace
+{
+	struct SearchRecord
+	{
+		float myCost;
+		std::int64_t myParent;
+		bool myIsClosed;
+	};
+
+	struct OpenNode
+	{
+		float myEstimate;
+		float myCost;
+		std::int64_t myNode;
+
+		bool operator>(const OpenNode& anOther) const { return myEstimate > anOther.myEstimate; }
+	};
+
+	void AppendPath(const std::vector<GridPoint>& aSegment, std::vector<GridPoint>& aPath)
+	{
+		for (const GridPoint& point : aSegment)
+		{
+			if (aPath.empty() || aPath.back() != point)
+				aPath.push_back(point);
+		}
+	}
+} // namespace
+
+PathfindingService::PathfindingService(NavigationGrid aGrid)
+	: myGrid(std::move(aGrid))
+	, myClusterColumns((myGrid.GetWidth() + PathfindingParameters::ourClusterSize - 1) / PathfindingParameters::ourClusterSize)
+	, myClusterRows((myGrid.GetHeight() + PathfindingParameters::ourClusterSize - 1) / PathfindingParameters::ourClusterSize)
+	, myIsDirty(true)
+	, myQueryCount(0)
+	, myHierarchicalQueryCount(0)
+	, myExpandedNodeCount(0)
+	, myCacheHitCount(0)
+	, myCacheMissCount(0)
+{
+	const std::size_t clusterCount = static_cast<std::size_t>(myClusterColumns) * myClusterRows;
+	myClusters.resize(clusterCount);
+	myRightBorders.resize(clusterCount);
+	myBottomBorders.resize(clusterCount);
+	myDirtyClusters.assign(clusterCount, true);
+	myDirtyBorders.assign(clusterCount * 2, true);
+
+	UpdateAbstraction();
+}
+
+void PathfindingService::SetIsWalkable(int anX, int anY, bool anIsWalkable)
+{
+	if (!myGrid.GetBounds().GetContains(anX, anY) || myGrid.GetIsWalkable(anX, anY) == anIsWalkable)
+		return;
+
+	myGrid.SetIsWalkable(anX, anY, anIsWalkable);
+
+	const int clusterIndex = GetClusterIndex({ anX, anY });
+	const int localX = anX % PathfindingParameters::ourClusterSize;
+	const int localY = anY % PathfindingParameters::ourClusterSize;
+	const GridRect bounds = GetClusterBounds(clusterIndex);
+	myDirtyClusters[clusterIndex] = true;
+
+	// Only cells on a cluster edge can open or close an entrance, which also changes the neighbour's nodes
+	if (anX == bounds.myRight - 1 && anX + 1 < myGrid.GetWidth())
+	{
+		myDirtyBorders[clusterIndex * 2] = true;
+		myDirtyClusters[clusterIndex + 1] = true;
+	}
+	if (localX == 0 && anX > 0)
+	{
+		myDirtyBorders[(clusterIndex - 1) * 2] = true;
+		myDirtyClusters[clusterIndex - 1] = true;
+	}
+	if (anY == bounds.myBottom - 1 && anY + 1 < myGrid.GetHeight())
+	{
+		myDirtyBorders[clusterIndex * 2 + 1] = true;
+		myDirtyClusters[clusterIndex + myClusterColumns] = true;
+	}
+	if (localY == 0 && anY > 0)
+	{
+		myDirtyBorders[(clusterIndex - myClusterColumns) * 2 + 1] = true;
+		myDirtyClusters[clusterIndex - myClusterColumns] = true;
+	}
+
+	myIsDirty = true;
+}
+
+void PathfindingService::UpdateAbstraction()
+{
+	if (!myIsDirty)
+		return;
+
+	std::vector<int> dirtyBorders;
+	for (std::size_t i = 0; i < myDirtyBorders.size(); ++i)
+	{
+		if (myDirtyBorders[i])
+			dirtyBorders.push_back(static_cast<int>(i));
+	}
+
+	std::vector<int> dirtyClusters;
+	for (std::size_t i = 0; i < myDirtyClusters.size(); ++i)
+	{
+		if (myDirtyClusters[i])
+			dirtyClusters.push_back(static_cast<int>(i));
+	}
+
+	// Borders and clusters only write to their own entry, so each pass can be spread over the workers
+	JobSystem::GetInstance().ParallelFor(dirtyBorders.size(), 64, [this, &dirtyBorders](std::size_t aBegin, std::size_t anEnd)
+	{
+		for (std::size_t i = aBegin; i < anEnd; ++i)
+			RebuildBorder(dirtyBorders[i] / 2, (dirtyBorders[i] % 2) == 0);
+	});
+
+	JobSystem::GetInstance().ParallelFor(dirtyClusters.size(), 16, [this, &dirtyClusters](std::size_t aBegin, std::size_t anEnd)
+	{
+		for (std::size_t i = aBegin; i < anEnd; ++i)
+			RebuildCluster(dirtyClusters[i]);
+	});
+
+	std::fill(myDirtyBorders.begin(), myDirtyBorders.end(), static_cast<char>(false));
+	std::fill(myDirtyClusters.begin(), myDirtyClusters.end(), static_cast<char>(false));
+	myIsDirty = false;
+}
+
+void PathfindingService::FindPath(const PathRequest& aRequest, PathResult& aResult) const
+{
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	aResult.myPath.clear();
+	aResult.myStatistics = PathQueryStatistics();
+	aResult.myCost = 0.0f;
+	aResult.myIsFound = false;
+
+	const int distance = std::max(std::abs(aRequest.myGoal.myX - aRequest.myStart.myX), std::abs(aRequest.myGoal.myY - aRequest.myStart.myY));
+	if (myGrid.GetIsWalkable(aRequest.myStart.myX, aRequest.myStart.myY) && myGrid.GetIsWalkable(aRequest.myGoal.myX, aRequest.myGoal.myY))
+	{
+		if (distance <= PathfindingParameters::ourDirectSearchDistance)
+		{
+			aResult.myIsFound = JumpPointSearch::FindPath(myGrid,
+				myGrid.GetBounds(),
+				aRequest.myStart,
+				aRequest.myGoal,
+				aResult.myPath,
+				aResult.myCost,
+				aResult.myStatistics.myExpandedNodeCount);
+		}
+		else
+		{
+			aResult.myStatistics.myIsHierarchical = true;
+			aResult.myIsFound = FindHierarchicalPath(aRequest, aResult);
+		}
+	}
+
+	aResult.myStatistics.myMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+	myQueryCount.fetch_add(1, std::memory_order_relaxed);
+	myHierarchicalQueryCount.fetch_add(aResult.myStatistics.myIsHierarchical ? 1 : 0, std::memory_order_relaxed);
+	myExpandedNodeCount.fetch_add(aResult.myStatistics.myExpandedNodeCount, std::memory_order_relaxed);
+	myCacheHitCount.fetch_add(aResult.myStatistics.myCacheHitCount, std::memory_order_relaxed);
+	myCacheMissCount.fetch_add(aResult.myStatistics.myCacheMissCount, std::memory_order_relaxed);
+}
+
+void PathfindingService::FindPaths(const std::vector<PathRequest>& someRequests, std::vector<PathResult>& someResults) const
+{
+	someResults.resize(someRequests.size());
+	JobSystem::GetInstance().ParallelFor(someRequests.size(), PathfindingParameters::ourRequestsPerJob, [this, &someRequests, &someResults](std::size_t aBegin, std::size_t anEnd)
+	{
+		for (std::size_t i = aBegin; i < anEnd; ++i)
+			FindPath(someRequests[i], someResults[i]);
+	});
+}
+
+void PathfindingService::PrintStatistics() const
+{
+	const std::uint64_t queryCount = myQueryCount.load();
+	const std::uint64_t cacheLookups = myCacheHitCount.load() + myCacheMissCount.load();
+	printf("Pathfinding: %llu queries (%llu hierarchical), %.1f nodes expanded per query, %.1f%% cache hits\n",
+		static_cast<unsigned long long>(queryCount),
+		static_cast<unsigned long long>(myHierarchicalQueryCount.load()),
+		queryCount ? static_cast<double>(myExpandedNodeCount.load()) / static_cast<double>(queryCount) : 0.0,
+		cacheLookups ? 100.0 * static_cast<double>(myCacheHitCount.load()) / static_cast<double>(cacheLookups) : 0.0);
+}
+
+int PathfindingService::GetClusterIndex(GridPoint aPoint) const
+{
+	return (aPoint.myY / PathfindingParameters::ourClusterSize) * myClusterColumns + (aPoint.myX / PathfindingParameters::ourClusterSize);
+}
+
+GridRect PathfindingService::GetClusterBounds(int aClusterIndex) const
+{
+	const int left = (aClusterIndex % myClusterColumns) * PathfindingParameters::ourClusterSize;
+	const int top = (aClusterIndex / myClusterColumns) * PathfindingParameters::ourClusterSize;
+	return { left,
+		top,
+		std::min(left + PathfindingParameters::ourClusterSize, myGrid.GetWidth()),
+		std::min(top + PathfindingParameters::ourClusterSize, myGrid.GetHeight()) };
+}
+
+int PathfindingService::GetNodeIndex(const Cluster& aCluster, GridPoint aPoint) const
+{
+	const std::vector<GridPoint>::const_iterator node = std::find(aCluster.myNodes.begin(), aCluster.myNodes.end(), aPoint);
+	return node == aCluster.myNodes.end() ? -1 : static_cast<int>(node - aCluster.myNodes.begin());
+}
+
+void PathfindingService::RebuildBorder(int aClusterIndex, bool anIsRight)
+{
+	std::vector<Transition>& transitions = anIsRight ? myRightBorders[aClusterIndex] : myBottomBorders[aClusterIndex];
+	transitions.clear();
+
+	const GridRect bounds = GetClusterBounds(aClusterIndex);
+	if ((anIsRight && bounds.myRight >= myGrid.GetWidth()) || (!anIsRight && bounds.myBottom >= myGrid.GetHeight()))
+		return;
+
+	// Walk along the border and turn every stretch that is open on both sides into entrances
+	const int length = anIsRight ? bounds.myBottom - bounds.myTop : bounds.myRight - bounds.myLeft;
+	const auto getFirst = [&bounds, anIsRight](int anOffset) { return anIsRight ? GridPoint { bounds.myRight - 1, bounds.myTop + anOffset } : GridPoint { bounds.myLeft + anOffset, bounds.myBottom - 1 }; };
+	const auto getSecond = [&bounds, anIsRight](int anOffset) { return anIsRight ? GridPoint { bounds.myRight, bounds.myTop + anOffset } : GridPoint { bounds.myLeft + anOffset, bounds.myBottom }; };
+	const auto getIsOpen = [this, &getFirst, &getSecond](int anOffset)
+	{
+		const GridPoint first = getFirst(anOffset);
+		const GridPoint second = getSecond(anOffset);
+		return myGrid.GetIsWalkable(first.myX, first.myY) && myGrid.GetIsWalkable(second.myX, second.myY);
+	};
+
+	int offset = 0;
+	while (offset < length)
+	{
+		if (!getIsOpen(offset))
+		{
+			++offset;
+			continue;
+		}
+
+		const int segmentStart = offset;
+		while (offset < length && getIsOpen(offset))
+			++offset;
+
+		const int segmentLength = offset - segmentStart;
+		if (segmentLength >= PathfindingParameters::ourLongEntranceLength)
+		{
+			transitions.push_back({ getFirst(segmentStart), getSecond(segmentStart) });
+			transitions.push_back({ getFirst(offset - 1), getSecond(offset - 1) });
+		}
+		else
+		{
+			const int middle = segmentStart + segmentLength / 2;
+			transitions.push_back({ getFirst(middle), getSecond(middle) });
+		}
+	}
+}
+
+void PathfindingService::RebuildCluster(int aClusterIndex)
+{
+	Cluster& cluster = myClusters[aClusterIndex];
+	cluster.myNodes.clear();
+	cluster.myPathCache.clear();
+
+	const auto addNode = [&cluster](GridPoint aPoint)
+	{
+		if (std::find(cluster.myNodes.begin(), cluster.myNodes.end(), aPoint) == cluster.myNodes.end())
+			cluster.myNodes.push_back(aPoint);
+	};
+
+	for (const Transition& transition : myRightBorders[aClusterIndex])
+		addNode(transition.myFirst);
+
+	for (const Transition& transition : myBottomBorders[aClusterIndex])
+		addNode(transition.myFirst);
+
+	if (aClusterIndex % myClusterColumns > 0)
+	{
+		for (const Transition& transition : myRightBorders[aClusterIndex - 1])
+			addNode(transition.mySecond);
+	}
+
+	if (aClusterIndex >= myClusterColumns)
+	{
+		for (const Transition& transition : myBottomBorders[aClusterIndex - myClusterColumns])
+			addNode(transition.mySecond);
+	}
+
+	const GridRect bounds = GetClusterBounds(aClusterIndex);
+	const int boundsWidth = bounds.myRight - bounds.myLeft;
+	const std::size_t nodeCount = cluster.myNodes.size();
+	cluster.myCosts.assign(nodeCount * nodeCount, PathfindingParameters::ourInfiniteCost);
+
+	std::vector<float> localCosts;
+	for (std::size_t from = 0; from < nodeCount; ++from)
+	{
+		GetLocalCosts(bounds, cluster.myNodes[from], localCosts);
+		for (std::size_t to = 0; to < nodeCount; ++to)
+		{
+			const GridPoint& node = cluster.myNodes[to];
+			cluster.myCosts[from * nodeCount + to] = localCosts[static_cast<std::size_t>(node.myY - bounds.myTop) * boundsWidth + (node.myX - bounds.myLeft)];
+		}
+	}
+}
+
+void PathfindingService::GetLocalCosts(const GridRect& aBounds, GridPoint aSource, std::vector<float>& someCosts) const
+{
+	static const float diagonalCost = std::sqrt(2.0f);
+
+	const int width = aBounds.myRight - aBounds.myLeft;
+	const int height = aBounds.myBottom - aBounds.myTop;
+	someCosts.assign(static_cast<std::size_t>(width) * height, PathfindingParameters::ourInfiniteCost);
+
+	const auto getIsWalkable = [this, &aBounds](int anX, int anY) { return aBounds.GetContains(anX, anY) && myGrid.GetIsWalkable(anX, anY); };
+	if (!getIsWalkable(aSource.myX, aSource.myY))
+		return;
+
+	// Plain Dijkstra, clusters are small enough that this beats anything cleverer
+	std::priority_queue<OpenNode, std::vector<OpenNode>, std::greater<OpenNode>> openNodes;
+	someCosts[static_cast<std::size_t>(aSource.myY - aBounds.myTop) * width + (aSource.myX - aBounds.myLeft)] = 0.0f;
+	openNodes.push({ 0.0f, 0.0f, static_cast<std::int64_t>(aSource.myY - aBounds.myTop) * width + (aSource.myX - aBounds.myLeft) });
+
+	while (!openNodes.empty())
+	{
+		const OpenNode current = openNodes.top();
+		openNodes.pop();
+		if (current.myCost > someCosts[static_cast<std::size_t>(current.myNode)])
+			continue;
+
+		const int x = aBounds.myLeft + static_cast<int>(current.myNode % width);
+		const int y = aBounds.myTop + static_cast<int>(current.myNode / width);
+		for (int deltaY = -1; deltaY <= 1; ++deltaY)
+		{
+			for (int deltaX = -1; deltaX <= 1; ++deltaX)
+			{
+				if ((deltaX == 0 && deltaY == 0) || !getIsWalkable(x + deltaX, y + deltaY))
+					continue;
+
+				const bool isDiagonal = deltaX != 0 && deltaY != 0;
+				if (isDiagonal && (!getIsWalkable(x + deltaX, y) || !getIsWalkable(x, y + deltaY)))
+					continue;
+
+				const std::size_t neighbour = static_cast<std::size_t>(y + deltaY - aBounds.myTop) * width + (x + deltaX - aBounds.myLeft);
+				const float cost = current.myCost + (isDiagonal ? diagonalCost : 1.0f);
+				if (cost < someCosts[neighbour])
+				{
+					someCosts[neighbour] = cost;
+					openNodes.push({ cost, cost, static_cast<std::int64_t>(neighbour) });
+				}
+			}
+		}
+	}
+}
+
+void PathfindingService::GetAbstractEdges(std::int64_t aNode, int aGoalCluster, const std::vector<float>& someGoalCosts, std::vector<AbstractEdge>& someEdges) const
+{
+	someEdges.clear();
+
+	const std::int64_t width = myGrid.GetWidth();
+	const GridPoint point { static_cast<int>(aNode % width), static_cast<int>(aNode / width) };
+	const int clusterIndex = GetClusterIndex(point);
+	const Cluster& cluster = myClusters[clusterIndex];
+	const int nodeIndex = GetNodeIndex(cluster, point);
+	if (nodeIndex < 0)
+		return;
+
+	const std::size_t nodeCount = cluster.myNodes.size();
+	for (std::size_t to = 0; to < nodeCount; ++to)
+	{
+		const float cost = cluster.myCosts[static_cast<std::size_t>(nodeIndex) * nodeCount + to];
+		if (static_cast<int>(to) != nodeIndex && cost != PathfindingParameters::ourInfiniteCost)
+			someEdges.push_back({ static_cast<std::int64_t>(cluster.myNodes[to].myY) * width + cluster.myNodes[to].myX, cost });
+	}
+
+	// Entrances are straight neighbours across the border
+	const auto addCrossing = [&someEdges, width](const GridPoint& aTarget) { someEdges.push_back({ static_cast<std::int64_t>(aTarget.myY) * width + aTarget.myX, 1.0f }); };
+	for (const Transition& transition : myRightBorders[clusterIndex])
+	{
+		if (transition.myFirst == point)
+			addCrossing(transition.mySecond);
+	}
+
+	for (const Transition& transition : myBottomBorders[clusterIndex])
+	{
+		if (transition.myFirst == point)
+			addCrossing(transition.mySecond);
+	}
+
+	if (clusterIndex % myClusterColumns > 0)
+	{
+		for (const Transition& transition : myRightBorders[clusterIndex - 1])
+		{
+			if (transition.mySecond == point)
+				addCrossing(transition.myFirst);
+		}
+	}
+
+	if (clusterIndex >= myClusterColumns)
+	{
+		for (const Transition& transition : myBottomBorders[clusterIndex - myClusterColumns])
+		{
+			if (transition.mySecond == point)
+				addCrossing(transition.myFirst);
+		}
+	}
+
+	if (clusterIndex == aGoalCluster && someGoalCosts[nodeIndex] != PathfindingParameters::ourInfiniteCost)
+		someEdges.push_back({ PathfindingParameters::ourGoalNode, someGoalCosts[nodeIndex] });
+}
+
+bool PathfindingService::FindHierarchicalPath(const PathRequest& aRequest, PathResult& aResult) const
+{
+	const GridPoint start = aRequest.myStart;
+	const GridPoint goal = aRequest.myGoal;
+	const std::int64_t width = myGrid.GetWidth();
+	const int startClusterIndex = GetClusterIndex(start);
+	const int goalClusterIndex = GetClusterIndex(goal);
+	const GridRect startBounds = GetClusterBounds(startClusterIndex);
+	const GridRect goalBounds = GetClusterBounds(goalClusterIndex);
+	const Cluster& startCluster = myClusters[startClusterIndex];
+	const Cluster& goalCluster = myClusters[goalClusterIndex];
+
+	// Connect the start and goal to the entrances of their own clusters
+	std::vector<float> startLocalCosts;
+	std::vector<float> goalLocalCosts;
+	GetLocalCosts(startBounds, start, startLocalCosts);
+	GetLocalCosts(goalBounds, goal, goalLocalCosts);
+
+	const auto getLocalCost = [](const std::vector<float>& someCosts, const GridRect& aBounds, GridPoint aPoint)
+	{
+		return someCosts[static_cast<std::size_t>(aPoint.myY - aBounds.myTop) * (aBounds.myRight - aBounds.myLeft) + (aPoint.myX - aBounds.myLeft)];
+	};
+
+	std::vector<float> goalCosts(goalCluster.myNodes.size());
+	for (std::size_t i = 0; i < goalCluster.myNodes.size(); ++i)
+		goalCosts[i] = getLocalCost(goalLocalCosts, goalBounds, goalCluster.myNodes[i]);
+
+	const auto getPosition = [&start, &goal, width](std::int64_t aNode)
+	{
+		if (aNode == PathfindingParameters::ourStartNode)
+			return start;
+		if (aNode == PathfindingParameters::ourGoalNode)
+			return goal;
+		return GridPoint { static_cast<int>(aNode % width), static_cast<int>(aNode / width) };
+	};
+
+	std::unordered_map<std::int64_t, SearchRecord> records;
+	std::priority_queue<OpenNode, std::vector<OpenNode>, std::greater<OpenNode>> openNodes;
+	std::vector<AbstractEdge> edges;
+	records[PathfindingParameters::ourStartNode] = { 0.0f, -1, false };
+	openNodes.push({ JumpPointSearch::GetDistance(start, goal), 0.0f, PathfindingParameters::ourStartNode });
+
+	while (!openNodes.empty())
+	{
+		const OpenNode current = openNodes.top();
+		openNodes.pop();
+
+		SearchRecord& currentRecord = records[current.myNode];
+		if (currentRecord.myIsClosed || current.myCost > currentRecord.myCost)
+			continue;
+
+		currentRecord.myIsClosed = true;
+		++aResult.myStatistics.myExpandedNodeCount;
+
+		if (current.myNode == PathfindingParameters::ourGoalNode)
+			break;
+
+		if (current.myNode == PathfindingParameters::ourStartNode)
+		{
+			edges.clear();
+			for (const GridPoint& node : startCluster.myNodes)
+			{
+				const float cost = getLocalCost(startLocalCosts, startBounds, node);
+				if (cost != PathfindingParameters::ourInfiniteCost)
+					edges.push_back({ static_cast<std::int64_t>(node.myY) * width + node.myX, cost });
+			}
+
+			if (startClusterIndex == goalClusterIndex)
+			{
+				const float directCost = getLocalCost(startLocalCosts, startBounds, goal);
+				if (directCost != PathfindingParameters::ourInfiniteCost)
+					edges.push_back({ PathfindingParameters::ourGoalNode, directCost });
+			}
+		}
+		else
+		{
+			GetAbstractEdges(current.myNode, goalClusterIndex, goalCosts, edges);
+		}
+
+		for (const AbstractEdge& edge : edges)
+		{
+			const float cost = current.myCost + edge.myCost;
+			std::unordered_map<std::int64_t, SearchRecord>::iterator record = records.find(edge.myTarget);
+			if (record != records.end() && (record->second.myIsClosed || cost >= record->second.myCost))
+				continue;
+
+			records[edge.myTarget] = { cost, current.myNode, false };
+			openNodes.push({ cost + JumpPointSearch::GetDistance(getPosition(edge.myTarget), goal), cost, edge.myTarget });
+		}
+	}
+
+	const std::unordered_map<std::int64_t, SearchRecord>::const_iterator goalRecord = records.find(PathfindingParameters::ourGoalNode);
+	if (goalRecord == records.end() || !goalRecord->second.myIsClosed)
+		return false;
+
+	aResult.myCost = goalRecord->second.myCost;
+
+	std::vector<std::int64_t> abstractPath;
+	for (std::int64_t node = PathfindingParameters::ourGoalNode; node != -1; node = records[node].myParent)
+		abstractPath.push_back(node);
+
+	std::reverse(abstractPath.begin(), abstractPath.end());
+
+	// Refine every abstract edge back into grid cells
+	std::vector<GridPoint> segment;
+	float segmentCost = 0.0f;
+	for (std::size_t i = 1; i < abstractPath.size(); ++i)
+	{
+		const std::int64_t from = abstractPath[i - 1];
+		const std::int64_t to = abstractPath[i];
+		const GridPoint fromPoint = getPosition(from);
+		const GridPoint toPoint = getPosition(to);
+
+		if (from == PathfindingParameters::ourStartNode || to == PathfindingParameters::ourGoalNode)
+		{
+			const GridRect& bounds = from == PathfindingParameters::ourStartNode ? startBounds : goalBounds;
+			if (!JumpPointSearch::FindPath(myGrid, bounds, fromPoint, toPoint, segment, segmentCost, aResult.myStatistics.myExpandedNodeCount))
+				return false;
+
+			AppendPath(segment, aResult.myPath);
+			continue;
+		}
+
+		const int fromCluster = GetClusterIndex(fromPoint);
+		if (fromCluster != GetClusterIndex(toPoint))
+		{
+			AppendPath({ fromPoint, toPoint }, aResult.myPath);
+			continue;
+		}
+
+		const Cluster& cluster = myClusters[fromCluster];
+		if (!GetClusterPath(fromCluster, GetNodeIndex(cluster, fromPoint), GetNodeIndex(cluster, toPoint), segment, aResult.myStatistics))
+			return false;
+
+		AppendPath(segment, aResult.myPath);
+	}
+
+	return true;
+}
+
+bool PathfindingService::GetClusterPath(int aClusterIndex, int aFromNode, int aToNode, std::vector<GridPoint>& aPath, PathQueryStatistics& someStatistics) const
+{
+	const Cluster& cluster = myClusters[aClusterIndex];
+	if (aFromNode < 0 || aToNode < 0)
+		return false;
+
+	// Paths are symmetric, so one entry serves both directions
+	const int firstNode = std::min(aFromNode, aToNode);
+	const int secondNode = std::max(aFromNode, aToNode);
+	const std::uint32_t key = (static_cast<std::uint32_t>(firstNode) << 16) | static_cast<std::uint32_t>(secondNode);
+
+	bool isCached = false;
+	{
+		std::lock_guard<std::mutex> lock(myPathCacheMutex);
+		const std::unordered_map<std::uint32_t, std::vector<GridPoint>>::const_iterator cachedPath = cluster.myPathCache.find(key);
+		if (cachedPath != cluster.myPathCache.end())
+		{
+			aPath = cachedPath->second;
+			isCached = true;
+		}
+	}
+
+	if (isCached)
+	{
+		++someStatistics.myCacheHitCount;
+	}
+	else
+	{
+		++someStatistics.myCacheMissCount;
+
+		float cost = 0.0f;
+		if (!JumpPointSearch::FindPath(myGrid, GetClusterBounds(aClusterIndex), cluster.myNodes[firstNode], cluster.myNodes[secondNode], aPath, cost, someStatistics.myExpandedNodeCount))
+			return false;
+
+		// The cache is only ever cleared by UpdateAbstraction, which never overlaps with queries
+		std::lock_guard<std::mutex> lock(myPathCacheMutex);
+		cluster.myPathCache.emplace(key, aPath);
+	}
+
+	if (aFromNode != firstNode)
+		std::reverse(aPath.begin(), aPath.end());
+
+	return true;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "NavigationGrid.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct PathRequest
+{
+	GridPoint myStart;
+	GridPoint myGoal;
+};
+
+struct PathQueryStatistics
+{
+	std::size_t myExpandedNodeCount;
+	std::size_t myCacheHitCount;
+	std::size_t myCacheMissCount;
+	double myMicroseconds;
+	bool myIsHierarchical;
+};
+
+struct PathResult
+{
+	std::vector<GridPoint> myPath;
+	PathQueryStatistics myStatistics;
+	float myCost;
+	bool myIsFound;
+};
+
+// Answers path queries on a navigation grid. Nearby goals are searched directly with jump point
+// search, anything further goes through an HPA* style abstraction: the grid is split into square
+// clusters connected by entrances on their borders, and refined paths between entrances are cached.
+// Queries may run concurrently with each other, but not with SetIsWalkable or UpdateAbstraction.
+class PathfindingService final
+{
+public:
+	explicit PathfindingService(NavigationGrid aGrid);
+
+	PathfindingService(const PathfindingService&) = delete;
+	PathfindingService& operator=(const PathfindingService&) = delete;
+
+	// Edits are batched up and only applied to the abstraction by UpdateAbstraction
+	void SetIsWalkable(int anX, int anY, bool anIsWalkable);
+	void UpdateAbstraction();
+
+	void FindPath(const PathRequest& aRequest, PathResult& aResult) const;
+	void FindPaths(const std::vector<PathRequest>& someRequests, std::vector<PathResult>& someResults) const;
+
+	const NavigationGrid& GetGrid() const { return myGrid; }
+	void PrintStatistics() const;
+
+private:
+	struct Transition
+	{
+		GridPoint myFirst;
+		GridPoint mySecond;
+	};
+
+	struct Cluster
+	{
+		std::vector<GridPoint> myNodes;
+		std::vector<float> myCosts;
+		mutable std::unordered_map<std::uint32_t, std::vector<GridPoint>> myPathCache;
+	};
+
+	struct AbstractEdge
+	{
+		std::int64_t myTarget;
+		float myCost;
+	};
+
+	int GetClusterIndex(GridPoint aPoint) const;
+	GridRect GetClusterBounds(int aClusterIndex) const;
+	int GetNodeIndex(const Cluster& aCluster, GridPoint aPoint) const;
+
+	void RebuildBorder(int aClusterIndex, bool anIsHorizontal);
+	void RebuildCluster(int aClusterIndex);
+	void GetLocalCosts(const GridRect& aBounds, GridPoint aSource, std::vector<float>& someCosts) const;
+	void GetAbstractEdges(std::int64_t aNode, int aGoalCluster, const std::vector<float>& someGoalCosts, std::vector<AbstractEdge>& someEdges) const;
+
+	bool FindHierarchicalPath(const PathRequest& aRequest, PathResult& aResult) const;
+	bool GetClusterPath(int aClusterIndex, int aFromNode, int aToNode, std::vector<GridPoint>& aPath, PathQueryStatistics& someStatistics) const;
+
+	NavigationGrid myGrid;
+	std::vector<Cluster> myClusters;
+	// Transitions across the right and bottom border of each cluster
+	std::vector<std::vector<Transition>> myRightBorders;
+	std::vector<std::vector<Transition>> myBottomBorders;
+	std::vector<char> myDirtyClusters;
+	std::vector<char> myDirtyBorders;
+	int myClusterColumns;
+	int myClusterRows;
+	bool myIsDirty;
+
+	mutable std::mutex myPathCacheMutex;
+	mutable std::atomic<std::uint64_t> myQueryCount;
+	mutable std::atomic<std::uint64_t> myHierarchicalQueryCount;
+	mutable std::atomic<std::uint64_t> myExpandedNodeCount;
+	mutable std::atomic<std::uint64_t> myCacheHitCount;
+	mutable std::atomic<std::uint64_t> myCacheMissCount;
+};
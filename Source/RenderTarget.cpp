@@ -0,0 +1,119 @@
+#include "RenderTarget.hpp"
+
+#include <glad/glad.h>
+
+#include <cstdio>
+
+RenderTarget::RenderTarget(int aWidth, int aHeight, int aSampleCount)
+	: myFramebuffer(0)
+	, myColorRenderbuffer(0)
+	, myDepthRenderbuffer(0)
+	, myResolveFramebuffer(0)
+	, myResolveTexture(0)
+	, myWidth(aWidth)
+	, myHeight(aHeight)
+	, mySampleCount(aSampleCount)
+{
+	Create();
+}
+
+RenderTarget::~RenderTarget()
+{
+	Destroy();
+}
+
+void RenderTarget::Resize(int aWidth, int aHeight)
+{
+	if (aWidth == myWidth && aHeight == myHeight)
+		return;
+
+	Destroy();
+	myWidth = aWidth;
+	myHeight = aHeight;
+	Create();
+}
+
+void RenderTarget::Bind(int aRenderWidth, int aRenderHeight) const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, myFramebuffer);
+	glViewport(0, 0, aRenderWidth, aRenderHeight);
+}
+
+void RenderTarget::BlitToWindow(int aRenderWidth, int aRenderHeight, int aWindowWidth, int aWindowHeight) const
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, myFramebuffer);
+	if (myResolveFramebuffer)
+	{
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, myResolveFramebuffer);
+		glBlitFramebuffer(0, 0, aRenderWidth, aRenderHeight, 0, 0, aRenderWidth, aRenderHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, myResolveFramebuffer);
+	}
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, aRenderWidth, aRenderHeight, 0, 0, aWindowWidth, aWindowHeight, GL_COLOR_BUFFER_BIT, aRenderWidth == aWindowWidth && aRenderHeight == aWindowHeight ? GL_NEAREST : GL_LINEAR);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, aWindowWidth, aWindowHeight);
+}
+
+void RenderTarget::Create()
+{
+	glGenRenderbuffers(1, &myColorRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, myColorRenderbuffer);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, mySampleCount, GL_RGBA8, myWidth, myHeight);
+
+	glGenRenderbuffers(1, &myDepthRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, myDepthRenderbuffer);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, mySampleCount, GL_DEPTH_COMPONENT24, myWidth, myHeight);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &myFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, myFramebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, myColorRenderbuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, myDepthRenderbuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		printf("Render target %dx%d with %d samples is incomplete\n", myWidth, myHeight, mySampleCount);
+
+	if (mySampleCount > 0)
+	{
+		glGenTextures(1, &myResolveTexture);
+		glBindTexture(GL_TEXTURE_2D, myResolveTexture);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, myWidth, myHeight);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		glGenFramebuffers(1, &myResolveFramebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, myResolveFramebuffer);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, myResolveTexture, 0);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			printf("Resolve target %dx%d is incomplete\n", myWidth, myHeight);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void RenderTarget::Destroy()
+{
+	if (myFramebuffer)
+		glDeleteFramebuffers(1, &myFramebuffer);
+
+	if (myColorRenderbuffer)
+		glDeleteRenderbuffers(1, &myColorRenderbuffer);
+
+	if (myDepthRenderbuffer)
+		glDeleteRenderbuffers(1, &myDepthRenderbuffer);
+
+	if (myResolveFramebuffer)
+		glDeleteFramebuffers(1, &myResolveFramebuffer);
+
+	if (myResolveTexture)
+		glDeleteTextures(1, &myResolveTexture);
+
+	myFramebuffer = 0;
+	myColorRenderbuffer = 0;
+	myDepthRenderbuffer = 0;
+	myResolveFramebuffer = 0;
+	myResolveTexture = 0;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+// Offscreen colour and depth target the scene is drawn into before being blitted to the window.
+// Storage is sized for the full framebuffer, rendering at a lower scale only uses its corner.
+// A multisampled target is resolved at render size first, since a resolving blit can't scale.
+class RenderTarget final
+{
+public:
+	RenderTarget(int aWidth, int aHeight, int aSampleCount);
+	~RenderTarget();
+
+	RenderTarget(const RenderTarget&) = delete;
+	RenderTarget& operator=(const RenderTarget&) = delete;
+
+	void Resize(int aWidth, int aHeight);
+
+	// Binds the target and limits drawing to the given size
+	void Bind(int aRenderWidth, int aRenderHeight) const;
+	// Resolves and stretches the rendered corner over the whole window framebuffer, which is left bound
+	void BlitToWindow(int aRenderWidth, int aRenderHeight, int aWindowWidth, int aWindowHeight) const;
+
+	int GetWidth() const { return myWidth; }
+	int GetHeight() const { return myHeight; }
+
+private:
+	void Create();
+	void Destroy();
+
+	unsigned int myFramebuffer;
+	unsigned int myColorRenderbuffer;
+	unsigned int myDepthRenderbuffer;
+	// Single-sampled copy the multisampled target is resolved into, unused without multisampling
+	unsigned int myResolveFramebuffer;
+	unsigned int myResolveTexture;
+	int myWidth;
+	int myHeight;
+	int mySampleCount;
+};
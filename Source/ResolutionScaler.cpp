@@ -0,0 +1,111 @@
+#include "ResolutionScaler.hpp"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace ResolutionScalerParameters
+{
+	static constexpr float ourMinimumScale = 0.5f;
+	static constexpr float ourMaximumScale = 1.0f;
+	// Overload is reacted to faster than headroom is given back
+	static constexpr float ourScaleDownStep = 0.1f;
+	static constexpr float ourScaleUpStep = 0.05f;
+	// Fractions of the budget the smoothed GPU time has to cross before the scale moves
+	static constexpr float ourScaleDownThreshold = 0.9f;
+	static constexpr float ourScaleUpThreshold = 0.65f;
+	static constexpr float ourSmoothing = 0.1f;
+	static constexpr unsigned int ourCooldownFrames = 30;
+}
+
+ResolutionScaler::ResolutionScaler(float aTargetMilliseconds)
+	: myQueries{}
+	, myIsQueryPending{}
+	, myQueryIndex(0)
+	, myTargetMilliseconds(aTargetMilliseconds)
+	, myAverageGPUMilliseconds(0.0f)
+	, myScale(ResolutionScalerParameters::ourMaximumScale)
+	, myFramesSinceChange(0)
+	, myIsEnabled(true)
+{
+	glGenQueries(static_cast<GLsizei>(myQueries.size()), myQueries.data());
+}
+
+ResolutionScaler::~ResolutionScaler()
+{
+	glDeleteQueries(static_cast<GLsizei>(myQueries.size()), myQueries.data());
+}
+
+void ResolutionScaler::BeginFrame()
+{
+	// A query still waiting on its result can't be reused, that frame just goes unmeasured
+	if (!myIsQueryPending[myQueryIndex])
+		glBeginQuery(GL_TIME_ELAPSED, myQueries[myQueryIndex]);
+}
+
+void ResolutionScaler::EndFrame()
+{
+	if (!myIsQueryPending[myQueryIndex])
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		myIsQueryPending[myQueryIndex] = true;
+	}
+
+	myQueryIndex = (myQueryIndex + 1) % ourQueryCount;
+
+	// Collect whatever finished, oldest first
+	for (std::size_t offset = 0; offset < ourQueryCount; ++offset)
+	{
+		const std::size_t index = (myQueryIndex + offset) % ourQueryCount;
+		if (!myIsQueryPending[index])
+			continue;
+
+		GLint isAvailable = GL_FALSE;
+		glGetQueryObjectiv(myQueries[index], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+		if (!isAvailable)
+			break;
+
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(myQueries[index], GL_QUERY_RESULT, &nanoseconds);
+		myIsQueryPending[index] = false;
+		AddSample(static_cast<float>(static_cast<double>(nanoseconds) / 1000000.0));
+	}
+}
+
+void ResolutionScaler::SetIsEnabled(bool anIsEnabled)
+{
+	myIsEnabled = anIsEnabled;
+	if (!myIsEnabled)
+		myScale = ResolutionScalerParameters::ourMaximumScale;
+}
+
+void ResolutionScaler::GetRenderSize(int aWidth, int aHeight, int& aRenderWidth, int& aRenderHeight) const
+{
+	aRenderWidth = std::max(1, static_cast<int>(std::lround(static_cast<float>(aWidth) * myScale)));
+	aRenderHeight = std::max(1, static_cast<int>(std::lround(static_cast<float>(aHeight) * myScale)));
+}
+
+void ResolutionScaler::AddSample(float aGPUMilliseconds)
+{
+	if (myAverageGPUMilliseconds == 0.0f)
+		myAverageGPUMilliseconds = aGPUMilliseconds;
+	else
+		myAverageGPUMilliseconds += (aGPUMilliseconds - myAverageGPUMilliseconds) * ResolutionScalerParameters::ourSmoothing;
+
+	++myFramesSinceChange;
+	if (!myIsEnabled || myFramesSinceChange < ResolutionScalerParameters::ourCooldownFrames)
+		return;
+
+	float scale = myScale;
+	if (myAverageGPUMilliseconds > myTargetMilliseconds * ResolutionScalerParameters::ourScaleDownThreshold)
+		scale = std::max(myScale - ResolutionScalerParameters::ourScaleDownStep, ResolutionScalerParameters::ourMinimumScale);
+	else if (myAverageGPUMilliseconds < myTargetMilliseconds * ResolutionScalerParameters::ourScaleUpThreshold)
+		scale = std::min(myScale + ResolutionScalerParameters::ourScaleUpStep, ResolutionScalerParameters::ourMaximumScale);
+
+	if (scale == myScale)
+		return;
+
+	myScale = scale;
+	myFramesSinceChange = 0;
+}
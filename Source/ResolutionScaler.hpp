@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Picks the render scale from GPU time measured with timer queries. Results arrive a few frames
+// late, so the scale only moves once the smoothed time leaves a band around the budget and then
+// holds still until frames rendered at the new scale have been measured.
+class ResolutionScaler final
+{
+public:
+	explicit ResolutionScaler(float aTargetMilliseconds);
+	~ResolutionScaler();
+
+	ResolutionScaler(const ResolutionScaler&) = delete;
+	ResolutionScaler& operator=(const ResolutionScaler&) = delete;
+
+	// Brackets the GPU work of a frame
+	void BeginFrame();
+	void EndFrame();
+
+	// Disabling pins the scale to 1, for captures that have to be reproducible
+	void SetIsEnabled(bool anIsEnabled);
+
+	float GetScale() const { return myScale; }
+	float GetGPUMilliseconds() const { return myAverageGPUMilliseconds; }
+	// Size to render at for a given framebuffer, never below a pixel
+	void GetRenderSize(int aWidth, int aHeight, int& aRenderWidth, int& aRenderHeight) const;
+
+private:
+	static constexpr std::size_t ourQueryCount = 4;
+
+	void AddSample(float aGPUMilliseconds);
+
+	std::array<unsigned int, ourQueryCount> myQueries;
+	std::array<bool, ourQueryCount> myIsQueryPending;
+	std::size_t myQueryIndex;
+	float myTargetMilliseconds;
+	float myAverageGPUMilliseconds;
+	float myScale;
+	unsigned int myFramesSinceChange;
+	bool myIsEnabled;
+};
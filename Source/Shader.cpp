@@ -15,11 +15,14 @@ Shader::~Shader()
 		glDeleteShader(myShaderIdentifier);
 }
 
-void Shader::AttachShader(unsigned int aProgramIdentifier, unsigned int aType, const char* aSource)
+void Shader::AttachShader(unsigned int aProgramIdentifier, unsigned int aType, std::string_view aSource)
 {
 	myShaderType = aType;
 	myShaderIdentifier = glCreateShader(aType);
-	glShaderSource(myShaderIdentifier, 1, &aSource, nullptr);
+	// The source is a view into a mapped file, so it's passed with its length rather than terminated
+	const char* source = aSource.data();
+	const GLint length = static_cast<GLint>(aSource.size());
+	glShaderSource(myShaderIdentifier, 1, &source, &length);
 	glCompileShader(myShaderIdentifier);
 	CheckShaderCompileStatus(myShaderIdentifier);
 	glAttachShader(aProgramIdentifier, myShaderIdentifier);
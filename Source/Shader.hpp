@@ -1,12 +1,14 @@
 #pragma once
 
+#include <string_view>
+
 class Shader final
 {
 public:
 	Shader();
 	~Shader();
 
-	void AttachShader(unsigned int aProgramIdentifier, unsigned int aType, const char* aSource);
+	void AttachShader(unsigned int aProgramIdentifier, unsigned int aType, std::string_view aSource);
 	void CheckShaderLinkStatus(unsigned int aProgramIdentifier) const;
 
 private:
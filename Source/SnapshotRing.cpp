@@ -0,0 +1,377 @@
+#include "SnapshotRing.hpp"
+#include "EntityStore.hpp"
+#include "TilePropertyTable.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+
+namespace SnapshotRingParameters
+{
+	// Camera position, then the entity encoding, word count and payload word count
+	static constexpr std::size_t ourCameraWordCount = 3;
+	static constexpr std::size_t ourEntityHeaderWordCount = 3;
+	static constexpr std::size_t ourChunkWordCount = 1 + TilePropertyTable::ourChunkTileCount;
+}
+
+SnapshotRing::SnapshotRing(std::size_t aCapacity, std::size_t aMaximumRecordCount, unsigned int aKeyframeInterval)
+	: myWords(aCapacity / sizeof(std::uint32_t), 0)
+	, myRecords(aMaximumRecordCount > 0 ? aMaximumRecordCount : 1)
+	, myFirstRecord(0)
+	, myRecordCount(0)
+	, myUsedWords(0)
+	, myHead(0)
+	, myKeyframeInterval(aKeyframeInterval > 0 ? aKeyframeInterval : 1)
+	, myTicksSinceKeyframe(0)
+	, myRecordCallCount(0)
+	, myKeyframeCount(0)
+	, myKeyframeBytes(0)
+	, myDeltaCount(0)
+	, myDeltaBytes(0)
+	, myRestoreCount(0)
+	, myRestoredDeltaCount(0)
+	, myRecordTime(Clock::duration::zero())
+	, myRestoreTime(Clock::duration::zero())
+	, myRestoreTimeMaximum(Clock::duration::zero())
+{}
+
+void SnapshotRing::Record(std::uint32_t aTick, const EntityStore& anEntityStore, TilePropertyTable& aTileTable, const glm::vec3& aCameraPosition)
+{
+	const Clock::time_point start = Clock::now();
+
+	// Recording a tick again replaces it and everything after it
+	bool isReplacing = false;
+	while (myRecordCount > 0 && GetRecord(myRecordCount - 1).myTick >= aTick)
+	{
+		--myRecordCount;
+		myUsedWords -= GetRecord(myRecordCount).mySize;
+		myHead = myRecordCount > 0 ? GetRecord(myRecordCount - 1).myOffset + GetRecord(myRecordCount - 1).mySize : 0;
+		isReplacing = true;
+	}
+
+	anEntityStore.WriteState(myEntityWords);
+
+	// Deltas only make sense on top of the tick right before. After replacing, the previous entity words and
+	// dirty chunks are those of the newest tick dropped rather than the one now before, so a keyframe is needed.
+	bool isKeyframe = isReplacing || myRecordCount == 0 || GetRecord(myRecordCount - 1).myTick + 1 != aTick || myTicksSinceKeyframe + 1 >= myKeyframeInterval;
+	Encode(isKeyframe, aTileTable, aCameraPosition);
+	bool isPlaced = Place(aTick, isKeyframe);
+	if (!isPlaced && !isKeyframe)
+	{
+		// Making room evicted the keyframe the delta depended on
+		isKeyframe = true;
+		Encode(isKeyframe, aTileTable, aCameraPosition);
+		isPlaced = Place(aTick, isKeyframe);
+	}
+
+	if (isPlaced)
+	{
+		const std::uint64_t bytes = myEncodedWords.size() * sizeof(std::uint32_t);
+		myKeyframeCount += isKeyframe ? 1 : 0;
+		myKeyframeBytes += isKeyframe ? bytes : 0;
+		myDeltaCount += isKeyframe ? 0 : 1;
+		myDeltaBytes += isKeyframe ? 0 : bytes;
+		myTicksSinceKeyframe = isKeyframe ? 0 : myTicksSinceKeyframe + 1;
+	}
+	else
+	{
+		printf("Snapshot of tick %u needs %zu bytes, more than the %zu the ring holds\n", aTick, myEncodedWords.size() * sizeof(std::uint32_t), GetCapacity());
+	}
+
+	// Swapping keeps both buffers' capacity, so steady state recording doesn't allocate
+	myPreviousEntityWords.swap(myEntityWords);
+	aTileTable.ClearDirtyChunks();
+
+	++myRecordCallCount;
+	myRecordTime += Clock::now() - start;
+}
+
+bool SnapshotRing::Restore(std::uint32_t aTick, EntityStore& anEntityStore, TilePropertyTable& aTileTable, glm::vec3& aCameraPosition)
+{
+	const Clock::time_point start = Clock::now();
+
+	const std::size_t target = FindRecord(aTick);
+	if (target == myRecordCount)
+		return false;
+
+	// Eviction always leaves a keyframe oldest, so this stops within one keyframe interval
+	std::size_t keyframe = target;
+	while (!GetRecord(keyframe).myIsKeyframe)
+		--keyframe;
+
+	// Chunks first edited after the keyframe aren't part of it, they have to go back to how they were loaded
+	std::array<std::uint32_t, TilePropertyTable::ourChunkTileCount> chunk;
+	for (const std::uint32_t editedChunk : aTileTable.GetEditedChunks())
+	{
+		aTileTable.ReadOriginalChunk(editedChunk, chunk.data());
+		aTileTable.WriteChunk(editedChunk, chunk.data());
+	}
+
+	for (std::size_t i = keyframe; i <= target; ++i)
+	{
+		const std::uint32_t* record = &myWords[GetRecord(i).myOffset] + SnapshotRingParameters::ourCameraWordCount;
+		ApplyTiles(ApplyEntities(record, myEntityWords), aTileTable);
+	}
+
+	if (!anEntityStore.ReadState(myEntityWords.data(), myEntityWords.size()))
+	{
+		printf("Snapshot of tick %u doesn't match the entity store\n", aTick);
+		return false;
+	}
+
+	const RecordInfo& targetRecord = GetRecord(target);
+	std::memcpy(&aCameraPosition[0], &myWords[targetRecord.myOffset], SnapshotRingParameters::ourCameraWordCount * sizeof(std::uint32_t));
+
+	while (myRecordCount > target + 1)
+	{
+		--myRecordCount;
+		myUsedWords -= GetRecord(myRecordCount).mySize;
+	}
+	myHead = targetRecord.myOffset + targetRecord.mySize;
+	myTicksSinceKeyframe = static_cast<unsigned int>(target - keyframe);
+
+	myPreviousEntityWords.swap(myEntityWords);
+	aTileTable.ClearDirtyChunks();
+
+	const Clock::duration elapsed = Clock::now() - start;
+	++myRestoreCount;
+	myRestoredDeltaCount += target - keyframe;
+	myRestoreTime += elapsed;
+	myRestoreTimeMaximum = std::max(myRestoreTimeMaximum, elapsed);
+	return true;
+}
+
+bool SnapshotRing::GetHasTick(std::uint32_t aTick) const
+{
+	return FindRecord(aTick) != myRecordCount;
+}
+
+std::uint32_t SnapshotRing::GetOldestTick() const
+{
+	return myRecordCount > 0 ? GetRecord(0).myTick : 0;
+}
+
+std::uint32_t SnapshotRing::GetNewestTick() const
+{
+	return myRecordCount > 0 ? GetRecord(myRecordCount - 1).myTick : 0;
+}
+
+void SnapshotRing::PrintStatistics(double aTicksPerSecond) const
+{
+	const std::uint64_t recordedCount = myKeyframeCount + myDeltaCount;
+	if (recordedCount == 0)
+		return;
+
+	const double averageBytes = static_cast<double>(myKeyframeBytes + myDeltaBytes) / static_cast<double>(recordedCount);
+	printf("Snapshots: %zu ticks (%.1f s) held in %.2f of %.2f MB, %.1f KB per second of history at %.0f ticks per second\n",
+		myRecordCount,
+		static_cast<double>(myRecordCount) / aTicksPerSecond,
+		static_cast<double>(GetUsedBytes()) / (1024.0 * 1024.0),
+		static_cast<double>(GetCapacity()) / (1024.0 * 1024.0),
+		averageBytes * aTicksPerSecond / 1024.0,
+		aTicksPerSecond);
+	printf("Snapshots: keyframes average %.1f KB, deltas %.1f KB, recording takes %.3f ms\n",
+		myKeyframeCount > 0 ? static_cast<double>(myKeyframeBytes) / static_cast<double>(myKeyframeCount) / 1024.0 : 0.0,
+		myDeltaCount > 0 ? static_cast<double>(myDeltaBytes) / static_cast<double>(myDeltaCount) / 1024.0 : 0.0,
+		std::chrono::duration<double, std::milli>(myRecordTime).count() / static_cast<double>(myRecordCallCount));
+
+	if (myRestoreCount > 0)
+	{
+		printf("Snapshots: restoring takes %.3f ms on average and %.3f ms at most, replaying %.1f deltas on average\n",
+			std::chrono::duration<double, std::milli>(myRestoreTime).count() / static_cast<double>(myRestoreCount),
+			std::chrono::duration<double, std::milli>(myRestoreTimeMaximum).count(),
+			static_cast<double>(myRestoredDeltaCount) / static_cast<double>(myRestoreCount));
+	}
+}
+
+// Record layout in words: the camera position, the entity section and the tile section. The entity section is
+// its encoding, the store's word count, the payload's word count and the payload, either the words themselves
+// or pairs of unchanged and changed run lengths with the changed words XORed against the previous tick.
+// The tile section is a chunk count followed by each chunk's index and GIDs.
+void SnapshotRing::Encode(bool anIsKeyframe, const TilePropertyTable& aTileTable, const glm::vec3& aCameraPosition)
+{
+	const std::vector<std::uint32_t>& chunks = anIsKeyframe ? aTileTable.GetEditedChunks() : aTileTable.GetDirtyChunks();
+	const std::size_t entityWordCount = myEntityWords.size();
+	const std::size_t entityOffset = SnapshotRingParameters::ourCameraWordCount;
+	const std::size_t payloadOffset = entityOffset + SnapshotRingParameters::ourEntityHeaderWordCount;
+	// Room for a keyframe is reserved even for deltas. Edited chunks only grow on the tick of an edit, so the
+	// keyframes after it fit without allocating.
+	myEncodedWords.reserve(payloadOffset + entityWordCount + 1 + aTileTable.GetEditedChunks().size() * SnapshotRingParameters::ourChunkWordCount);
+	myEncodedWords.resize(payloadOffset + entityWordCount + 1 + chunks.size() * SnapshotRingParameters::ourChunkWordCount);
+
+	std::uint32_t* words = myEncodedWords.data();
+	std::memcpy(words, &aCameraPosition[0], SnapshotRingParameters::ourCameraWordCount * sizeof(std::uint32_t));
+
+	// Runs cost two words each, so once they add up to more than the words themselves the tick is stored as is
+	std::size_t payloadCount = 0;
+	bool isRaw = anIsKeyframe || myPreviousEntityWords.size() != entityWordCount;
+	if (!isRaw)
+	{
+		std::uint32_t* payload = words + payloadOffset;
+		const std::uint32_t* current = myEntityWords.data();
+		const std::uint32_t* previous = myPreviousEntityWords.data();
+		std::size_t i = 0;
+		while (i < entityWordCount)
+		{
+			const std::size_t unchangedStart = i;
+			while (i < entityWordCount && current[i] == previous[i])
+				++i;
+
+			const std::size_t changedStart = i;
+			while (i < entityWordCount && current[i] != previous[i])
+				++i;
+
+			if (changedStart == entityWordCount)
+				break;
+
+			const std::size_t changedCount = i - changedStart;
+			if (payloadCount + 2 + changedCount > entityWordCount)
+			{
+				isRaw = true;
+				break;
+			}
+
+			payload[payloadCount++] = static_cast<std::uint32_t>(changedStart - unchangedStart);
+			payload[payloadCount++] = static_cast<std::uint32_t>(changedCount);
+			for (std::size_t j = changedStart; j < i; ++j)
+				payload[payloadCount++] = current[j] ^ previous[j];
+		}
+	}
+
+	if (isRaw)
+	{
+		payloadCount = entityWordCount;
+		std::memcpy(words + payloadOffset, myEntityWords.data(), entityWordCount * sizeof(std::uint32_t));
+	}
+
+	words[entityOffset] = static_cast<std::uint32_t>(isRaw ? Encoding::Raw : Encoding::XORRuns);
+	words[entityOffset + 1] = static_cast<std::uint32_t>(entityWordCount);
+	words[entityOffset + 2] = static_cast<std::uint32_t>(payloadCount);
+
+	std::uint32_t* tiles = words + payloadOffset + payloadCount;
+	*tiles++ = static_cast<std::uint32_t>(chunks.size());
+	for (const std::uint32_t chunk : chunks)
+	{
+		*tiles++ = chunk;
+		aTileTable.ReadChunk(chunk, tiles);
+		tiles += TilePropertyTable::ourChunkTileCount;
+	}
+
+	myEncodedWords.resize(static_cast<std::size_t>(tiles - words));
+}
+
+bool SnapshotRing::Place(std::uint32_t aTick, bool anIsKeyframe)
+{
+	const std::size_t size = myEncodedWords.size();
+	if (size > myWords.size())
+		return false;
+
+	// Records never wrap, one that doesn't fit at the end of the buffer goes to the start if the oldest record leaves room there
+	std::size_t offset = myWords.size();
+	while (offset == myWords.size())
+	{
+		if (!anIsKeyframe && myRecordCount == 0)
+			return false;
+
+		if (myRecordCount == 0)
+		{
+			offset = 0;
+		}
+		else if (myRecordCount < myRecords.size())
+		{
+			const std::size_t tail = GetRecord(0).myOffset;
+			const bool isWrapped = GetRecord(myRecordCount - 1).myOffset < tail;
+			if (!isWrapped && myHead + size <= myWords.size())
+				offset = myHead;
+			else if (!isWrapped && size <= tail)
+				offset = 0;
+			else if (isWrapped && myHead + size <= tail)
+				offset = myHead;
+		}
+
+		if (offset == myWords.size())
+			EvictOldest();
+	}
+
+	std::memcpy(&myWords[offset], myEncodedWords.data(), size * sizeof(std::uint32_t));
+	myRecords[(myFirstRecord + myRecordCount) % myRecords.size()] = { aTick, static_cast<std::uint32_t>(offset), static_cast<std::uint32_t>(size), anIsKeyframe };
+	++myRecordCount;
+	myUsedWords += size;
+	myHead = static_cast<std::uint32_t>(offset + size);
+	return true;
+}
+
+void SnapshotRing::EvictOldest()
+{
+	// Deltas are useless without their keyframe, so they go with it
+	do
+	{
+		myUsedWords -= GetRecord(0).mySize;
+		myFirstRecord = (myFirstRecord + 1) % myRecords.size();
+		--myRecordCount;
+	} while (myRecordCount > 0 && !GetRecord(0).myIsKeyframe);
+
+	if (myRecordCount == 0)
+		myHead = 0;
+}
+
+std::size_t SnapshotRing::FindRecord(std::uint32_t aTick) const
+{
+	std::size_t low = 0;
+	std::size_t high = myRecordCount;
+	while (low < high)
+	{
+		const std::size_t middle = low + (high - low) / 2;
+		const std::uint32_t tick = GetRecord(middle).myTick;
+		if (tick == aTick)
+			return middle;
+
+		if (tick < aTick)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	return myRecordCount;
+}
+
+const std::uint32_t* SnapshotRing::ApplyEntities(const std::uint32_t* aRecord, std::vector<std::uint32_t>& someWords) const
+{
+	const Encoding encoding = static_cast<Encoding>(aRecord[0]);
+	const std::size_t wordCount = aRecord[1];
+	const std::size_t payloadCount = aRecord[2];
+	const std::uint32_t* payload = aRecord + SnapshotRingParameters::ourEntityHeaderWordCount;
+	if (encoding == Encoding::Raw)
+	{
+		someWords.assign(payload, payload + wordCount);
+	}
+	else
+	{
+		// Deltas are only written on top of a tick of the same size
+		std::uint32_t* words = someWords.data();
+		std::size_t position = 0;
+		for (const std::uint32_t* run = payload; run < payload + payloadCount;)
+		{
+			position += run[0];
+			const std::uint32_t changedCount = run[1];
+			run += 2;
+			for (std::uint32_t i = 0; i < changedCount; ++i)
+				words[position++] ^= *run++;
+		}
+	}
+
+	return payload + payloadCount;
+}
+
+const std::uint32_t* SnapshotRing::ApplyTiles(const std::uint32_t* aRecord, TilePropertyTable& aTileTable) const
+{
+	const std::uint32_t chunkCount = *aRecord++;
+	for (std::uint32_t i = 0; i < chunkCount; ++i)
+	{
+		aTileTable.WriteChunk(aRecord[0], aRecord + 1);
+		aRecord += SnapshotRingParameters::ourChunkWordCount;
+	}
+
+	return aRecord;
+}
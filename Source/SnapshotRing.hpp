@@ -0,0 +1,89 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class EntityStore;
+class TilePropertyTable;
+
+// Simulation state for rewinding, kept per tick in a fixed amount of memory. Every keyframe interval a tick
+// stores the entity store whole along with every edited tile chunk, the ticks between store the entity words
+// XORed against the tick before, with runs of unchanged words collapsed, and only the tile chunks edited that
+// tick. Restoring replays at most one keyframe interval of deltas, so it takes bounded time wherever it lands.
+// When the memory runs out the oldest keyframe is dropped together with the deltas that depend on it.
+class SnapshotRing final
+{
+public:
+	SnapshotRing(std::size_t aCapacity, std::size_t aMaximumRecordCount, unsigned int aKeyframeInterval);
+
+	SnapshotRing(const SnapshotRing&) = delete;
+	SnapshotRing& operator=(const SnapshotRing&) = delete;
+
+	// Ticks are expected to increase by one per record, clears the tile table's dirty chunks
+	void Record(std::uint32_t aTick, const EntityStore& anEntityStore, TilePropertyTable& aTileTable, const glm::vec3& aCameraPosition);
+	// Records newer than the restored tick are discarded, recording continues from it
+	bool Restore(std::uint32_t aTick, EntityStore& anEntityStore, TilePropertyTable& aTileTable, glm::vec3& aCameraPosition);
+
+	bool GetHasTick(std::uint32_t aTick) const;
+	std::uint32_t GetOldestTick() const;
+	std::uint32_t GetNewestTick() const;
+	std::size_t GetRecordCount() const { return myRecordCount; }
+	// Bytes held by the records currently in the ring
+	std::size_t GetUsedBytes() const { return myUsedWords * sizeof(std::uint32_t); }
+	std::size_t GetCapacity() const { return myWords.size() * sizeof(std::uint32_t); }
+
+	void PrintStatistics(double aTicksPerSecond) const;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct RecordInfo
+	{
+		std::uint32_t myTick;
+		std::uint32_t myOffset;
+		std::uint32_t mySize;
+		bool myIsKeyframe;
+	};
+
+	enum class Encoding : std::uint32_t
+	{
+		Raw,
+		XORRuns
+	};
+
+	void Encode(bool anIsKeyframe, const TilePropertyTable& aTileTable, const glm::vec3& aCameraPosition);
+	bool Place(std::uint32_t aTick, bool anIsKeyframe);
+	void EvictOldest();
+	std::size_t FindRecord(std::uint32_t aTick) const;
+	const RecordInfo& GetRecord(std::size_t anIndex) const { return myRecords[(myFirstRecord + anIndex) % myRecords.size()]; }
+	// Applies a record's entity section to someWords and returns where its tile section starts
+	const std::uint32_t* ApplyEntities(const std::uint32_t* aRecord, std::vector<std::uint32_t>& someWords) const;
+	const std::uint32_t* ApplyTiles(const std::uint32_t* aRecord, TilePropertyTable& aTileTable) const;
+
+	std::vector<std::uint32_t> myWords;
+	std::vector<RecordInfo> myRecords;
+	std::vector<std::uint32_t> myPreviousEntityWords;
+	std::vector<std::uint32_t> myEntityWords;
+	std::vector<std::uint32_t> myEncodedWords;
+	std::size_t myFirstRecord;
+	std::size_t myRecordCount;
+	std::size_t myUsedWords;
+	std::uint32_t myHead;
+	unsigned int myKeyframeInterval;
+	unsigned int myTicksSinceKeyframe;
+
+	std::uint64_t myRecordCallCount;
+	std::uint64_t myKeyframeCount;
+	std::uint64_t myKeyframeBytes;
+	std::uint64_t myDeltaCount;
+	std::uint64_t myDeltaBytes;
+	std::uint64_t myRestoreCount;
+	std::uint64_t myRestoredDeltaCount;
+	Clock::duration myRecordTime;
+	Clock::duration myRestoreTime;
+	Clock::duration myRestoreTimeMaximum;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// On-disk layout of a baked tileset texture, little-endian throughout:
+//   TextureCacheHeader
+//   TextureCacheLevel[myLevelCount], largest first
+//   opaque tile bits, one per tile in 32-bit words, set for tiles without any transparent pixel
+//   level data, every level starting on a multiple of TextureCache::ourAlignment
+// Tiles are laid out in cells of the same column count as the source image, each tile myGutter texels in from
+// the top left of its cell and surrounded by copies of its edge texels, so filtering never reaches a neighbour.
+namespace TextureCache
+{
+	static constexpr char ourMagic[4] = { 'V', 'T', 'E', 'X' };
+	static constexpr std::uint32_t ourVersion = 1;
+	static constexpr std::uint64_t ourAlignment = 16;
+	static constexpr const char* ourExtension = ".vtex";
+
+	enum class Format : std::uint32_t
+	{
+		RGBA8,
+		BC7
+	};
+
+	// The cache sits next to the image it was baked from, "tileset.png" is baked to "tileset.vtex"
+	inline std::string GetCachePath(const std::string& anImagePath)
+	{
+		const std::size_t separator = anImagePath.find_last_of("/\\");
+		const std::size_t extension = anImagePath.find_last_of('.');
+		const bool hasExtension = extension != std::string::npos && (separator == std::string::npos || extension > separator);
+		return anImagePath.substr(0, hasExtension ? extension : anImagePath.size()) + ourExtension;
+	}
+
+	// 64-bit FNV-1a of the source image, a cache baked from different bytes is ignored
+	inline std::uint64_t GetSourceHash(const void* someData, std::size_t aSize)
+	{
+		const std::uint8_t* bytes = static_cast<const std::uint8_t*>(someData);
+		std::uint64_t hash = 14695981039346656037ull;
+		for (std::size_t i = 0; i < aSize; ++i)
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+
+		return hash;
+	}
+}
+
+struct TextureCacheHeader
+{
+	char myMagic[4];
+	std::uint32_t myVersion;
+	std::uint32_t myFormat;
+	std::uint32_t myLevelCount;
+	std::uint32_t myWidth;
+	std::uint32_t myHeight;
+	std::uint32_t myTileWidth;
+	std::uint32_t myTileHeight;
+	std::uint32_t myCellWidth;
+	std::uint32_t myCellHeight;
+	std::uint32_t myGutter;
+	std::uint32_t myColumnCount;
+	std::uint32_t myRowCount;
+	std::uint32_t myTileCount;
+	std::uint64_t mySourceSize;
+	std::uint64_t mySourceHash;
+};
+
+struct TextureCacheLevel
+{
+	std::uint64_t myDataOffset;
+	std::uint64_t mySize;
+	std::uint32_t myWidth;
+	std::uint32_t myHeight;
+};
+
+static_assert(sizeof(TextureCacheHeader) == 72, "The texture cache header layout is part of the file format");
+static_assert(sizeof(TextureCacheLevel) == 24, "The texture cache level layout is part of the file format");
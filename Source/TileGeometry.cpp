@@ -0,0 +1,115 @@
+#include "TileGeometry.hpp"
+
+#include <iterator>
+
+namespace TileGeometry
+{
+	static void AppendQuad(float aLeft, float aTop, float aRight, float aBottom, float aDepth, float aU0, float aV0, float aU1, float aV1, std::vector<float>& someVertices)
+	{
+		const float vertices[] =
+		{
+			aLeft, aTop, aDepth, aU0, aV0,
+			aRight, aTop, aDepth, aU1, aV0,
+			aLeft, aBottom, aDepth, aU0, aV1,
+			aLeft, aBottom, aDepth, aU0, aV1,
+			aRight, aTop, aDepth, aU1, aV0,
+			aRight, aBottom, aDepth, aU1, aV1
+		};
+
+		someVertices.insert(someVertices.end(), std::begin(vertices), std::end(vertices));
+	}
+
+	static bool GetIsOpaque(std::uint16_t aLookupValue, const std::vector<bool>& anOpaqueTiles)
+	{
+		const std::size_t tileIndex = static_cast<std::size_t>(aLookupValue) - 1;
+		return tileIndex < anOpaqueTiles.size() && anOpaqueTiles[tileIndex];
+	}
+
+	bool BuildLookup(const std::vector<tmx::TileLayer::Tile>& aTiles,
+		unsigned int aWidth,
+		unsigned int aFirstRow,
+		unsigned int aRowEnd,
+		std::uint32_t aFirstGID,
+		std::uint32_t aTileCount,
+		std::uint16_t* aLookup)
+	{
+		bool isUsed = false;
+		for (unsigned int y = aFirstRow; y < aRowEnd; ++y)
+		{
+			for (unsigned int x = 0; x < aWidth; ++x)
+			{
+				const std::size_t index = static_cast<std::size_t>(y) * aWidth + x;
+				if (index < aTiles.size() && aTiles[index].ID >= aFirstGID && aTiles[index].ID < (aFirstGID + aTileCount))
+				{
+					aLookup[index * 2] = static_cast<std::uint16_t>((aTiles[index].ID - aFirstGID) + 1); // Red channel - making sure to index relative to the tileset
+					aLookup[index * 2 + 1] = aTiles[index].flipFlags; // Green channel - tile flips are performed on the shader
+					isUsed = true;
+				}
+				else
+				{
+					// Pad with empty space
+					aLookup[index * 2] = 0;
+					aLookup[index * 2 + 1] = 0;
+				}
+			}
+		}
+
+		return isUsed;
+	}
+
+	void BuildRuns(const std::uint16_t* aLookup,
+		unsigned int aWidth,
+		unsigned int aHeight,
+		unsigned int aFirstRow,
+		unsigned int aRowEnd,
+		const Placement& aPlacement,
+		const std::vector<bool>& anOpaqueTiles,
+		std::vector<float>& someOpaqueVertices,
+		std::vector<float>& someTransparentVertices)
+	{
+		const float inverseWidth = 1.0f / static_cast<float>(aWidth);
+		const float inverseHeight = 1.0f / static_cast<float>(aHeight);
+
+		for (unsigned int y = aFirstRow; y < aRowEnd; ++y)
+		{
+			const std::uint16_t* const row = aLookup + static_cast<std::size_t>(y - aFirstRow) * aWidth * 2;
+			unsigned int x = 0;
+			while (x < aWidth)
+			{
+				if (row[x * 2] == 0)
+				{
+					++x;
+					continue;
+				}
+
+				const bool isOpaque = GetIsOpaque(row[x * 2], anOpaqueTiles);
+				const unsigned int runStart = x;
+				while (x < aWidth && row[x * 2] != 0 && GetIsOpaque(row[x * 2], anOpaqueTiles) == isOpaque)
+					++x;
+
+				const float left = aPlacement.myLeft + static_cast<float>(runStart) * aPlacement.myTileWidth;
+				const float right = aPlacement.myLeft + static_cast<float>(x) * aPlacement.myTileWidth;
+				const float top = aPlacement.myTop + static_cast<float>(y) * aPlacement.myTileHeight;
+				const float bottom = top + aPlacement.myTileHeight;
+
+				AppendQuad(left,
+					top,
+					right,
+					bottom,
+					aPlacement.myDepth,
+					static_cast<float>(runStart) * inverseWidth,
+					static_cast<float>(y) * inverseHeight,
+					static_cast<float>(x) * inverseWidth,
+					static_cast<float>(y + 1) * inverseHeight,
+					isOpaque ? someOpaqueVertices : someTransparentVertices);
+			}
+		}
+	}
+
+	void BuildQuad(unsigned int aWidth, unsigned int aHeight, const Placement& aPlacement, std::vector<float>& someVertices)
+	{
+		const float right = aPlacement.myLeft + static_cast<float>(aWidth) * aPlacement.myTileWidth;
+		const float bottom = aPlacement.myTop + static_cast<float>(aHeight) * aPlacement.myTileHeight;
+		AppendQuad(aPlacement.myLeft, aPlacement.myTop, right, bottom, aPlacement.myDepth, 0.0f, 0.0f, 1.0f, 1.0f, someVertices);
+	}
+} // namespace TileGeometry
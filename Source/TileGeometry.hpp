@@ -0,0 +1,47 @@
+#pragma once
+
+#include <tmxlite/TileLayer.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace TileGeometry
+{
+	// Vertices are laid out as position (x, y, z) followed by lookup coordinates (u, v)
+	static constexpr int ourFloatsPerVertex = 5;
+	static constexpr int ourVerticesPerQuad = 6;
+
+	struct Placement
+	{
+		float myLeft;
+		float myTop;
+		float myTileWidth;
+		float myTileHeight;
+		float myDepth;
+	};
+
+	// Writes two channels per tile (tile index + 1, flip flags) for every tile in [aFirstGID, aFirstGID + aTileCount),
+	// and zeroes for anything else, over rows [aFirstRow, aRowEnd). Returns true if at least one tile belongs to the range.
+	bool BuildLookup(const std::vector<tmx::TileLayer::Tile>& aTiles,
+		unsigned int aWidth,
+		unsigned int aFirstRow,
+		unsigned int aRowEnd,
+		std::uint32_t aFirstGID,
+		std::uint32_t aTileCount,
+		std::uint16_t* aLookup);
+
+	// Merges horizontally adjacent non-empty tiles into runs and emits one quad per run,
+	// split by whether the tiles in the run are fully opaque. aLookup starts at row aFirstRow.
+	void BuildRuns(const std::uint16_t* aLookup,
+		unsigned int aWidth,
+		unsigned int aHeight,
+		unsigned int aFirstRow,
+		unsigned int aRowEnd,
+		const Placement& aPlacement,
+		const std::vector<bool>& anOpaqueTiles,
+		std::vector<float>& someOpaqueVertices,
+		std::vector<float>& someTransparentVertices);
+
+	// Emits a single quad over the whole layer
+	void BuildQuad(unsigned int aWidth, unsigned int aHeight, const Placement& aPlacement, std::vector<float>& someVertices);
+} // namespace TileGeometry
@@ -0,0 +1,281 @@
+#include "TilePropertyTable.hpp"
+#include "JobSystem.hpp"
+
+#include <tmxlite/TileLayer.hpp>
+#include <tmxlite/Tileset.hpp>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace TilePropertyTableParameters
+{
+	static constexpr std::size_t ourMaximumFlagCount = sizeof(TilePropertyTable::FlagMask) * 8;
+	static constexpr std::size_t ourCellsPerJob = 64 * 1024;
+}
+
+TilePropertyTable::TilePropertyTable(const std::vector<tmx::Tileset>& someTilesets, int aWidth, int aHeight)
+	: myCellFlags(static_cast<std::size_t>(aWidth) * aHeight, 0)
+	, myWidth(aWidth)
+	, myHeight(aHeight)
+	, myChunkColumns((aWidth + ourChunkSize - 1) / ourChunkSize)
+	, myChunkRows((aHeight + ourChunkSize - 1) / ourChunkSize)
+{
+	// GID 0 is the empty tile and has no properties
+	std::size_t gidCount = 1;
+	for (const tmx::Tileset& tileset : someTilesets)
+		gidCount = std::max<std::size_t>(gidCount, static_cast<std::size_t>(tileset.getFirstGID()) + tileset.getTileCount());
+
+	myFlags.assign(gidCount, 0);
+
+	std::size_t flagCount = 0;
+	for (const tmx::Tileset& tileset : someTilesets)
+	{
+		for (const tmx::Tileset::Tile& tile : tileset.getTiles())
+		{
+			if (tile.ID >= tileset.getTileCount())
+				continue;
+
+			const std::uint32_t gid = tileset.getFirstGID() + tile.ID;
+			for (const tmx::Property& property : tile.properties)
+			{
+				const tmx::Property::Type type = property.getType();
+				if (type != tmx::Property::Type::Boolean && type != tmx::Property::Type::Float && type != tmx::Property::Type::Int)
+					continue;
+
+				// The first tile to use a name decides its type, later ints and floats are converted to it
+				std::unordered_map<std::string, Column>::iterator column = myColumns.find(property.getName());
+				if (column == myColumns.end())
+				{
+					if (type == tmx::Property::Type::Boolean)
+					{
+						if (flagCount == TilePropertyTableParameters::ourMaximumFlagCount)
+						{
+							printf("Ignoring tile property %s, only %zu bool properties fit\n", property.getName().c_str(), TilePropertyTableParameters::ourMaximumFlagCount);
+							continue;
+						}
+
+						column = myColumns.emplace(property.getName(), Column{ ColumnType::Flag, flagCount++ }).first;
+					}
+					else if (type == tmx::Property::Type::Float)
+					{
+						column = myColumns.emplace(property.getName(), Column{ ColumnType::Float, myFloatColumns.size() }).first;
+						myFloatColumns.emplace_back(gidCount, 0.0f);
+					}
+					else
+					{
+						column = myColumns.emplace(property.getName(), Column{ ColumnType::Int, myIntColumns.size() }).first;
+						myIntColumns.emplace_back(gidCount, 0);
+					}
+				}
+
+				const Column& target = column->second;
+				if (target.myType == ColumnType::Flag && type == tmx::Property::Type::Boolean)
+				{
+					if (property.getBoolValue())
+						myFlags[gid] |= FlagMask(1) << target.myIndex;
+				}
+				else if (target.myType == ColumnType::Float && type != tmx::Property::Type::Boolean)
+				{
+					myFloatColumns[target.myIndex][gid] = type == tmx::Property::Type::Float ? property.getFloatValue() : static_cast<float>(property.getIntValue());
+				}
+				else if (target.myType == ColumnType::Int && type != tmx::Property::Type::Boolean)
+				{
+					myIntColumns[target.myIndex][gid] = type == tmx::Property::Type::Int ? property.getIntValue() : static_cast<std::int32_t>(property.getFloatValue());
+				}
+				else
+				{
+					printf("Ignoring tile property %s on GID %u, its type differs from earlier tiles\n", property.getName().c_str(), gid);
+				}
+			}
+		}
+	}
+}
+
+TilePropertyTable::FlagMask TilePropertyTable::GetFlag(std::string_view aName) const
+{
+	const Column* column = FindColumn(aName, ColumnType::Flag);
+	return column ? FlagMask(1) << column->myIndex : 0;
+}
+
+std::size_t TilePropertyTable::GetFloatColumn(std::string_view aName) const
+{
+	const Column* column = FindColumn(aName, ColumnType::Float);
+	return column ? column->myIndex : ourInvalidColumn;
+}
+
+std::size_t TilePropertyTable::GetIntColumn(std::string_view aName) const
+{
+	const Column* column = FindColumn(aName, ColumnType::Int);
+	return column ? column->myIndex : ourInvalidColumn;
+}
+
+std::size_t TilePropertyTable::AddLayer(const tmx::TileLayer& aLayer)
+{
+	const std::vector<tmx::TileLayer::Tile>& tiles = aLayer.getTiles();
+	std::vector<std::uint32_t>& gids = myLayerGIDs.emplace_back(myCellFlags.size(), 0);
+	const std::size_t cellCount = std::min(tiles.size(), myCellFlags.size());
+
+	// Every cell is written by exactly one job, so the merge into the cell flags needs no synchronization
+	JobSystem::GetInstance().ParallelFor(cellCount, TilePropertyTableParameters::ourCellsPerJob, [this, &tiles, &gids](std::size_t aBegin, std::size_t anEnd)
+		{
+			for (std::size_t i = aBegin; i < anEnd; ++i)
+			{
+				const std::uint32_t gid = tiles[i].ID;
+				gids[i] = gid;
+				myCellFlags[i] |= GetFlags(gid);
+			}
+		});
+
+	myIsChunkDirty.resize(myLayerGIDs.size() * myChunkColumns * myChunkRows, 0);
+	return myLayerGIDs.size() - 1;
+}
+
+void TilePropertyTable::SetGID(std::size_t aLayerIndex, int anX, int anY, std::uint32_t aGID)
+{
+	if (aLayerIndex >= myLayerGIDs.size() || !GetIsInside(anX, anY))
+		return;
+
+	std::uint32_t& gid = myLayerGIDs[aLayerIndex][static_cast<std::size_t>(anY) * myWidth + anX];
+	if (gid == aGID)
+		return;
+
+	const std::uint32_t chunk = GetChunk(aLayerIndex, anX, anY);
+	if (myOriginalChunks.find(chunk) == myOriginalChunks.end())
+	{
+		std::vector<std::uint32_t>& original = myOriginalChunks[chunk];
+		original.resize(ourChunkTileCount);
+		ReadChunk(chunk, original.data());
+		myEditedChunks.push_back(chunk);
+	}
+
+	if (!myIsChunkDirty[chunk])
+	{
+		myIsChunkDirty[chunk] = 1;
+		myDirtyChunks.push_back(chunk);
+	}
+
+	gid = aGID;
+	UpdateCellFlags(anX, anY);
+}
+
+void TilePropertyTable::ClearDirtyChunks()
+{
+	for (const std::uint32_t chunk : myDirtyChunks)
+		myIsChunkDirty[chunk] = 0;
+
+	myDirtyChunks.clear();
+}
+
+void TilePropertyTable::ReadChunk(std::uint32_t aChunk, std::uint32_t* someGIDs) const
+{
+	const std::vector<std::uint32_t>& gids = myLayerGIDs[aChunk / (myChunkColumns * myChunkRows)];
+	const GridRect rect = GetChunkRect(aChunk);
+	std::fill(someGIDs, someGIDs + ourChunkTileCount, 0);
+	for (int y = rect.myTop; y < rect.myBottom; ++y)
+		std::copy(&gids[static_cast<std::size_t>(y) * myWidth + rect.myLeft], &gids[static_cast<std::size_t>(y) * myWidth + rect.myRight], someGIDs + (y - rect.myTop) * ourChunkSize);
+}
+
+void TilePropertyTable::ReadOriginalChunk(std::uint32_t aChunk, std::uint32_t* someGIDs) const
+{
+	const std::unordered_map<std::uint32_t, std::vector<std::uint32_t>>::const_iterator original = myOriginalChunks.find(aChunk);
+	if (original == myOriginalChunks.end())
+		ReadChunk(aChunk, someGIDs);
+	else
+		std::copy(original->second.begin(), original->second.end(), someGIDs);
+}
+
+void TilePropertyTable::WriteChunk(std::uint32_t aChunk, const std::uint32_t* someGIDs)
+{
+	std::vector<std::uint32_t>& gids = myLayerGIDs[aChunk / (myChunkColumns * myChunkRows)];
+	const GridRect rect = GetChunkRect(aChunk);
+	for (int y = rect.myTop; y < rect.myBottom; ++y)
+	{
+		const std::uint32_t* row = someGIDs + (y - rect.myTop) * ourChunkSize;
+		std::copy(row, row + (rect.myRight - rect.myLeft), &gids[static_cast<std::size_t>(y) * myWidth + rect.myLeft]);
+		for (int x = rect.myLeft; x < rect.myRight; ++x)
+			UpdateCellFlags(x, y);
+	}
+}
+
+std::uint32_t TilePropertyTable::GetOriginalGID(std::size_t aLayerIndex, int anX, int anY) const
+{
+	if (!GetIsInside(anX, anY))
+		return 0;
+
+	const std::uint32_t chunk = GetChunk(aLayerIndex, anX, anY);
+	const std::unordered_map<std::uint32_t, std::vector<std::uint32_t>>::const_iterator original = myOriginalChunks.find(chunk);
+	if (original == myOriginalChunks.end())
+		return GetGID(aLayerIndex, anX, anY);
+
+	const GridRect rect = GetChunkRect(chunk);
+	return original->second[static_cast<std::size_t>(anY - rect.myTop) * ourChunkSize + (anX - rect.myLeft)];
+}
+
+std::size_t TilePropertyTable::CountCells(const GridRect& aRect, FlagMask aMask) const
+{
+	const GridRect rect = GetClipped(aRect);
+	std::size_t count = 0;
+	for (int y = rect.myTop; y < rect.myBottom; ++y)
+	{
+		const FlagMask* row = &myCellFlags[static_cast<std::size_t>(y) * myWidth];
+		for (int x = rect.myLeft; x < rect.myRight; ++x)
+			count += (row[x] & aMask) != 0 ? 1 : 0;
+	}
+
+	return count;
+}
+
+bool TilePropertyTable::GetHasAnyCell(const GridRect& aRect, FlagMask aMask) const
+{
+	const GridRect rect = GetClipped(aRect);
+	for (int y = rect.myTop; y < rect.myBottom; ++y)
+	{
+		// OR the row together rather than branching per cell
+		const FlagMask* row = &myCellFlags[static_cast<std::size_t>(y) * myWidth];
+		FlagMask rowFlags = 0;
+		for (int x = rect.myLeft; x < rect.myRight; ++x)
+			rowFlags |= row[x];
+
+		if ((rowFlags & aMask) != 0)
+			return true;
+	}
+
+	return false;
+}
+
+const TilePropertyTable::Column* TilePropertyTable::FindColumn(std::string_view aName, ColumnType aType) const
+{
+	const std::unordered_map<std::string, Column>::const_iterator column = myColumns.find(std::string(aName));
+	return column != myColumns.end() && column->second.myType == aType ? &column->second : nullptr;
+}
+
+std::uint32_t TilePropertyTable::GetChunk(std::size_t aLayerIndex, int anX, int anY) const
+{
+	return static_cast<std::uint32_t>(aLayerIndex * myChunkColumns * myChunkRows + (anY / ourChunkSize) * myChunkColumns + anX / ourChunkSize);
+}
+
+GridRect TilePropertyTable::GetChunkRect(std::uint32_t aChunk) const
+{
+	const int chunkInLayer = static_cast<int>(aChunk % (myChunkColumns * myChunkRows));
+	const int left = (chunkInLayer % myChunkColumns) * ourChunkSize;
+	const int top = (chunkInLayer / myChunkColumns) * ourChunkSize;
+	return { left, top, std::min(left + ourChunkSize, myWidth), std::min(top + ourChunkSize, myHeight) };
+}
+
+void TilePropertyTable::UpdateCellFlags(int anX, int anY)
+{
+	const std::size_t cell = static_cast<std::size_t>(anY) * myWidth + anX;
+	FlagMask flags = 0;
+	for (const std::vector<std::uint32_t>& gids : myLayerGIDs)
+		flags |= GetFlags(gids[cell]);
+
+	myCellFlags[cell] = flags;
+}
+
+GridRect TilePropertyTable::GetClipped(const GridRect& aRect) const
+{
+	GridRect rect = { std::max(aRect.myLeft, 0), std::max(aRect.myTop, 0), std::min(aRect.myRight, myWidth), std::min(aRect.myBottom, myHeight) };
+	rect.myRight = std::max(rect.myRight, rect.myLeft);
+	rect.myBottom = std::max(rect.myBottom, rect.myTop);
+	return rect;
+}
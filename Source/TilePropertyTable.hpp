@@ -0,0 +1,124 @@
+#pragma once
+
+#include "NavigationGrid.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace tmx
+{
+	class TileLayer;
+	class Tileset;
+}
+
+// The tile properties of a map's tilesets baked into dense tables indexed by GID, so gameplay queries never
+// walk tmxlite's per tile property lists or compare names. Property names are interned once: bool properties
+// become bits of a per GID mask, float and int properties get a column each. Added layers keep their GIDs and
+// the flags of all their tiles are merged per cell, so asking whether a cell is solid is two array loads.
+class TilePropertyTable final
+{
+public:
+	using FlagMask = std::uint64_t;
+	static constexpr std::size_t ourInvalidColumn = ~static_cast<std::size_t>(0);
+	// Edits are tracked per square chunk of one layer, numbered layer after layer and row by row within a layer
+	static constexpr int ourChunkSize = 16;
+	static constexpr std::size_t ourChunkTileCount = static_cast<std::size_t>(ourChunkSize) * ourChunkSize;
+
+	TilePropertyTable(const std::vector<tmx::Tileset>& someTilesets, int aWidth, int aHeight);
+
+	// Resolve these once rather than per query. A name no tile uses gives 0 or ourInvalidColumn, which every query accepts.
+	FlagMask GetFlag(std::string_view aName) const;
+	std::size_t GetFloatColumn(std::string_view aName) const;
+	std::size_t GetIntColumn(std::string_view aName) const;
+
+	std::size_t AddLayer(const tmx::TileLayer& aLayer);
+
+	// Keeps a copy of the chunk as loaded the first time it's edited
+	void SetGID(std::size_t aLayerIndex, int anX, int anY, std::uint32_t aGID);
+	// Chunks edited since the last ClearDirtyChunks()
+	const std::vector<std::uint32_t>& GetDirtyChunks() const { return myDirtyChunks; }
+	void ClearDirtyChunks();
+	// Every chunk edited since load, whether or not it has been changed back since
+	const std::vector<std::uint32_t>& GetEditedChunks() const { return myEditedChunks; }
+
+	// Chunks are copied as ourChunkTileCount GIDs, cells past the edge of the map are 0 and ignored when written.
+	// Writing a chunk doesn't mark it dirty, it's meant for restoring state rather than editing.
+	void ReadChunk(std::uint32_t aChunk, std::uint32_t* someGIDs) const;
+	void ReadOriginalChunk(std::uint32_t aChunk, std::uint32_t* someGIDs) const;
+	void WriteChunk(std::uint32_t aChunk, const std::uint32_t* someGIDs);
+	// The layer a chunk belongs to and the cells it covers within it
+	std::size_t GetChunkLayer(std::uint32_t aChunk) const { return aChunk / (myChunkColumns * myChunkRows); }
+	GridRect GetChunkRect(std::uint32_t aChunk) const;
+
+	FlagMask GetFlags(std::uint32_t aGID) const { return aGID < myFlags.size() ? myFlags[aGID] : 0; }
+	float GetFloat(std::size_t aColumn, std::uint32_t aGID) const
+	{
+		return aColumn < myFloatColumns.size() && aGID < myFloatColumns[aColumn].size() ? myFloatColumns[aColumn][aGID] : 0.0f;
+	}
+	std::int32_t GetInt(std::size_t aColumn, std::uint32_t aGID) const
+	{
+		return aColumn < myIntColumns.size() && aGID < myIntColumns[aColumn].size() ? myIntColumns[aColumn][aGID] : 0;
+	}
+
+	// 0 for empty cells and cells outside the map
+	std::uint32_t GetGID(std::size_t aLayerIndex, int anX, int anY) const
+	{
+		return GetIsInside(anX, anY) ? myLayerGIDs[aLayerIndex][static_cast<std::size_t>(anY) * myWidth + anX] : 0;
+	}
+	// The GID the cell was loaded with, whatever it has been edited to since
+	std::uint32_t GetOriginalGID(std::size_t aLayerIndex, int anX, int anY) const;
+	// The flags of every layer's tile in the cell combined
+	FlagMask GetCellFlags(int anX, int anY) const
+	{
+		return GetIsInside(anX, anY) ? myCellFlags[static_cast<std::size_t>(anY) * myWidth + anX] : 0;
+	}
+	bool GetHasAnyFlag(int anX, int anY, FlagMask aMask) const { return (GetCellFlags(anX, anY) & aMask) != 0; }
+
+	// Cells within the rectangle, clipped to the map, that have any flag of the mask
+	std::size_t CountCells(const GridRect& aRect, FlagMask aMask) const;
+	bool GetHasAnyCell(const GridRect& aRect, FlagMask aMask) const;
+
+	std::size_t GetGIDCount() const { return myFlags.size(); }
+	std::size_t GetLayerCount() const { return myLayerGIDs.size(); }
+	int GetWidth() const { return myWidth; }
+	int GetHeight() const { return myHeight; }
+
+private:
+	enum class ColumnType
+	{
+		Flag,
+		Float,
+		Int
+	};
+
+	struct Column
+	{
+		ColumnType myType;
+		std::size_t myIndex;
+	};
+
+	bool GetIsInside(int anX, int anY) const { return anX >= 0 && anY >= 0 && anX < myWidth && anY < myHeight; }
+	std::uint32_t GetChunk(std::size_t aLayerIndex, int anX, int anY) const;
+	void UpdateCellFlags(int anX, int anY);
+	const Column* FindColumn(std::string_view aName, ColumnType aType) const;
+	GridRect GetClipped(const GridRect& aRect) const;
+
+	std::unordered_map<std::string, Column> myColumns;
+	std::vector<FlagMask> myFlags;
+	std::vector<std::vector<float>> myFloatColumns;
+	std::vector<std::vector<std::int32_t>> myIntColumns;
+	std::vector<std::vector<std::uint32_t>> myLayerGIDs;
+	std::vector<FlagMask> myCellFlags;
+	std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> myOriginalChunks;
+	std::vector<std::uint32_t> myEditedChunks;
+	std::vector<std::uint32_t> myDirtyChunks;
+	std::vector<char> myIsChunkDirty;
+	int myWidth;
+	int myHeight;
+	int myChunkColumns;
+	int myChunkRows;
+};
@@ -1,10 +1,29 @@
 #include "Game.hpp"
 
-int main(int /*argc*/, char** /*argv*/)
+#include <cstring>
+
+int main(int argc, char** argv)
 {
 	Game game;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--golden") == 0)
+		{
+			game.SetIsGoldenTest(true);
+		}
+		else if (std::strcmp(argv[i], "--update-goldens") == 0)
+		{
+			game.SetIsGoldenTest(true);
+			game.SetIsUpdatingGoldens(true);
+		}
+		else if (std::strcmp(argv[i], "--map") == 0 && i + 1 < argc)
+		{
+			game.SetMapFilePath(argv[++i]);
+		}
+	}
+
 	game.Initialize();
 	game.Run();
 
-	return 0;
+	return game.GetFailedComparisonCount() == 0 ? 0 : 1;
 }
@@ -0,0 +1,187 @@
+#include "VirtualFileSystem.hpp"
+#include "LZ4.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+bool VirtualFileSystem::MountPack(const char* aFilepath)
+{
+	Pack pack;
+	if (!pack.myFile.Open(aFilepath))
+	{
+		printf("Failed to open asset pack %s\n", aFilepath);
+		return false;
+	}
+
+	AssetPackHeader header;
+	if (!GetIsValid(pack.myFile, header))
+	{
+		printf("Asset pack %s is invalid\n", aFilepath);
+		return false;
+	}
+
+	pack.myPaths = reinterpret_cast<const char*>(pack.myFile.GetData() + sizeof(AssetPackHeader) + static_cast<std::size_t>(header.myEntryCount) * sizeof(AssetPackEntry));
+	pack.myEntryCount = header.myEntryCount;
+	myPacks.push_back(std::move(pack));
+
+	printf("Mounted asset pack %s with %u entries\n", aFilepath, header.myEntryCount);
+	return true;
+}
+
+bool VirtualFileSystem::GetExists(std::string_view aFilepath) const
+{
+	const std::string normalizedPath = GetNormalizedPath(aFilepath);
+	const Pack* pack = nullptr;
+	AssetPackEntry entry;
+	return FindEntry(normalizedPath, pack, entry) || std::filesystem::is_regular_file(normalizedPath);
+}
+
+bool VirtualFileSystem::GetSize(std::string_view aFilepath, std::uint64_t& aSize) const
+{
+	const std::string normalizedPath = GetNormalizedPath(aFilepath);
+	const Pack* pack = nullptr;
+	AssetPackEntry entry;
+	if (FindEntry(normalizedPath, pack, entry))
+	{
+		aSize = entry.mySize;
+		return true;
+	}
+
+	std::error_code error;
+	const std::uintmax_t size = std::filesystem::file_size(normalizedPath, error);
+	if (error)
+		return false;
+
+	aSize = static_cast<std::uint64_t>(size);
+	return true;
+}
+
+std::string_view VirtualFileSystem::ReadFile(std::string_view aFilepath)
+{
+	const std::string normalizedPath = GetNormalizedPath(aFilepath);
+
+	const Pack* pack = nullptr;
+	AssetPackEntry entry;
+	if (FindEntry(normalizedPath, pack, entry))
+		return GetEntryData(normalizedPath, *pack, entry);
+
+	{
+		std::lock_guard<std::mutex> lock(myCacheMutex);
+		const std::unordered_map<std::string, MappedFile>::const_iterator looseFile = myLooseFiles.find(normalizedPath);
+		if (looseFile != myLooseFiles.end())
+			return std::string_view(reinterpret_cast<const char*>(looseFile->second.GetData()), looseFile->second.GetSize());
+	}
+
+	MappedFile file;
+	if (!file.Open(normalizedPath.c_str()))
+	{
+		printf("File does not exist: %s\n", normalizedPath.c_str());
+		return {};
+	}
+
+	// Another thread may have mapped the same file meanwhile, in which case its mapping is kept
+	std::lock_guard<std::mutex> lock(myCacheMutex);
+	const MappedFile& looseFile = myLooseFiles.emplace(normalizedPath, std::move(file)).first->second;
+	return std::string_view(reinterpret_cast<const char*>(looseFile.GetData()), looseFile.GetSize());
+}
+
+void VirtualFileSystem::ReleaseCache()
+{
+	std::lock_guard<std::mutex> lock(myCacheMutex);
+	myDecompressedEntries.clear();
+	myLooseFiles.clear();
+}
+
+std::string VirtualFileSystem::GetNormalizedPath(std::string_view aFilepath)
+{
+	// tmxlite hands out image paths like "Data/Tilemaps/../Tilemaps/Tilesets/tileset.png"
+	return std::filesystem::path(aFilepath).lexically_normal().generic_string();
+}
+
+bool VirtualFileSystem::GetIsValid(const MappedFile& aFile, AssetPackHeader& aHeader)
+{
+	const std::uint64_t fileSize = aFile.GetSize();
+	if (fileSize < sizeof(AssetPackHeader))
+		return false;
+
+	std::memcpy(&aHeader, aFile.GetData(), sizeof(AssetPackHeader));
+	if (std::memcmp(aHeader.myMagic, AssetPack::ourMagic, sizeof(AssetPack::ourMagic)) != 0 || aHeader.myVersion != AssetPack::ourVersion)
+		return false;
+
+	const std::uint64_t pathTableOffset = sizeof(AssetPackHeader) + static_cast<std::uint64_t>(aHeader.myEntryCount) * sizeof(AssetPackEntry);
+	if (pathTableOffset + aHeader.myPathTableSize > fileSize)
+		return false;
+
+	// Check every entry once here so lookups and reads can trust them
+	for (std::uint32_t i = 0; i < aHeader.myEntryCount; ++i)
+	{
+		AssetPackEntry entry;
+		std::memcpy(&entry, aFile.GetData() + sizeof(AssetPackHeader) + static_cast<std::size_t>(i) * sizeof(AssetPackEntry), sizeof(AssetPackEntry));
+		if (static_cast<std::uint64_t>(entry.myPathOffset) + entry.myPathLength > aHeader.myPathTableSize)
+			return false;
+
+		if (entry.myDataOffset > fileSize || entry.myStoredSize > fileSize - entry.myDataOffset)
+			return false;
+
+		if (entry.myStoredSize != entry.mySize && entry.myStoredSize > LZ4::GetMaximumCompressedSize(entry.mySize))
+			return false;
+	}
+
+	return true;
+}
+
+bool VirtualFileSystem::FindEntry(const std::string& aNormalizedPath, const Pack*& aPack, AssetPackEntry& anEntry) const
+{
+	for (std::vector<Pack>::const_reverse_iterator pack = myPacks.rbegin(); pack != myPacks.rend(); ++pack)
+	{
+		const std::uint8_t* entries = pack->myFile.GetData() + sizeof(AssetPackHeader);
+		std::uint32_t low = 0;
+		std::uint32_t high = pack->myEntryCount;
+		while (low < high)
+		{
+			const std::uint32_t middle = low + (high - low) / 2;
+			std::memcpy(&anEntry, entries + static_cast<std::size_t>(middle) * sizeof(AssetPackEntry), sizeof(AssetPackEntry));
+
+			const int comparison = std::string_view(pack->myPaths + anEntry.myPathOffset, anEntry.myPathLength).compare(aNormalizedPath);
+			if (comparison == 0)
+			{
+				aPack = &*pack;
+				return true;
+			}
+
+			if (comparison < 0)
+				low = middle + 1;
+			else
+				high = middle;
+		}
+	}
+
+	return false;
+}
+
+std::string_view VirtualFileSystem::GetEntryData(const std::string& aNormalizedPath, const Pack& aPack, const AssetPackEntry& anEntry)
+{
+	const std::uint8_t* storedData = aPack.myFile.GetData() + anEntry.myDataOffset;
+	if (anEntry.myStoredSize == anEntry.mySize)
+		return std::string_view(reinterpret_cast<const char*>(storedData), static_cast<std::size_t>(anEntry.mySize));
+
+	{
+		std::lock_guard<std::mutex> lock(myCacheMutex);
+		const std::unordered_map<std::string, std::vector<std::uint8_t>>::const_iterator decompressedEntry = myDecompressedEntries.find(aNormalizedPath);
+		if (decompressedEntry != myDecompressedEntries.end())
+			return std::string_view(reinterpret_cast<const char*>(decompressedEntry->second.data()), decompressedEntry->second.size());
+	}
+
+	// Decompress outside the lock so textures decoded in parallel don't wait on each other
+	std::vector<std::uint8_t> data(static_cast<std::size_t>(anEntry.mySize));
+	if (!LZ4::Decompress(storedData, static_cast<std::size_t>(anEntry.myStoredSize), data.data(), data.size()))
+	{
+		printf("Failed to decompress %s\n", aNormalizedPath.c_str());
+		return {};
+	}
+
+	std::lock_guard<std::mutex> lock(myCacheMutex);
+	const std::vector<std::uint8_t>& decompressedEntry = myDecompressedEntries.emplace(aNormalizedPath, std::move(data)).first->second;
+	return std::string_view(reinterpret_cast<const char*>(decompressedEntry.data()), decompressedEntry.size());
+}
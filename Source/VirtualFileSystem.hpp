@@ -0,0 +1,63 @@
+#pragma once
+
+#include "AssetPack.hpp"
+#include "MappedFile.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Serves read-only views of game files, relative to the working directory like "Data/Shaders/VertexShader.glsl".
+// Mounted asset packs are searched first, the last mounted winning, and loose files are the fallback.
+// Stored pack entries and loose files are views straight into mapped memory, only LZ4 compressed entries are
+// decompressed, once, into a cache. Views stay valid until ReleaseCache() for those two and as long as the pack is mounted otherwise.
+class VirtualFileSystem final
+{
+public:
+	static VirtualFileSystem& GetInstance()
+	{
+		static VirtualFileSystem instance;
+		return instance;
+	}
+
+	VirtualFileSystem(VirtualFileSystem const&) = delete;
+	void operator=(VirtualFileSystem const&) = delete;
+
+	// Not thread safe, mount packs before reading from other threads
+	bool MountPack(const char* aFilepath);
+
+	bool GetExists(std::string_view aFilepath) const;
+	// Uncompressed size, without reading or mapping the file. False if the file doesn't exist.
+	bool GetSize(std::string_view aFilepath, std::uint64_t& aSize) const;
+	// Empty if the file doesn't exist, safe to call from any thread
+	std::string_view ReadFile(std::string_view aFilepath);
+	// Drops decompressed entries and unmaps loose files, invalidating views of them
+	void ReleaseCache();
+
+	std::size_t GetMountedPackCount() const { return myPacks.size(); }
+
+private:
+	struct Pack
+	{
+		MappedFile myFile;
+		const char* myPaths;
+		std::uint32_t myEntryCount;
+	};
+
+	VirtualFileSystem() = default;
+	~VirtualFileSystem() = default;
+
+	static std::string GetNormalizedPath(std::string_view aFilepath);
+	static bool GetIsValid(const MappedFile& aFile, AssetPackHeader& aHeader);
+
+	bool FindEntry(const std::string& aNormalizedPath, const Pack*& aPack, AssetPackEntry& anEntry) const;
+	std::string_view GetEntryData(const std::string& aNormalizedPath, const Pack& aPack, const AssetPackEntry& anEntry);
+
+	std::vector<Pack> myPacks;
+	std::mutex myCacheMutex;
+	std::unordered_map<std::string, std::vector<std::uint8_t>> myDecompressedEntries;
+	std::unordered_map<std::string, MappedFile> myLooseFiles;
+};
@@ -0,0 +1,138 @@
+#include "ParticleSystem.hpp"
+
+#include <cstdio>
+#include <vector>
+
+namespace ParticleSystemTestParameters
+{
+	static constexpr std::size_t ourMaterialCount = 2;
+	static constexpr std::size_t ourCapacity = 64;
+	// Not a multiple of four, so both the four-wide loops and their scalar tails run
+	static constexpr std::size_t ourMovingCount = 7;
+	static constexpr float ourShortLifetime = 0.5f;
+	static constexpr float ourLongLifetime = 2.0f;
+	static constexpr float ourShortSize = 1.0f;
+	static constexpr float ourLongSize = 2.0f;
+}
+
+struct Instance
+{
+	float myPositionX;
+	float myPositionY;
+	float mySize;
+	float myLife;
+};
+
+static std::vector<Instance> GetInstances(const ParticleSystem& aParticleSystem, std::size_t aMaterial)
+{
+	std::vector<float> floats(aParticleSystem.GetCount(aMaterial) * ParticleSystem::ourFloatsPerInstance);
+	aParticleSystem.WriteInstances(aMaterial, floats.data());
+
+	std::vector<Instance> instances;
+	for (std::size_t i = 0; i < floats.size(); i += ParticleSystem::ourFloatsPerInstance)
+		instances.push_back({ floats[i], floats[i + 1], floats[i + 2], floats[i + 3] });
+
+	return instances;
+}
+
+static bool Check(const char* aName, bool anIsPassing)
+{
+	printf("%s %s\n", anIsPassing ? "Passed" : "Failed", aName);
+	return anIsPassing;
+}
+
+// Without spread or a speed range every particle of the emitter moves the same way, so they can be checked exactly
+static ParticleEmitter CreateEmitter(std::size_t aMaterial, float aLifetime, float aSize)
+{
+	ParticleEmitter emitter;
+	emitter.myMaterial = aMaterial;
+	emitter.myPositionX = 1.0f;
+	emitter.myPositionY = 2.0f;
+	emitter.myDirection = 0.0f;
+	emitter.mySpread = 0.0f;
+	emitter.mySpeedMinimum = 10.0f;
+	emitter.mySpeedMaximum = 10.0f;
+	emitter.myLifetimeMinimum = aLifetime;
+	emitter.myLifetimeMaximum = aLifetime;
+	emitter.mySize = aSize;
+	emitter.myIsEnabled = false;
+	return emitter;
+}
+
+static bool TestUpdate()
+{
+	ParticleSystem particleSystem(ParticleSystemTestParameters::ourMaterialCount, ParticleSystemTestParameters::ourCapacity);
+	const std::size_t emitterIndex = particleSystem.AddEmitter(CreateEmitter(1, ParticleSystemTestParameters::ourLongLifetime, ParticleSystemTestParameters::ourLongSize));
+	particleSystem.SetGravity(0.0f, -4.0f);
+	particleSystem.Emit(emitterIndex, ParticleSystemTestParameters::ourMovingCount);
+	particleSystem.Update(0.5f);
+
+	// Gravity is applied to the velocity before it moves the particle
+	bool isMatch = particleSystem.GetCount(0) == 0 && particleSystem.GetCount(1) == ParticleSystemTestParameters::ourMovingCount;
+	for (const Instance& instance : GetInstances(particleSystem, 1))
+		isMatch &= instance.myPositionX == 6.0f && instance.myPositionY == 1.0f && instance.mySize == ParticleSystemTestParameters::ourLongSize && instance.myLife == 0.25f;
+
+	return Check("updating particles", isMatch);
+}
+
+static bool TestExpiry()
+{
+	ParticleSystem particleSystem(ParticleSystemTestParameters::ourMaterialCount, ParticleSystemTestParameters::ourCapacity);
+	const std::size_t shortEmitterIndex = particleSystem.AddEmitter(CreateEmitter(0, ParticleSystemTestParameters::ourShortLifetime, ParticleSystemTestParameters::ourShortSize));
+	const std::size_t longEmitterIndex = particleSystem.AddEmitter(CreateEmitter(0, ParticleSystemTestParameters::ourLongLifetime, ParticleSystemTestParameters::ourLongSize));
+
+	// Dead particles at the start, in the middle and at the end of the pool, so removal swaps in dead ones too
+	particleSystem.Emit(shortEmitterIndex, 5);
+	particleSystem.Emit(longEmitterIndex, 3);
+	particleSystem.Emit(shortEmitterIndex, 2);
+	particleSystem.Emit(longEmitterIndex, 6);
+	particleSystem.Emit(shortEmitterIndex, 4);
+
+	bool isPassing = true;
+	particleSystem.Update(0.25f);
+	isPassing &= Check("keeping particles that haven't expired", particleSystem.GetCount(0) == 20);
+
+	particleSystem.Update(0.25f);
+	bool isMatch = particleSystem.GetCount(0) == 9;
+	for (const Instance& instance : GetInstances(particleSystem, 0))
+		isMatch &= instance.mySize == ParticleSystemTestParameters::ourLongSize && instance.myLife == 0.25f;
+
+	isPassing &= Check("removing expired particles", isMatch);
+
+	particleSystem.Update(1.5f);
+	isPassing &= Check("removing every expired particle", particleSystem.GetCount(0) == 0);
+	return isPassing;
+}
+
+static bool TestEmission()
+{
+	ParticleSystem particleSystem(ParticleSystemTestParameters::ourMaterialCount, ParticleSystemTestParameters::ourCapacity);
+	ParticleEmitter emitter = CreateEmitter(0, ParticleSystemTestParameters::ourLongLifetime * 100.0f, ParticleSystemTestParameters::ourLongSize);
+	emitter.myRate = 10.0f;
+	emitter.myIsEnabled = true;
+	const std::size_t emitterIndex = particleSystem.AddEmitter(emitter);
+
+	// The fraction of a particle left over from one update carries into the next
+	bool isPassing = true;
+	particleSystem.Update(0.25f);
+	const std::size_t firstCount = particleSystem.GetCount(0);
+	particleSystem.Update(0.25f);
+	isPassing &= Check("emitting at the emitter's rate", firstCount == 2 && particleSystem.GetCount(0) == 5);
+
+	particleSystem.GetEmitter(emitterIndex).myIsEnabled = false;
+	particleSystem.Update(1.0f);
+	isPassing &= Check("not emitting from a disabled emitter", particleSystem.GetCount(0) == 5);
+
+	particleSystem.Emit(emitterIndex, ParticleSystemTestParameters::ourCapacity);
+	isPassing &= Check("dropping particles emitted into a full pool", particleSystem.GetCount(0) == ParticleSystemTestParameters::ourCapacity);
+	return isPassing;
+}
+
+int main(int /*argc*/, char** /*argv*/)
+{
+	bool isPassing = true;
+	isPassing &= TestUpdate();
+	isPassing &= TestExpiry();
+	isPassing &= TestEmission();
+	return isPassing ? 0 : 1;
+}
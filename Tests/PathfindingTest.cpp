@@ -0,0 +1,248 @@
+#include "NavigationGrid.hpp"
+#include "PathfindingService.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace PathfindingTestParameters
+{
+	static constexpr unsigned int ourSeed = 42;
+	// Small enough that every query stays a direct search
+	static constexpr int ourSmallWidth = 24;
+	static constexpr int ourSmallHeight = 20;
+	// Wide enough that most queries go through the cluster abstraction
+	static constexpr int ourLargeWidth = 80;
+	static constexpr int ourLargeHeight = 48;
+	static constexpr float ourWallChance = 0.25f;
+	static constexpr std::size_t ourRequestCount = 200;
+	static constexpr std::size_t ourEditCount = 60;
+	static constexpr float ourCostTolerance = 0.001f;
+	static constexpr float ourInfiniteCost = std::numeric_limits<float>::infinity();
+}
+
+static bool Check(const char* aName, bool anIsPassing)
+{
+	printf("%s %s\n", anIsPassing ? "Passed" : "Failed", aName);
+	return anIsPassing;
+}
+
+static NavigationGrid CreateGrid(int aWidth, int aHeight, std::mt19937& aGenerator)
+{
+	std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+	NavigationGrid grid(aWidth, aHeight);
+	for (int y = 0; y < aHeight; ++y)
+	{
+		for (int x = 0; x < aWidth; ++x)
+			grid.SetIsWalkable(x, y, chance(aGenerator) >= PathfindingTestParameters::ourWallChance);
+	}
+
+	return grid;
+}
+
+static std::vector<PathRequest> CreateRequests(const NavigationGrid& aGrid, std::mt19937& aGenerator)
+{
+	std::uniform_int_distribution<int> xDistribution(0, aGrid.GetWidth() - 1);
+	std::uniform_int_distribution<int> yDistribution(0, aGrid.GetHeight() - 1);
+	const auto getWalkablePoint = [&]()
+	{
+		GridPoint point = { xDistribution(aGenerator), yDistribution(aGenerator) };
+		while (!aGrid.GetIsWalkable(point.myX, point.myY))
+			point = { xDistribution(aGenerator), yDistribution(aGenerator) };
+
+		return point;
+	};
+
+	std::vector<PathRequest> requests;
+	for (std::size_t i = 0; i < PathfindingTestParameters::ourRequestCount; ++i)
+		requests.push_back({ getWalkablePoint(), getWalkablePoint() });
+
+	return requests;
+}
+
+static bool GetIsStepAllowed(const NavigationGrid& aGrid, GridPoint aFrom, GridPoint aTo)
+{
+	const int deltaX = aTo.myX - aFrom.myX;
+	const int deltaY = aTo.myY - aFrom.myY;
+	if (std::abs(deltaX) > 1 || std::abs(deltaY) > 1 || (deltaX == 0 && deltaY == 0) || !aGrid.GetIsWalkable(aTo.myX, aTo.myY))
+		return false;
+
+	// Diagonal steps may not cut corners
+	return deltaX == 0 || deltaY == 0 || (aGrid.GetIsWalkable(aFrom.myX + deltaX, aFrom.myY) && aGrid.GetIsWalkable(aFrom.myX, aFrom.myY + deltaY));
+}
+
+// Plain Dijkstra over the whole grid with the same moves and costs as the service
+static std::vector<float> GetCosts(const NavigationGrid& aGrid, GridPoint aStart)
+{
+	const float diagonalCost = std::sqrt(2.0f);
+	const int width = aGrid.GetWidth();
+	std::vector<float> costs(static_cast<std::size_t>(width) * aGrid.GetHeight(), PathfindingTestParameters::ourInfiniteCost);
+	using OpenNode = std::pair<float, int>;
+	std::priority_queue<OpenNode, std::vector<OpenNode>, std::greater<OpenNode>> openNodes;
+	costs[static_cast<std::size_t>(aStart.myY) * width + aStart.myX] = 0.0f;
+	openNodes.push({ 0.0f, aStart.myY * width + aStart.myX });
+
+	while (!openNodes.empty())
+	{
+		const OpenNode current = openNodes.top();
+		openNodes.pop();
+		if (current.first > costs[current.second])
+			continue;
+
+		const GridPoint point = { current.second % width, current.second / width };
+		for (int deltaY = -1; deltaY <= 1; ++deltaY)
+		{
+			for (int deltaX = -1; deltaX <= 1; ++deltaX)
+			{
+				const GridPoint neighbour = { point.myX + deltaX, point.myY + deltaY };
+				if (!GetIsStepAllowed(aGrid, point, neighbour))
+					continue;
+
+				const float cost = current.first + (deltaX != 0 && deltaY != 0 ? diagonalCost : 1.0f);
+				const int neighbourIndex = neighbour.myY * width + neighbour.myX;
+				if (cost < costs[neighbourIndex])
+				{
+					costs[neighbourIndex] = cost;
+					openNodes.push({ cost, neighbourIndex });
+				}
+			}
+		}
+	}
+
+	return costs;
+}
+
+// The path has to be walkable step by step from the start to the goal, and as long as the cost it reports
+static bool GetIsPathValid(const NavigationGrid& aGrid, const PathRequest& aRequest, const PathResult& aResult)
+{
+	if (aResult.myPath.empty() || aResult.myPath.front() != aRequest.myStart || aResult.myPath.back() != aRequest.myGoal)
+		return false;
+
+	float length = 0.0f;
+	for (std::size_t i = 1; i < aResult.myPath.size(); ++i)
+	{
+		const GridPoint from = aResult.myPath[i - 1];
+		const GridPoint to = aResult.myPath[i];
+		if (!GetIsStepAllowed(aGrid, from, to))
+			return false;
+
+		length += from.myX != to.myX && from.myY != to.myY ? std::sqrt(2.0f) : 1.0f;
+	}
+
+	return std::abs(length - aResult.myCost) <= PathfindingTestParameters::ourCostTolerance * static_cast<float>(aResult.myPath.size());
+}
+
+// Direct searches have to find shortest paths, the abstraction only has to find a path whenever there is one
+static bool GetIsMatchingBruteForce(const PathfindingService& aService, const std::vector<PathRequest>& someRequests, const std::vector<PathResult>& someResults, bool anIsOptimal)
+{
+	const NavigationGrid& grid = aService.GetGrid();
+	bool isMatch = true;
+	for (std::size_t i = 0; i < someRequests.size(); ++i)
+	{
+		const PathRequest& request = someRequests[i];
+		const PathResult& result = someResults[i];
+		const float cost = GetCosts(grid, request.myStart)[static_cast<std::size_t>(request.myGoal.myY) * grid.GetWidth() + request.myGoal.myX];
+		const bool isReachable = cost != PathfindingTestParameters::ourInfiniteCost;
+		const float tolerance = PathfindingTestParameters::ourCostTolerance * (1.0f + cost);
+
+		bool isRequestMatch = result.myIsFound == isReachable;
+		if (isRequestMatch && isReachable)
+		{
+			isRequestMatch = GetIsPathValid(grid, request, result) && result.myCost >= cost - tolerance;
+			if (anIsOptimal)
+				isRequestMatch = isRequestMatch && result.myCost <= cost + tolerance;
+		}
+
+		if (!isRequestMatch)
+		{
+			printf("Path from (%d, %d) to (%d, %d) %s with cost %.3f, brute force %s with cost %.3f\n",
+				request.myStart.myX,
+				request.myStart.myY,
+				request.myGoal.myX,
+				request.myGoal.myY,
+				result.myIsFound ? "found" : "not found",
+				result.myCost,
+				isReachable ? "found" : "not found",
+				cost);
+		}
+
+		isMatch &= isRequestMatch;
+	}
+
+	return isMatch;
+}
+
+static bool GetIsMatchingSingleQueries(const PathfindingService& aService, const std::vector<PathRequest>& someRequests, const std::vector<PathResult>& someResults)
+{
+	bool isMatch = someResults.size() == someRequests.size();
+	PathResult result;
+	for (std::size_t i = 0; isMatch && i < someRequests.size(); ++i)
+	{
+		aService.FindPath(someRequests[i], result);
+		isMatch = result.myIsFound == someResults[i].myIsFound && result.myCost == someResults[i].myCost && result.myPath == someResults[i].myPath;
+	}
+
+	return isMatch;
+}
+
+static bool TestDirectSearch(std::mt19937& aGenerator)
+{
+	const PathfindingService service(CreateGrid(PathfindingTestParameters::ourSmallWidth, PathfindingTestParameters::ourSmallHeight, aGenerator));
+	const std::vector<PathRequest> requests = CreateRequests(service.GetGrid(), aGenerator);
+	std::vector<PathResult> results;
+	service.FindPaths(requests, results);
+
+	bool isPassing = true;
+	isPassing &= Check("finding shortest paths on a small grid", GetIsMatchingBruteForce(service, requests, results, true));
+	isPassing &= Check("finding the same paths batched as one at a time", GetIsMatchingSingleQueries(service, requests, results));
+	return isPassing;
+}
+
+static bool TestHierarchicalSearch(std::mt19937& aGenerator)
+{
+	PathfindingService service(CreateGrid(PathfindingTestParameters::ourLargeWidth, PathfindingTestParameters::ourLargeHeight, aGenerator));
+	const std::vector<PathRequest> requests = CreateRequests(service.GetGrid(), aGenerator);
+	std::vector<PathResult> results;
+	service.FindPaths(requests, results);
+
+	bool isHierarchical = false;
+	for (const PathResult& result : results)
+		isHierarchical |= result.myStatistics.myIsHierarchical;
+
+	bool isPassing = true;
+	isPassing &= Check("searching through the cluster abstraction", isHierarchical);
+	isPassing &= Check("finding paths through the cluster abstraction", GetIsMatchingBruteForce(service, requests, results, false));
+
+	// Walls are toggled anywhere, cluster borders included, then the abstraction is brought up to date
+	std::uniform_int_distribution<int> xDistribution(0, PathfindingTestParameters::ourLargeWidth - 1);
+	std::uniform_int_distribution<int> yDistribution(0, PathfindingTestParameters::ourLargeHeight - 1);
+	for (std::size_t i = 0; i < PathfindingTestParameters::ourEditCount; ++i)
+	{
+		const int x = xDistribution(aGenerator);
+		const int y = yDistribution(aGenerator);
+		service.SetIsWalkable(x, y, !service.GetGrid().GetIsWalkable(x, y));
+	}
+
+	service.UpdateAbstraction();
+
+	const std::vector<PathRequest> editedRequests = CreateRequests(service.GetGrid(), aGenerator);
+	service.FindPaths(editedRequests, results);
+	isPassing &= Check("finding paths after editing the grid", GetIsMatchingBruteForce(service, editedRequests, results, false));
+	return isPassing;
+}
+
+int main(int /*argc*/, char** /*argv*/)
+{
+	std::mt19937 generator(PathfindingTestParameters::ourSeed);
+
+	bool isPassing = true;
+	isPassing &= TestDirectSearch(generator);
+	isPassing &= TestHierarchicalSearch(generator);
+	return isPassing ? 0 : 1;
+}
@@ -0,0 +1,240 @@
+#include "EntityStore.hpp"
+#include "SnapshotRing.hpp"
+#include "TilePropertyTable.hpp"
+
+#include <glm/vec3.hpp>
+#include <tmxlite/Map.hpp>
+#include <tmxlite/TileLayer.hpp>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace SnapshotRingTestParameters
+{
+	static constexpr int ourMapSize = 32;
+	static constexpr std::size_t ourEntityCount = 64;
+	// Ticks 0 to this are recorded, all within one keyframe interval so the later ones are deltas
+	static constexpr std::uint32_t ourNewestTick = 10;
+	static constexpr std::size_t ourCapacity = 1024 * 1024;
+	static constexpr std::size_t ourRecordCount = 64;
+	static constexpr unsigned int ourKeyframeInterval = 60;
+	// Small enough to hold a few keyframe intervals at most, so recording this many ticks evicts and wraps
+	static constexpr std::size_t ourSmallCapacity = 64 * 1024;
+	static constexpr unsigned int ourShortKeyframeInterval = 4;
+	static constexpr std::uint32_t ourSmallRingNewestTick = 100;
+}
+
+struct TickState
+{
+	std::vector<std::uint32_t> myEntityWords;
+	std::vector<std::uint32_t> myGIDs;
+	glm::vec3 myCameraPosition;
+};
+
+static std::string CreateTMX()
+{
+	const std::string size = std::to_string(SnapshotRingTestParameters::ourMapSize);
+	std::string tmx = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<map version=\"1.0\" orientation=\"orthogonal\" renderorder=\"right-down\" width=\"" + size + "\" height=\"" + size + "\" tilewidth=\"64\" tileheight=\"64\" nextobjectid=\"1\">\n"
+		" <tileset firstgid=\"1\" name=\"tileset\" tilewidth=\"64\" tileheight=\"64\" tilecount=\"42\" columns=\"6\">\n  <image source=\"Tilesets/tileset.png\" width=\"384\" height=\"448\"/>\n </tileset>\n"
+		" <layer name=\"Tile Layer 1\" width=\"" + size + "\" height=\"" + size + "\">\n  <data encoding=\"csv\">\n";
+
+	const int cellCount = SnapshotRingTestParameters::ourMapSize * SnapshotRingTestParameters::ourMapSize;
+	for (int i = 0; i < cellCount; ++i)
+		tmx += i + 1 < cellCount ? ((i + 1) % SnapshotRingTestParameters::ourMapSize == 0 ? "1,\n" : "1,") : "1";
+
+	tmx += "\n  </data>\n </layer>\n</map>\n";
+	return tmx;
+}
+
+// Every variant moves the entities and edits the tiles differently, so a tick simulated again differs from the first time
+static void Simulate(std::uint32_t aTick, std::uint32_t aVariant, EntityStore& anEntityStore, TilePropertyTable& aTileTable, glm::vec3& aCameraPosition)
+{
+	float* positionsX = anEntityStore.GetPositionsX();
+	float* positionsY = anEntityStore.GetPositionsY();
+	const float* velocitiesX = anEntityStore.GetVelocitiesX();
+	const float* velocitiesY = anEntityStore.GetVelocitiesY();
+	for (std::size_t i = 0; i < anEntityStore.GetCount(); ++i)
+	{
+		// Only some entities move each tick, so deltas have unchanged runs to skip
+		if ((i + aTick + aVariant) % 3 != 0)
+			continue;
+
+		positionsX[i] += velocitiesX[i] * static_cast<float>(1 + aVariant);
+		positionsY[i] += velocitiesY[i] * static_cast<float>(1 + aVariant);
+	}
+
+	const int size = SnapshotRingTestParameters::ourMapSize;
+	aTileTable.SetGID(0, static_cast<int>(aTick * 7 + aVariant * 13) % size, static_cast<int>(aTick * 5 + aVariant * 11) % size, 2 + (aTick + aVariant) % 40);
+	aCameraPosition.x += static_cast<float>(1 + aVariant);
+}
+
+static TickState Capture(const EntityStore& anEntityStore, const TilePropertyTable& aTileTable, const glm::vec3& aCameraPosition)
+{
+	TickState state;
+	anEntityStore.WriteState(state.myEntityWords);
+	for (int y = 0; y < aTileTable.GetHeight(); ++y)
+	{
+		for (int x = 0; x < aTileTable.GetWidth(); ++x)
+			state.myGIDs.push_back(aTileTable.GetGID(0, x, y));
+	}
+
+	state.myCameraPosition = aCameraPosition;
+	return state;
+}
+
+static bool Check(const char* aName, bool anIsPassing)
+{
+	printf("%s %s\n", anIsPassing ? "Passed" : "Failed", aName);
+	return anIsPassing;
+}
+
+// Prints what differed, whether the restore passed is up to the caller
+static bool GetIsRestored(SnapshotRing& aSnapshotRing, std::uint32_t aTick, EntityStore& anEntityStore, TilePropertyTable& aTileTable, const TickState& anExpectedState)
+{
+	glm::vec3 cameraPosition(0.0f);
+	if (!aSnapshotRing.Restore(aTick, anEntityStore, aTileTable, cameraPosition))
+	{
+		printf("Tick %u couldn't be restored\n", aTick);
+		return false;
+	}
+
+	const TickState state = Capture(anEntityStore, aTileTable, cameraPosition);
+	const bool isEntityMatch = state.myEntityWords == anExpectedState.myEntityWords;
+	const bool isTileMatch = state.myGIDs == anExpectedState.myGIDs;
+	const bool isCameraMatch = state.myCameraPosition == anExpectedState.myCameraPosition;
+	if (isEntityMatch && isTileMatch && isCameraMatch)
+		return true;
+
+	printf("Tick %u restored with different%s%s%s\n", aTick, isEntityMatch ? "" : " entities", isTileMatch ? "" : " tiles", isCameraMatch ? "" : " camera");
+	return false;
+}
+
+static void PopulateEntities(EntityStore& anEntityStore)
+{
+	for (std::size_t i = 0; i < SnapshotRingTestParameters::ourEntityCount; ++i)
+	{
+		const float value = static_cast<float>(i);
+		anEntityStore.CreateEntity(value, -value, 1.0f + value * 0.25f, 2.0f - value * 0.5f);
+	}
+}
+
+// Records ticks 0 to aNewestTick, keeping what every tick looked like
+static std::vector<TickState> RecordTicks(std::uint32_t aNewestTick, SnapshotRing& aSnapshotRing, EntityStore& anEntityStore, TilePropertyTable& aTileTable, glm::vec3& aCameraPosition)
+{
+	std::vector<TickState> states;
+	for (std::uint32_t tick = 0; tick <= aNewestTick; ++tick)
+	{
+		if (tick > 0)
+			Simulate(tick, 0, anEntityStore, aTileTable, aCameraPosition);
+
+		aSnapshotRing.Record(tick, anEntityStore, aTileTable, aCameraPosition);
+		states.push_back(Capture(anEntityStore, aTileTable, aCameraPosition));
+	}
+
+	return states;
+}
+
+static bool TestReplacing(const tmx::Map& aMap)
+{
+	const int size = SnapshotRingTestParameters::ourMapSize;
+	TilePropertyTable tileTable(aMap.getTilesets(), size, size);
+	tileTable.AddLayer(aMap.getLayers()[0]->getLayerAs<tmx::TileLayer>());
+
+	EntityStore entityStore;
+	PopulateEntities(entityStore);
+
+	SnapshotRing snapshotRing(SnapshotRingTestParameters::ourCapacity, SnapshotRingTestParameters::ourRecordCount, SnapshotRingTestParameters::ourKeyframeInterval);
+	glm::vec3 cameraPosition(0.0f);
+	const std::vector<TickState> states = RecordTicks(SnapshotRingTestParameters::ourNewestTick, snapshotRing, entityStore, tileTable, cameraPosition);
+
+	bool isPassing = true;
+	isPassing &= Check("restoring a recorded tick", GetIsRestored(snapshotRing, SnapshotRingTestParameters::ourNewestTick, entityStore, tileTable, states.back()));
+
+	// Recording an earlier tick again drops it and the ticks after it, recording then carries on from there
+	const std::uint32_t replacedTick = SnapshotRingTestParameters::ourNewestTick - 2;
+	Simulate(replacedTick, 1, entityStore, tileTable, cameraPosition);
+	snapshotRing.Record(replacedTick, entityStore, tileTable, cameraPosition);
+	const TickState replacedState = Capture(entityStore, tileTable, cameraPosition);
+
+	Simulate(replacedTick + 1, 1, entityStore, tileTable, cameraPosition);
+	snapshotRing.Record(replacedTick + 1, entityStore, tileTable, cameraPosition);
+	const TickState nextState = Capture(entityStore, tileTable, cameraPosition);
+
+	isPassing &= Check("restoring the tick after a replaced tick", GetIsRestored(snapshotRing, replacedTick + 1, entityStore, tileTable, nextState));
+	isPassing &= Check("restoring a replaced tick", GetIsRestored(snapshotRing, replacedTick, entityStore, tileTable, replacedState));
+	isPassing &= Check("restoring the tick before a replaced tick", GetIsRestored(snapshotRing, replacedTick - 1, entityStore, tileTable, states[replacedTick - 1]));
+	return isPassing;
+}
+
+static bool TestEviction(const tmx::Map& aMap)
+{
+	const int size = SnapshotRingTestParameters::ourMapSize;
+	TilePropertyTable tileTable(aMap.getTilesets(), size, size);
+	tileTable.AddLayer(aMap.getLayers()[0]->getLayerAs<tmx::TileLayer>());
+
+	EntityStore entityStore;
+	PopulateEntities(entityStore);
+
+	SnapshotRing snapshotRing(SnapshotRingTestParameters::ourSmallCapacity, SnapshotRingTestParameters::ourRecordCount, SnapshotRingTestParameters::ourShortKeyframeInterval);
+	glm::vec3 cameraPosition(0.0f);
+	const std::vector<TickState> states = RecordTicks(SnapshotRingTestParameters::ourSmallRingNewestTick, snapshotRing, entityStore, tileTable, cameraPosition);
+
+	// Every record is placed whole, so once the oldest have been evicted later ones went back to the start of the buffer
+	const std::uint32_t oldestTick = snapshotRing.GetOldestTick();
+	bool isPassing = true;
+	isPassing &= Check("evicting the oldest ticks", oldestTick > 0 && snapshotRing.GetNewestTick() == SnapshotRingTestParameters::ourSmallRingNewestTick && snapshotRing.GetUsedBytes() <= snapshotRing.GetCapacity());
+	isPassing &= Check("evicting whole keyframe intervals", oldestTick % SnapshotRingTestParameters::ourShortKeyframeInterval == 0 && !snapshotRing.GetHasTick(oldestTick - 1));
+
+	// Stepping back a tick at a time, like rewinding does, restores keyframes, the deltas after them and the
+	// last delta before the next keyframe
+	bool isRestored = true;
+	for (std::uint32_t tick = SnapshotRingTestParameters::ourSmallRingNewestTick; tick > oldestTick; --tick)
+		isRestored &= GetIsRestored(snapshotRing, tick, entityStore, tileTable, states[tick]);
+
+	isPassing &= Check("restoring across keyframe boundaries after wrapping", isRestored);
+	isPassing &= Check("restoring the oldest surviving tick", GetIsRestored(snapshotRing, oldestTick, entityStore, tileTable, states[oldestTick]));
+
+	glm::vec3 evictedCameraPosition(0.0f);
+	isPassing &= Check("not restoring an evicted tick", !snapshotRing.Restore(oldestTick - 1, entityStore, tileTable, evictedCameraPosition));
+	return isPassing;
+}
+
+static bool TestEvictedKeyframe(const tmx::Map& aMap)
+{
+	const int size = SnapshotRingTestParameters::ourMapSize;
+	TilePropertyTable tileTable(aMap.getTilesets(), size, size);
+	tileTable.AddLayer(aMap.getLayers()[0]->getLayerAs<tmx::TileLayer>());
+
+	EntityStore entityStore;
+	PopulateEntities(entityStore);
+
+	// With the keyframe interval longer than the run, tick 0 is the only keyframe scheduled. Once the ring is
+	// full, making room for a delta evicts it, so that delta has to be stored as a keyframe instead.
+	SnapshotRing snapshotRing(SnapshotRingTestParameters::ourSmallCapacity, SnapshotRingTestParameters::ourRecordCount, SnapshotRingTestParameters::ourKeyframeInterval);
+	glm::vec3 cameraPosition(0.0f);
+	const std::vector<TickState> states = RecordTicks(SnapshotRingTestParameters::ourSmallRingNewestTick, snapshotRing, entityStore, tileTable, cameraPosition);
+
+	const std::uint32_t oldestTick = snapshotRing.GetOldestTick();
+	bool isPassing = true;
+	isPassing &= Check("falling back to a keyframe when a delta's keyframe is evicted", oldestTick > 0 && snapshotRing.GetNewestTick() == SnapshotRingTestParameters::ourSmallRingNewestTick);
+	isPassing &= Check("restoring a delta after a fallback keyframe", GetIsRestored(snapshotRing, SnapshotRingTestParameters::ourSmallRingNewestTick, entityStore, tileTable, states.back()));
+	isPassing &= Check("restoring a fallback keyframe", GetIsRestored(snapshotRing, oldestTick, entityStore, tileTable, states[oldestTick]));
+	return isPassing;
+}
+
+int main(int /*argc*/, char** /*argv*/)
+{
+	tmx::Map map;
+	if (!map.loadFromString(CreateTMX(), "Data/Tilemaps"))
+	{
+		printf("Failed to parse the test map\n");
+		return 1;
+	}
+
+	bool isPassing = true;
+	isPassing &= TestReplacing(map);
+	isPassing &= TestEviction(map);
+	isPassing &= TestEvictedKeyframe(map);
+	return isPassing ? 0 : 1;
+}
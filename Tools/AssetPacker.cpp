@@ -0,0 +1,192 @@
+#include "AssetPack.hpp"
+#include "JobSystem.hpp"
+#include "LZ4.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace AssetPackerParameters
+{
+	// Compressed entries are only kept when they save at least an eighth, already compressed images rarely do
+	static constexpr std::size_t ourMinimumSavingsDivisor = 8;
+}
+
+struct Options
+{
+	std::string myOutputFilePath = std::string("Binaries/") + AssetPack::ourDefaultFilepath;
+	std::vector<std::string> myDirectories;
+	bool myIsCompressing = true;
+};
+
+struct PackedFile
+{
+	std::string myPath;
+	std::vector<std::uint8_t> myData;
+	std::vector<std::uint8_t> myCompressedData;
+};
+
+static std::uint64_t GetAligned(std::uint64_t anOffset)
+{
+	return (anOffset + AssetPack::ourAlignment - 1) / AssetPack::ourAlignment * AssetPack::ourAlignment;
+}
+
+static bool ReadFile(const std::filesystem::path& aFilepath, std::vector<std::uint8_t>& someData)
+{
+	std::ifstream file(aFilepath, std::ifstream::binary);
+	if (!file.is_open())
+		return false;
+
+	someData.resize(static_cast<std::size_t>(std::filesystem::file_size(aFilepath)));
+	file.read(reinterpret_cast<char*>(someData.data()), static_cast<std::streamsize>(someData.size()));
+	return file.gcount() == static_cast<std::streamsize>(someData.size());
+}
+
+static bool ParseOptions(int argc, char** argv, Options& someOptions)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+			someOptions.myOutputFilePath = argv[++i];
+		else if (std::strcmp(argv[i], "--no-compression") == 0)
+			someOptions.myIsCompressing = false;
+		else if (argv[i][0] != '-')
+			someOptions.myDirectories.emplace_back(argv[i]);
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return false;
+		}
+	}
+
+	if (someOptions.myDirectories.empty())
+		someOptions.myDirectories.emplace_back("Data");
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		fprintf(stderr, "Usage: AssetPacker [--output Binaries/%s] [--no-compression] [directories, Data by default]\n", AssetPack::ourDefaultFilepath);
+		return 1;
+	}
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// Entries keep the path they're read by, relative to the working directory the game runs in
+	std::vector<PackedFile> files;
+	for (const std::string& directory : options.myDirectories)
+	{
+		if (!std::filesystem::is_directory(directory))
+		{
+			fprintf(stderr, "%s is not a directory\n", directory.c_str());
+			return 1;
+		}
+
+		for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator(directory))
+		{
+			if (entry.is_regular_file())
+				files.push_back({ entry.path().lexically_normal().generic_string(), {}, {} });
+		}
+	}
+
+	std::sort(files.begin(), files.end(), [](const PackedFile& aFirst, const PackedFile& aSecond) { return aFirst.myPath < aSecond.myPath; });
+	files.erase(std::unique(files.begin(), files.end(), [](const PackedFile& aFirst, const PackedFile& aSecond) { return aFirst.myPath == aSecond.myPath; }), files.end());
+
+	std::vector<char> isRead(files.size(), 0);
+	JobSystem::GetInstance().ParallelFor(files.size(), 1, [&](std::size_t aBegin, std::size_t anEnd)
+		{
+			for (std::size_t i = aBegin; i < anEnd; ++i)
+			{
+				PackedFile& file = files[i];
+				isRead[i] = ReadFile(file.myPath, file.myData) ? 1 : 0;
+				if (!isRead[i] || !options.myIsCompressing)
+					continue;
+
+				file.myCompressedData.resize(LZ4::GetMaximumCompressedSize(file.myData.size()));
+				const std::size_t compressedSize = LZ4::Compress(file.myData.data(), file.myData.size(), file.myCompressedData.data(), file.myCompressedData.size());
+				if (compressedSize + file.myData.size() / AssetPackerParameters::ourMinimumSavingsDivisor < file.myData.size())
+					file.myCompressedData.resize(compressedSize);
+				else
+					std::vector<std::uint8_t>().swap(file.myCompressedData);
+			}
+		});
+
+	AssetPackHeader header;
+	std::memcpy(header.myMagic, AssetPack::ourMagic, sizeof(header.myMagic));
+	header.myVersion = AssetPack::ourVersion;
+	header.myEntryCount = static_cast<std::uint32_t>(files.size());
+	header.myPathTableSize = 0;
+
+	std::vector<AssetPackEntry> entries(files.size());
+	std::string paths;
+	for (std::size_t i = 0; i < files.size(); ++i)
+	{
+		if (!isRead[i])
+		{
+			fprintf(stderr, "Failed to read %s\n", files[i].myPath.c_str());
+			return 1;
+		}
+
+		entries[i].myPathOffset = static_cast<std::uint32_t>(paths.size());
+		entries[i].myPathLength = static_cast<std::uint32_t>(files[i].myPath.size());
+		paths += files[i].myPath;
+	}
+	header.myPathTableSize = static_cast<std::uint32_t>(paths.size());
+
+	std::uint64_t offset = GetAligned(sizeof(AssetPackHeader) + entries.size() * sizeof(AssetPackEntry) + paths.size());
+	std::uint64_t compressedCount = 0;
+	for (std::size_t i = 0; i < files.size(); ++i)
+	{
+		const bool isCompressed = !files[i].myCompressedData.empty();
+		entries[i].myDataOffset = offset;
+		entries[i].mySize = files[i].myData.size();
+		entries[i].myStoredSize = isCompressed ? files[i].myCompressedData.size() : files[i].myData.size();
+		offset = GetAligned(offset + entries[i].myStoredSize);
+		compressedCount += isCompressed ? 1 : 0;
+	}
+
+	const std::filesystem::path outputPath(options.myOutputFilePath);
+	if (outputPath.has_parent_path())
+		std::filesystem::create_directories(outputPath.parent_path());
+
+	std::ofstream output(outputPath, std::ofstream::binary | std::ofstream::trunc);
+	output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	output.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(AssetPackEntry)));
+	output.write(paths.data(), static_cast<std::streamsize>(paths.size()));
+
+	const char padding[AssetPack::ourAlignment] = {};
+	std::uint64_t written = sizeof(header) + entries.size() * sizeof(AssetPackEntry) + paths.size();
+	for (std::size_t i = 0; i < files.size(); ++i)
+	{
+		output.write(padding, static_cast<std::streamsize>(entries[i].myDataOffset - written));
+		const std::vector<std::uint8_t>& data = files[i].myCompressedData.empty() ? files[i].myData : files[i].myCompressedData;
+		output.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+		written = entries[i].myDataOffset + data.size();
+	}
+
+	output.close();
+	if (!output)
+	{
+		fprintf(stderr, "Failed to write %s\n", outputPath.string().c_str());
+		return 1;
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("Packed %zu files, %llu of them compressed, into %s (%llu bytes) in %.2f s\n",
+		files.size(),
+		static_cast<unsigned long long>(compressedCount),
+		outputPath.string().c_str(),
+		static_cast<unsigned long long>(written),
+		seconds);
+
+	return 0;
+}
@@ -0,0 +1,467 @@
+#include "JobSystem.hpp"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace StressMapGeneratorParameters
+{
+	// Rows are generated and encoded in blocks of a multiple of three rows, so every block of
+	// uncompressed tile data is a whole number of base64 groups and the blocks can be concatenated
+	static constexpr std::size_t ourBlockTileCount = 64 * 1024;
+	// Blocks handed to the workers at once, bounds the memory held before it's written out
+	static constexpr std::size_t ourBlocksPerWorker = 8;
+	// Uncompressed tile data held at once while layers are compressed side by side
+	static constexpr std::size_t ourCompressionMemoryBudget = 1024 * 1024 * 1024;
+	// The lowest stb accepts, its deflate is slow and tile data compresses about as well either way
+	static constexpr int ourZlibQuality = 5;
+	static constexpr unsigned int ourTileSize = 64;
+	static constexpr std::uint32_t ourFlipShift = 29;
+}
+
+enum class Encoding
+{
+	CSV,
+	Base64
+};
+
+enum class Compression
+{
+	None,
+	Zlib
+};
+
+struct TilesetDescription
+{
+	const char* myName;
+	// Set for tilesets kept in their own .tsx file, the others are written inline
+	const char* mySource;
+	const char* myImage;
+	unsigned int myTileWidth;
+	unsigned int myTileHeight;
+	unsigned int myTileCount;
+	unsigned int myColumns;
+	unsigned int myImageWidth;
+	unsigned int myImageHeight;
+};
+
+// The tilesets in Data/Tilemaps/Tilesets, reused round robin when more are asked for
+static constexpr TilesetDescription ourTilesets[] =
+{
+	{ "platform", "platform.tsx", nullptr, 64, 64, 42, 6, 384, 448 },
+	{ "tileset", nullptr, "tileset.png", 64, 64, 42, 6, 384, 448 },
+	{ "tileset02", nullptr, "tileset02.png", 32, 32, 24, 6, 192, 128 }
+};
+
+struct Options
+{
+	// Outside of Data, which is copied next to the game, packed and scanned for tilesets to bake
+	std::string myOutputFilePath = "Binaries/StressMaps/Stress.tmx";
+	std::string myTilesetDirectory = "Data/Tilemaps/Tilesets";
+	unsigned int myWidth = 1024;
+	unsigned int myHeight = 1024;
+	unsigned int myLayerCount = 3;
+	unsigned int myTilesetCount = 1;
+	float myDensity = 0.9f;
+	float myFlipFrequency = 0.05f;
+	Encoding myEncoding = Encoding::Base64;
+	Compression myCompression = Compression::Zlib;
+	std::uint64_t mySeed = 1234;
+};
+
+struct Tileset
+{
+	const TilesetDescription* myDescription;
+	std::uint32_t myFirstGID;
+};
+
+// SplitMix64, seeded per layer and row so the output doesn't depend on how rows are spread over workers
+static std::uint64_t GetNextRandom(std::uint64_t& aState)
+{
+	aState += 0x9E3779B97F4A7C15ull;
+	std::uint64_t value = aState;
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+	return value ^ (value >> 31);
+}
+
+static std::uint64_t GetRowSeed(std::uint64_t aSeed, unsigned int aLayer, unsigned int aRow)
+{
+	std::uint64_t state = aSeed ^ (static_cast<std::uint64_t>(aLayer) << 32 | aRow);
+	GetNextRandom(state);
+	return state;
+}
+
+static void GenerateRow(const Options& someOptions, std::uint32_t aTileCount, unsigned int aLayer, unsigned int aRow, std::uint32_t* someGIDs)
+{
+	// Thresholds on the top 32 bits of a random value instead of float comparisons per tile
+	const std::uint64_t densityThreshold = static_cast<std::uint64_t>(static_cast<double>(someOptions.myDensity) * 4294967296.0);
+	const std::uint64_t flipThreshold = static_cast<std::uint64_t>(static_cast<double>(someOptions.myFlipFrequency) * 4294967296.0);
+
+	std::uint64_t state = GetRowSeed(someOptions.mySeed, aLayer, aRow);
+	for (unsigned int x = 0; x < someOptions.myWidth; ++x)
+	{
+		const std::uint64_t random = GetNextRandom(state);
+		if ((random >> 32) >= densityThreshold)
+		{
+			someGIDs[x] = 0;
+			continue;
+		}
+
+		const std::uint32_t gid = static_cast<std::uint32_t>((random & 0xFFFFFFFFull) % aTileCount) + 1;
+		const std::uint64_t flipRandom = GetNextRandom(state);
+		const std::uint32_t flipFlags = (flipRandom >> 32) < flipThreshold ? static_cast<std::uint32_t>(flipRandom % 7) + 1 : 0;
+		someGIDs[x] = gid | (flipFlags << StressMapGeneratorParameters::ourFlipShift);
+	}
+}
+
+// Appends without padding as long as the byte count is a multiple of three
+static void AppendBase64(const std::uint8_t* someBytes, std::size_t aCount, std::string& anOutput)
+{
+	static constexpr char ourAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	const std::size_t start = anOutput.size();
+	anOutput.resize(start + (aCount + 2) / 3 * 4);
+	char* output = &anOutput[start];
+	for (std::size_t i = 0; i < aCount; i += 3)
+	{
+		const std::size_t remaining = aCount - i;
+		const std::uint32_t triple = (static_cast<std::uint32_t>(someBytes[i]) << 16) | (remaining > 1 ? static_cast<std::uint32_t>(someBytes[i + 1]) << 8 : 0) | (remaining > 2 ? someBytes[i + 2] : 0);
+		*output++ = ourAlphabet[(triple >> 18) & 63];
+		*output++ = ourAlphabet[(triple >> 12) & 63];
+		*output++ = remaining > 1 ? ourAlphabet[(triple >> 6) & 63] : '=';
+		*output++ = remaining > 2 ? ourAlphabet[triple & 63] : '=';
+	}
+}
+
+static void AppendCSV(const std::uint32_t* someGIDs, unsigned int aWidth, bool anIsLastRow, std::string& anOutput)
+{
+	char number[16];
+	for (unsigned int x = 0; x < aWidth; ++x)
+	{
+		const int length = snprintf(number, sizeof(number), "%u", someGIDs[x]);
+		anOutput.append(number, static_cast<std::size_t>(length));
+		if (x + 1 < aWidth || !anIsLastRow)
+			anOutput += ',';
+	}
+	anOutput += '\n';
+}
+
+static void AppendLittleEndian(const std::uint32_t* someGIDs, unsigned int aCount, std::uint8_t* someBytes)
+{
+	for (unsigned int i = 0; i < aCount; ++i)
+	{
+		someBytes[i * 4 + 0] = static_cast<std::uint8_t>(someGIDs[i]);
+		someBytes[i * 4 + 1] = static_cast<std::uint8_t>(someGIDs[i] >> 8);
+		someBytes[i * 4 + 2] = static_cast<std::uint8_t>(someGIDs[i] >> 16);
+		someBytes[i * 4 + 3] = static_cast<std::uint8_t>(someGIDs[i] >> 24);
+	}
+}
+
+static bool Write(std::FILE* aFile, const std::string& aText)
+{
+	return std::fwrite(aText.data(), 1, aText.size(), aFile) == aText.size();
+}
+
+// Uncompressed layers are streamed a batch of row blocks at a time, each block generated and encoded by one job
+static bool WriteStreamedLayer(std::FILE* aFile, const Options& someOptions, std::uint32_t aTileCount, unsigned int aLayer)
+{
+	JobSystem& jobSystem = JobSystem::GetInstance();
+	const unsigned int blockRows = static_cast<unsigned int>(std::max<std::size_t>(StressMapGeneratorParameters::ourBlockTileCount / someOptions.myWidth / 3, 1) * 3);
+	const std::size_t blockCount = (someOptions.myHeight + blockRows - 1) / blockRows;
+	const std::size_t batchSize = jobSystem.GetWorkerCount() * StressMapGeneratorParameters::ourBlocksPerWorker;
+
+	std::vector<std::string> texts(std::min(batchSize, blockCount));
+	for (std::size_t batchBegin = 0; batchBegin < blockCount; batchBegin += batchSize)
+	{
+		const std::size_t batchEnd = std::min(batchBegin + batchSize, blockCount);
+		jobSystem.ParallelFor(batchEnd - batchBegin, 1, [&](std::size_t aBegin, std::size_t anEnd)
+			{
+				std::vector<std::uint32_t> gids(someOptions.myWidth);
+				std::vector<std::uint8_t> bytes;
+				for (std::size_t i = aBegin; i < anEnd; ++i)
+				{
+					std::string& text = texts[i];
+					text.clear();
+
+					const unsigned int rowBegin = static_cast<unsigned int>((batchBegin + i) * blockRows);
+					const unsigned int rowEnd = std::min(rowBegin + blockRows, someOptions.myHeight);
+					for (unsigned int row = rowBegin; row < rowEnd; ++row)
+					{
+						GenerateRow(someOptions, aTileCount, aLayer, row, gids.data());
+						if (someOptions.myEncoding == Encoding::CSV)
+						{
+							AppendCSV(gids.data(), someOptions.myWidth, row + 1 == someOptions.myHeight, text);
+						}
+						else
+						{
+							const std::size_t offset = bytes.size();
+							bytes.resize(offset + static_cast<std::size_t>(someOptions.myWidth) * 4);
+							AppendLittleEndian(gids.data(), someOptions.myWidth, &bytes[offset]);
+						}
+					}
+
+					if (someOptions.myEncoding == Encoding::Base64)
+					{
+						AppendBase64(bytes.data(), bytes.size(), text);
+						bytes.clear();
+					}
+				}
+			});
+
+		for (std::size_t i = 0; i < batchEnd - batchBegin; ++i)
+		{
+			if (!Write(aFile, texts[i]))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+static std::string CreateLayerHeader(const Options& someOptions, unsigned int aLayer)
+{
+	std::string header = " <layer id=\"" + std::to_string(aLayer + 1) + "\" name=\"Layer " + std::to_string(aLayer + 1)
+		+ "\" width=\"" + std::to_string(someOptions.myWidth) + "\" height=\"" + std::to_string(someOptions.myHeight) + "\">\n";
+	if (someOptions.myEncoding == Encoding::CSV)
+		header += "  <data encoding=\"csv\">\n";
+	else if (someOptions.myCompression == Compression::Zlib)
+		header += "  <data encoding=\"base64\" compression=\"zlib\">\n";
+	else
+		header += "  <data encoding=\"base64\">\n";
+
+	return header;
+}
+
+static std::string GetLayerFooter(const Options& someOptions)
+{
+	return someOptions.myEncoding == Encoding::CSV ? "  </data>\n </layer>\n" : "\n  </data>\n </layer>\n";
+}
+
+// A zlib stream can't be split, so layers are compressed side by side instead. The rows of a group
+// of layers are generated in parallel, then every layer is compressed and encoded by a job of its own.
+static bool WriteCompressedLayers(std::FILE* aFile, const Options& someOptions, std::uint32_t aTileCount)
+{
+	JobSystem& jobSystem = JobSystem::GetInstance();
+	const std::size_t rowSize = static_cast<std::size_t>(someOptions.myWidth) * 4;
+	const std::size_t layerSize = rowSize * someOptions.myHeight;
+	if (layerSize > static_cast<std::size_t>(INT_MAX))
+	{
+		fprintf(stderr, "A layer of %ux%u tiles is too large to compress with zlib, use --compression none\n", someOptions.myWidth, someOptions.myHeight);
+		return false;
+	}
+
+	const std::size_t groupSize = std::clamp<std::size_t>(StressMapGeneratorParameters::ourCompressionMemoryBudget / layerSize, 1, jobSystem.GetWorkerCount());
+	std::vector<std::vector<std::uint8_t>> layerBytes(std::min<std::size_t>(groupSize, someOptions.myLayerCount));
+	std::vector<std::string> texts(layerBytes.size());
+	for (unsigned int groupBegin = 0; groupBegin < someOptions.myLayerCount; groupBegin += static_cast<unsigned int>(groupSize))
+	{
+		const unsigned int groupEnd = std::min(groupBegin + static_cast<unsigned int>(groupSize), someOptions.myLayerCount);
+		for (unsigned int layer = groupBegin; layer < groupEnd; ++layer)
+			layerBytes[layer - groupBegin].resize(layerSize);
+
+		jobSystem.ParallelFor(static_cast<std::size_t>(groupEnd - groupBegin) * someOptions.myHeight, 16, [&](std::size_t aBegin, std::size_t anEnd)
+			{
+				std::vector<std::uint32_t> gids(someOptions.myWidth);
+				for (std::size_t i = aBegin; i < anEnd; ++i)
+				{
+					const std::size_t layerIndex = i / someOptions.myHeight;
+					const unsigned int row = static_cast<unsigned int>(i % someOptions.myHeight);
+					GenerateRow(someOptions, aTileCount, groupBegin + static_cast<unsigned int>(layerIndex), row, gids.data());
+					AppendLittleEndian(gids.data(), someOptions.myWidth, &layerBytes[layerIndex][row * rowSize]);
+				}
+			});
+
+		jobSystem.ParallelFor(groupEnd - groupBegin, 1, [&](std::size_t aBegin, std::size_t anEnd)
+			{
+				for (std::size_t i = aBegin; i < anEnd; ++i)
+				{
+					texts[i].clear();
+
+					int compressedSize = 0;
+					unsigned char* compressed = stbi_zlib_compress(layerBytes[i].data(), static_cast<int>(layerSize), &compressedSize, StressMapGeneratorParameters::ourZlibQuality);
+					if (!compressed)
+						continue;
+
+					AppendBase64(compressed, static_cast<std::size_t>(compressedSize), texts[i]);
+					STBIW_FREE(compressed);
+				}
+			});
+
+		for (unsigned int layer = groupBegin; layer < groupEnd; ++layer)
+		{
+			const std::string& text = texts[layer - groupBegin];
+			if (text.empty() || !Write(aFile, CreateLayerHeader(someOptions, layer)) || !Write(aFile, text) || !Write(aFile, GetLayerFooter(someOptions)))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+static std::string CreateHeader(const Options& someOptions, const std::vector<Tileset>& someTilesets, const std::string& aTilesetPath)
+{
+	std::string header = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+	header += "<map version=\"1.9\" orientation=\"orthogonal\" renderorder=\"right-down\" width=\"" + std::to_string(someOptions.myWidth)
+		+ "\" height=\"" + std::to_string(someOptions.myHeight)
+		+ "\" tilewidth=\"" + std::to_string(StressMapGeneratorParameters::ourTileSize)
+		+ "\" tileheight=\"" + std::to_string(StressMapGeneratorParameters::ourTileSize)
+		+ "\" infinite=\"0\" nextlayerid=\"" + std::to_string(someOptions.myLayerCount + 1) + "\" nextobjectid=\"1\">\n";
+
+	for (std::size_t i = 0; i < someTilesets.size(); ++i)
+	{
+		const TilesetDescription& description = *someTilesets[i].myDescription;
+		const std::string firstGID = std::to_string(someTilesets[i].myFirstGID);
+		if (description.mySource)
+		{
+			header += " <tileset firstgid=\"" + firstGID + "\" source=\"" + aTilesetPath + description.mySource + "\"/>\n";
+			continue;
+		}
+
+		header += " <tileset firstgid=\"" + firstGID + "\" name=\"" + description.myName + "_" + std::to_string(i)
+			+ "\" tilewidth=\"" + std::to_string(description.myTileWidth)
+			+ "\" tileheight=\"" + std::to_string(description.myTileHeight)
+			+ "\" tilecount=\"" + std::to_string(description.myTileCount)
+			+ "\" columns=\"" + std::to_string(description.myColumns) + "\">\n";
+		header += "  <image source=\"" + aTilesetPath + description.myImage
+			+ "\" width=\"" + std::to_string(description.myImageWidth)
+			+ "\" height=\"" + std::to_string(description.myImageHeight) + "\"/>\n";
+		header += " </tileset>\n";
+	}
+
+	return header;
+}
+
+static bool ParseOptions(int argc, char** argv, Options& someOptions)
+{
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const char* value = argv[i + 1];
+		if (std::strcmp(argv[i], "--output") == 0)
+			someOptions.myOutputFilePath = value;
+		else if (std::strcmp(argv[i], "--tileset-directory") == 0)
+			someOptions.myTilesetDirectory = value;
+		else if (std::strcmp(argv[i], "--width") == 0)
+			someOptions.myWidth = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+		else if (std::strcmp(argv[i], "--height") == 0)
+			someOptions.myHeight = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+		else if (std::strcmp(argv[i], "--layers") == 0)
+			someOptions.myLayerCount = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+		else if (std::strcmp(argv[i], "--tilesets") == 0)
+			someOptions.myTilesetCount = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+		else if (std::strcmp(argv[i], "--density") == 0)
+			someOptions.myDensity = std::clamp(std::strtof(value, nullptr), 0.0f, 1.0f);
+		else if (std::strcmp(argv[i], "--flips") == 0)
+			someOptions.myFlipFrequency = std::clamp(std::strtof(value, nullptr), 0.0f, 1.0f);
+		else if (std::strcmp(argv[i], "--seed") == 0)
+			someOptions.mySeed = std::strtoull(value, nullptr, 10);
+		else if (std::strcmp(argv[i], "--encoding") == 0 && std::strcmp(value, "csv") == 0)
+			someOptions.myEncoding = Encoding::CSV;
+		else if (std::strcmp(argv[i], "--encoding") == 0 && std::strcmp(value, "base64") == 0)
+			someOptions.myEncoding = Encoding::Base64;
+		else if (std::strcmp(argv[i], "--compression") == 0 && std::strcmp(value, "none") == 0)
+			someOptions.myCompression = Compression::None;
+		else if (std::strcmp(argv[i], "--compression") == 0 && std::strcmp(value, "zlib") == 0)
+			someOptions.myCompression = Compression::Zlib;
+		else
+		{
+			fprintf(stderr, "Unknown option %s %s\n", argv[i], value);
+			return false;
+		}
+	}
+
+	if (someOptions.myWidth == 0 || someOptions.myHeight == 0 || someOptions.myLayerCount == 0 || someOptions.myTilesetCount == 0)
+	{
+		fprintf(stderr, "Width, height, layers and tilesets must all be at least 1\n");
+		return false;
+	}
+
+	// TMX only compresses base64 data
+	if (someOptions.myEncoding == Encoding::CSV && someOptions.myCompression == Compression::Zlib)
+		someOptions.myCompression = Compression::None;
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		fprintf(stderr, "Usage: StressMapGenerator [--output Binaries/StressMaps/Stress.tmx] [--tileset-directory Data/Tilemaps/Tilesets] [--width 1024] [--height 1024]"
+			" [--layers 3] [--tilesets 1] [--density 0.9] [--flips 0.05] [--encoding csv|base64] [--compression none|zlib] [--seed 1234]\n");
+		return 1;
+	}
+
+	std::vector<Tileset> tilesets;
+	std::uint32_t tileCount = 0;
+	for (unsigned int i = 0; i < options.myTilesetCount; ++i)
+	{
+		const TilesetDescription& description = ourTilesets[i % std::size(ourTilesets)];
+		tilesets.push_back({ &description, tileCount + 1 });
+		tileCount += description.myTileCount;
+	}
+
+	// Tilesets are referenced relative to the map, wherever it's written
+	const std::filesystem::path outputPath = std::filesystem::absolute(options.myOutputFilePath);
+	if (outputPath.has_parent_path())
+		std::filesystem::create_directories(outputPath.parent_path());
+
+	std::string tilesetPath = std::filesystem::absolute(options.myTilesetDirectory).lexically_relative(outputPath.parent_path()).generic_string();
+	if (!tilesetPath.empty() && tilesetPath != ".")
+		tilesetPath += '/';
+	else
+		tilesetPath.clear();
+
+	std::FILE* file = std::fopen(outputPath.string().c_str(), "wb");
+	if (!file)
+	{
+		fprintf(stderr, "Failed to open %s for writing\n", outputPath.string().c_str());
+		return 1;
+	}
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	bool isWritten = Write(file, CreateHeader(options, tilesets, tilesetPath));
+	if (isWritten && options.myCompression == Compression::Zlib)
+	{
+		isWritten = WriteCompressedLayers(file, options, tileCount);
+	}
+	else
+	{
+		for (unsigned int layer = 0; layer < options.myLayerCount && isWritten; ++layer)
+			isWritten = Write(file, CreateLayerHeader(options, layer)) && WriteStreamedLayer(file, options, tileCount, layer) && Write(file, GetLayerFooter(options));
+	}
+
+	if (isWritten)
+		isWritten = Write(file, "</map>\n");
+
+	isWritten = std::fclose(file) == 0 && isWritten;
+	if (!isWritten)
+	{
+		fprintf(stderr, "Failed to write %s\n", outputPath.string().c_str());
+		return 1;
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	const double megabytes = static_cast<double>(std::filesystem::file_size(outputPath)) / (1024.0 * 1024.0);
+	printf("Wrote %s, %ux%u tiles in %u layers with %u tilesets, %.1f MB in %.2f s on %zu workers\n",
+		outputPath.string().c_str(),
+		options.myWidth,
+		options.myHeight,
+		options.myLayerCount,
+		options.myTilesetCount,
+		megabytes,
+		seconds,
+		JobSystem::GetInstance().GetWorkerCount());
+
+	return 0;
+}
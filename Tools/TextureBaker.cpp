@@ -0,0 +1,837 @@
+#include "JobSystem.hpp"
+#include "TextureCache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include <tmxlite/Map.hpp>
+
+namespace TextureBakerParameters
+{
+	static constexpr std::uint32_t ourLevelCount = 3;
+	// At least one edge texel is left around every tile at the smallest level
+	static constexpr std::uint32_t ourMinimumGutter = 1u << (ourLevelCount - 1);
+	// Cells stay whole 4x4 blocks at every level, so no block mixes two tiles
+	static constexpr std::uint32_t ourCellAlignment = 4u << (ourLevelCount - 1);
+	static constexpr std::size_t ourBlockRowsPerJob = 4;
+	static constexpr int ourRefinementCount = 2;
+	// Two subset partitions fully encoded per block, picked by how well their subsets fit a line
+	static constexpr std::size_t ourPartitionCandidateCount = 8;
+}
+
+namespace BC7
+{
+	struct Mode
+	{
+		std::uint32_t myNumber;
+		std::uint32_t mySubsetCount;
+		// Per channel, not counting the parity bit
+		std::uint32_t myEndpointBits;
+		// Shared by both endpoints of a subset, otherwise every endpoint has its own
+		bool myHasSharedParityBits;
+		std::uint32_t myIndexBits;
+		bool myHasAlpha;
+	};
+
+	static constexpr Mode ourOpaqueMode = { 1, 2, 6, true, 3, false };
+	static constexpr Mode ourSingleSubsetMode = { 6, 1, 7, false, 4, true };
+	static constexpr Mode ourTranslucentMode = { 7, 2, 5, false, 2, true };
+
+	static constexpr std::array<int, 4> ourTwoBitWeights = { 0, 21, 43, 64 };
+	static constexpr std::array<int, 8> ourThreeBitWeights = { 0, 9, 18, 27, 37, 46, 55, 64 };
+	static constexpr std::array<int, 16> ourFourBitWeights = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// Texels of the second subset per two subset partition, bit i for texel i
+	static constexpr std::array<std::uint16_t, 64> ourPartitions = {
+		0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+		0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+		0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+		0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22
+	};
+
+	// The texel whose index is stored without its top bit in the second subset, the first subset's is always texel 0
+	static constexpr std::array<std::uint8_t, 64> ourSecondAnchors = {
+		15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+		15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+		15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6,
+		6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15
+	};
+}
+
+struct Options
+{
+	std::vector<std::string> myMapPaths;
+	bool myIsCompressing = true;
+	bool myIsForced = false;
+};
+
+struct TilesetSource
+{
+	std::string myImagePath;
+	std::uint32_t myTileWidth;
+	std::uint32_t myTileHeight;
+	std::uint32_t myColumnCount;
+	std::uint32_t myTileCount;
+	std::uint32_t myMargin;
+	std::uint32_t mySpacing;
+};
+
+struct Image
+{
+	std::vector<std::uint8_t> myPixels;
+	std::uint32_t myWidth = 0;
+	std::uint32_t myHeight = 0;
+};
+
+struct SubsetEncoding
+{
+	// Without their parity bits
+	std::array<std::array<int, 4>, 2> myEndpoints = {};
+	std::array<int, 2> myParityBits = {};
+};
+
+struct BlockEncoding
+{
+	const BC7::Mode* myMode = nullptr;
+	std::array<SubsetEncoding, 2> mySubsets;
+	std::array<int, 16> myIndices = {};
+	std::uint32_t myPartition = 0;
+	int myError = 0;
+};
+
+static std::uint32_t GetAligned(std::uint32_t aValue, std::uint32_t anAlignment)
+{
+	return (aValue + anAlignment - 1) / anAlignment * anAlignment;
+}
+
+static bool ReadFile(const std::filesystem::path& aFilepath, std::vector<std::uint8_t>& someData)
+{
+	std::ifstream file(aFilepath, std::ifstream::binary);
+	if (!file.is_open())
+		return false;
+
+	someData.resize(static_cast<std::size_t>(std::filesystem::file_size(aFilepath)));
+	file.read(reinterpret_cast<char*>(someData.data()), static_cast<std::streamsize>(someData.size()));
+	return file.gcount() == static_cast<std::streamsize>(someData.size());
+}
+
+// Copies every tile into its own cell, clamping to the tile's edges in the gutter around it
+static Image LayOutTiles(const TilesetSource& aSource, const unsigned char* someRGBAPixels, int aWidth, int aHeight, const TextureCacheHeader& aHeader)
+{
+	Image image;
+	image.myWidth = aHeader.myWidth;
+	image.myHeight = aHeader.myHeight;
+	image.myPixels.assign(static_cast<std::size_t>(image.myWidth) * image.myHeight * 4, 0);
+
+	for (std::uint32_t tileIndex = 0; tileIndex < aSource.myTileCount; ++tileIndex)
+	{
+		const std::uint32_t left = aSource.myMargin + (tileIndex % aSource.myColumnCount) * (aSource.myTileWidth + aSource.mySpacing);
+		const std::uint32_t top = aSource.myMargin + (tileIndex / aSource.myColumnCount) * (aSource.myTileHeight + aSource.mySpacing);
+		if (left + aSource.myTileWidth > static_cast<std::uint32_t>(aWidth) || top + aSource.myTileHeight > static_cast<std::uint32_t>(aHeight))
+			continue;
+
+		const std::uint32_t cellLeft = (tileIndex % aHeader.myColumnCount) * aHeader.myCellWidth;
+		const std::uint32_t cellTop = (tileIndex / aHeader.myColumnCount) * aHeader.myCellHeight;
+		for (std::uint32_t y = 0; y < aHeader.myCellHeight; ++y)
+		{
+			const std::uint32_t sourceY = top + static_cast<std::uint32_t>(std::clamp(static_cast<int>(y) - static_cast<int>(aHeader.myGutter), 0, static_cast<int>(aSource.myTileHeight) - 1));
+			for (std::uint32_t x = 0; x < aHeader.myCellWidth; ++x)
+			{
+				const std::uint32_t sourceX = left + static_cast<std::uint32_t>(std::clamp(static_cast<int>(x) - static_cast<int>(aHeader.myGutter), 0, static_cast<int>(aSource.myTileWidth) - 1));
+				const unsigned char* source = someRGBAPixels + (static_cast<std::size_t>(sourceY) * aWidth + sourceX) * 4;
+				std::memcpy(&image.myPixels[(static_cast<std::size_t>(cellTop + y) * image.myWidth + cellLeft + x) * 4], source, 4);
+			}
+		}
+	}
+
+	return image;
+}
+
+static std::vector<std::uint32_t> GetOpaqueTileBits(const Image& anImage, const TextureCacheHeader& aHeader)
+{
+	std::vector<std::uint32_t> bits((aHeader.myTileCount + 31) / 32, 0);
+	for (std::uint32_t tileIndex = 0; tileIndex < aHeader.myTileCount; ++tileIndex)
+	{
+		const std::uint32_t left = (tileIndex % aHeader.myColumnCount) * aHeader.myCellWidth + aHeader.myGutter;
+		const std::uint32_t top = (tileIndex / aHeader.myColumnCount) * aHeader.myCellHeight + aHeader.myGutter;
+
+		bool isOpaque = true;
+		for (std::uint32_t y = top; y < top + aHeader.myTileHeight && isOpaque; ++y)
+		{
+			for (std::uint32_t x = left; x < left + aHeader.myTileWidth; ++x)
+			{
+				if (anImage.myPixels[(static_cast<std::size_t>(y) * anImage.myWidth + x) * 4 + 3] != 255)
+				{
+					isOpaque = false;
+					break;
+				}
+			}
+		}
+
+		if (isOpaque)
+			bits[tileIndex / 32] |= 1u << (tileIndex % 32);
+	}
+
+	return bits;
+}
+
+// A 2x2 box filter, weighting colours by alpha so transparent texels don't darken the edges they border
+static Image Downsample(const Image& anImage)
+{
+	Image image;
+	image.myWidth = anImage.myWidth / 2;
+	image.myHeight = anImage.myHeight / 2;
+	image.myPixels.resize(static_cast<std::size_t>(image.myWidth) * image.myHeight * 4);
+
+	for (std::uint32_t y = 0; y < image.myHeight; ++y)
+	{
+		for (std::uint32_t x = 0; x < image.myWidth; ++x)
+		{
+			std::array<std::uint32_t, 4> sums = {};
+			std::uint32_t plainSums[3] = {};
+			for (std::uint32_t sample = 0; sample < 4; ++sample)
+			{
+				const std::uint8_t* texel = &anImage.myPixels[((static_cast<std::size_t>(y) * 2 + sample / 2) * anImage.myWidth + x * 2 + sample % 2) * 4];
+				for (std::size_t channel = 0; channel < 3; ++channel)
+				{
+					sums[channel] += texel[channel] * texel[3];
+					plainSums[channel] += texel[channel];
+				}
+				sums[3] += texel[3];
+			}
+
+			std::uint8_t* texel = &image.myPixels[(static_cast<std::size_t>(y) * image.myWidth + x) * 4];
+			for (std::size_t channel = 0; channel < 3; ++channel)
+				texel[channel] = static_cast<std::uint8_t>(sums[3] > 0 ? (sums[channel] + sums[3] / 2) / sums[3] : (plainSums[channel] + 2) / 4);
+
+			texel[3] = static_cast<std::uint8_t>((sums[3] + 2) / 4);
+		}
+	}
+
+	return image;
+}
+
+static void WriteBits(std::uint8_t* aBlock, unsigned int& aPosition, std::uint32_t aValue, unsigned int aCount)
+{
+	for (unsigned int i = 0; i < aCount; ++i, ++aPosition)
+		aBlock[aPosition >> 3] |= static_cast<std::uint8_t>(((aValue >> i) & 1u) << (aPosition & 7));
+}
+
+static int GetWeight(const BC7::Mode& aMode, int anIndex)
+{
+	if (aMode.myIndexBits == 2)
+		return BC7::ourTwoBitWeights[anIndex];
+
+	return aMode.myIndexBits == 3 ? BC7::ourThreeBitWeights[anIndex] : BC7::ourFourBitWeights[anIndex];
+}
+
+// Endpoints are stored with their parity bit as the lowest and expanded to eight bits by repeating their top bits
+static int GetExpanded(const BC7::Mode& aMode, int aValue, int aParityBit)
+{
+	const int bits = static_cast<int>(aMode.myEndpointBits) + 1;
+	const int value = (aValue << 1) | aParityBit;
+	return (value << (8 - bits)) | (value >> (2 * bits - 8));
+}
+
+static float QuantizeEndpoint(const BC7::Mode& aMode, const float* anEndpoint, int aParityBit, std::array<int, 4>& someValues)
+{
+	const int channelCount = aMode.myHasAlpha ? 4 : 3;
+	const int maximum = (1 << aMode.myEndpointBits) - 1;
+	float error = 0.0f;
+	for (int channel = 0; channel < channelCount; ++channel)
+	{
+		const float scaled = anEndpoint[channel] * static_cast<float>((2 << aMode.myEndpointBits) - 1) / 255.0f;
+		const int estimate = std::clamp(static_cast<int>(std::lround((scaled - static_cast<float>(aParityBit)) * 0.5f)), 0, maximum);
+		float bestError = -1.0f;
+		for (int value = std::max(estimate - 1, 0); value <= std::min(estimate + 1, maximum); ++value)
+		{
+			const float difference = static_cast<float>(GetExpanded(aMode, value, aParityBit)) - anEndpoint[channel];
+			if (bestError < 0.0f || difference * difference < bestError)
+			{
+				bestError = difference * difference;
+				someValues[channel] = value;
+			}
+		}
+
+		error += bestError;
+	}
+
+	return error;
+}
+
+static void QuantizeEndpoints(const BC7::Mode& aMode, const float (&someEndpoints)[2][4], SubsetEncoding& anEncoding)
+{
+	if (aMode.myHasSharedParityBits)
+	{
+		float bestError = -1.0f;
+		for (int parityBit = 0; parityBit < 2; ++parityBit)
+		{
+			std::array<std::array<int, 4>, 2> values;
+			const float error = QuantizeEndpoint(aMode, someEndpoints[0], parityBit, values[0]) + QuantizeEndpoint(aMode, someEndpoints[1], parityBit, values[1]);
+			if (bestError < 0.0f || error < bestError)
+			{
+				bestError = error;
+				anEncoding.myEndpoints = values;
+				anEncoding.myParityBits = { parityBit, parityBit };
+			}
+		}
+
+		return;
+	}
+
+	for (std::size_t endpoint = 0; endpoint < 2; ++endpoint)
+	{
+		std::array<int, 4> values;
+		const float firstError = QuantizeEndpoint(aMode, someEndpoints[endpoint], 0, anEncoding.myEndpoints[endpoint]);
+		const float secondError = QuantizeEndpoint(aMode, someEndpoints[endpoint], 1, values);
+		anEncoding.myParityBits[endpoint] = secondError < firstError ? 1 : 0;
+		if (secondError < firstError)
+			anEncoding.myEndpoints[endpoint] = values;
+	}
+}
+
+// Picks the closest interpolated colour for every texel of the subset, returning their total squared error
+static int GetIndices(const BC7::Mode& aMode, const std::uint8_t* someTexels, std::uint32_t aMask, const SubsetEncoding& anEncoding, std::array<int, 16>& someIndices)
+{
+	std::array<std::array<int, 2>, 4> endpoints;
+	for (std::size_t channel = 0; channel < 4; ++channel)
+	{
+		for (std::size_t endpoint = 0; endpoint < 2; ++endpoint)
+			endpoints[channel][endpoint] = channel < 3 || aMode.myHasAlpha ? GetExpanded(aMode, anEncoding.myEndpoints[endpoint][channel], anEncoding.myParityBits[endpoint]) : 255;
+	}
+
+	const int paletteSize = 1 << aMode.myIndexBits;
+	std::array<std::array<int, 4>, 16> palette;
+	for (int i = 0; i < paletteSize; ++i)
+	{
+		const int weight = GetWeight(aMode, i);
+		for (std::size_t channel = 0; channel < 4; ++channel)
+			palette[i][channel] = ((64 - weight) * endpoints[channel][0] + weight * endpoints[channel][1] + 32) >> 6;
+	}
+
+	int totalError = 0;
+	for (std::size_t texel = 0; texel < 16; ++texel)
+	{
+		if ((aMask & (1u << texel)) == 0)
+			continue;
+
+		int bestError = -1;
+		for (int i = 0; i < paletteSize; ++i)
+		{
+			int error = 0;
+			for (std::size_t channel = 0; channel < 4; ++channel)
+			{
+				const int difference = palette[i][channel] - someTexels[texel * 4 + channel];
+				error += difference * difference;
+			}
+
+			if (bestError < 0 || error < bestError)
+			{
+				bestError = error;
+				someIndices[texel] = i;
+			}
+		}
+
+		totalError += bestError;
+	}
+
+	return totalError;
+}
+
+// Finds the mean and principal axis of the subset's texels and returns how far they are spread off that axis
+static float GetPrincipalAxis(const std::uint8_t* someTexels, std::uint32_t aMask, int aChannelCount, float (&aMean)[4], float (&anAxis)[4])
+{
+	float count = 0.0f;
+	std::fill(std::begin(aMean), std::end(aMean), 0.0f);
+	for (std::size_t texel = 0; texel < 16; ++texel)
+	{
+		if ((aMask & (1u << texel)) == 0)
+			continue;
+
+		count += 1.0f;
+		for (int channel = 0; channel < aChannelCount; ++channel)
+			aMean[channel] += someTexels[texel * 4 + channel];
+	}
+
+	for (int channel = 0; channel < aChannelCount; ++channel)
+		aMean[channel] /= count;
+
+	float covariance[4][4] = {};
+	for (std::size_t texel = 0; texel < 16; ++texel)
+	{
+		if ((aMask & (1u << texel)) == 0)
+			continue;
+
+		for (int row = 0; row < aChannelCount; ++row)
+		{
+			for (int column = 0; column < aChannelCount; ++column)
+				covariance[row][column] += (someTexels[texel * 4 + row] - aMean[row]) * (someTexels[texel * 4 + column] - aMean[column]);
+		}
+	}
+
+	std::fill(std::begin(anAxis), std::end(anAxis), 0.0f);
+	std::fill(anAxis, anAxis + aChannelCount, 1.0f);
+	float spread = 0.0f;
+	for (int iteration = 0; iteration < 8; ++iteration)
+	{
+		float next[4] = {};
+		float length = 0.0f;
+		for (int row = 0; row < aChannelCount; ++row)
+		{
+			for (int column = 0; column < aChannelCount; ++column)
+				next[row] += covariance[row][column] * anAxis[column];
+
+			length = std::max(length, std::fabs(next[row]));
+		}
+
+		if (length <= 0.0f)
+			break;
+
+		for (int channel = 0; channel < aChannelCount; ++channel)
+			anAxis[channel] = next[channel] / length;
+	}
+
+	// The variance left over once the variance along the axis is taken out
+	float axisLengthSquared = 0.0f;
+	float alongAxis = 0.0f;
+	for (int row = 0; row < aChannelCount; ++row)
+	{
+		spread += covariance[row][row];
+		axisLengthSquared += anAxis[row] * anAxis[row];
+		for (int column = 0; column < aChannelCount; ++column)
+			alongAxis += anAxis[row] * covariance[row][column] * anAxis[column];
+	}
+
+	return axisLengthSquared > 0.0f ? spread - alongAxis / axisLengthSquared : spread;
+}
+
+// The endpoints start at the extremes of the subset along its principal axis and are then refitted by least
+// squares to the indices they produced, keeping whichever round of endpoints had the lowest error
+static int EncodeSubset(const BC7::Mode& aMode, const std::uint8_t* someTexels, std::uint32_t aMask, SubsetEncoding& anEncoding, std::array<int, 16>& someIndices)
+{
+	const int channelCount = aMode.myHasAlpha ? 4 : 3;
+	float mean[4];
+	float axis[4];
+	GetPrincipalAxis(someTexels, aMask, channelCount, mean, axis);
+
+	float minimum = 0.0f;
+	float maximum = 0.0f;
+	float axisLengthSquared = 0.0f;
+	for (int channel = 0; channel < channelCount; ++channel)
+		axisLengthSquared += axis[channel] * axis[channel];
+
+	for (std::size_t texel = 0; texel < 16; ++texel)
+	{
+		if ((aMask & (1u << texel)) == 0)
+			continue;
+
+		float projection = 0.0f;
+		for (int channel = 0; channel < channelCount; ++channel)
+			projection += (someTexels[texel * 4 + channel] - mean[channel]) * axis[channel];
+
+		minimum = std::min(minimum, projection);
+		maximum = std::max(maximum, projection);
+	}
+
+	float endpoints[2][4] = {};
+	for (int channel = 0; channel < channelCount; ++channel)
+	{
+		const float scale = axisLengthSquared > 0.0f ? axis[channel] / axisLengthSquared : 0.0f;
+		endpoints[0][channel] = std::clamp(mean[channel] + minimum * scale, 0.0f, 255.0f);
+		endpoints[1][channel] = std::clamp(mean[channel] + maximum * scale, 0.0f, 255.0f);
+	}
+
+	int bestError = -1;
+	std::array<int, 16> indices = someIndices;
+	for (int refinement = 0; refinement <= TextureBakerParameters::ourRefinementCount; ++refinement)
+	{
+		SubsetEncoding encoding;
+		QuantizeEndpoints(aMode, endpoints, encoding);
+		const int error = GetIndices(aMode, someTexels, aMask, encoding, indices);
+		if (bestError < 0 || error < bestError)
+		{
+			bestError = error;
+			anEncoding = encoding;
+			for (std::size_t texel = 0; texel < 16; ++texel)
+			{
+				if (aMask & (1u << texel))
+					someIndices[texel] = indices[texel];
+			}
+		}
+
+		if (bestError == 0)
+			break;
+
+		float firstSum = 0.0f;
+		float crossSum = 0.0f;
+		float secondSum = 0.0f;
+		float firstTargets[4] = {};
+		float secondTargets[4] = {};
+		for (std::size_t texel = 0; texel < 16; ++texel)
+		{
+			if ((aMask & (1u << texel)) == 0)
+				continue;
+
+			const float weight = static_cast<float>(GetWeight(aMode, indices[texel])) / 64.0f;
+			firstSum += (1.0f - weight) * (1.0f - weight);
+			crossSum += (1.0f - weight) * weight;
+			secondSum += weight * weight;
+			for (int channel = 0; channel < channelCount; ++channel)
+			{
+				firstTargets[channel] += (1.0f - weight) * someTexels[texel * 4 + channel];
+				secondTargets[channel] += weight * someTexels[texel * 4 + channel];
+			}
+		}
+
+		// Every texel on the same index leaves the system singular, the current endpoints are as good as it gets
+		const float determinant = firstSum * secondSum - crossSum * crossSum;
+		if (std::fabs(determinant) < 1e-6f)
+			break;
+
+		for (int channel = 0; channel < channelCount; ++channel)
+		{
+			endpoints[0][channel] = std::clamp((secondSum * firstTargets[channel] - crossSum * secondTargets[channel]) / determinant, 0.0f, 255.0f);
+			endpoints[1][channel] = std::clamp((firstSum * secondTargets[channel] - crossSum * firstTargets[channel]) / determinant, 0.0f, 255.0f);
+		}
+	}
+
+	return bestError;
+}
+
+static void EncodeBlock(const BC7::Mode& aMode, std::uint32_t aPartition, const std::uint8_t* someTexels, BlockEncoding& anEncoding)
+{
+	anEncoding.myMode = &aMode;
+	anEncoding.myPartition = aPartition;
+	anEncoding.myError = 0;
+	for (std::uint32_t subset = 0; subset < aMode.mySubsetCount; ++subset)
+	{
+		const std::uint32_t secondSubsetMask = aMode.mySubsetCount == 2 ? BC7::ourPartitions[aPartition] : 0;
+		const std::uint32_t mask = subset == 0 ? 0xFFFFu & ~secondSubsetMask : secondSubsetMask;
+		SubsetEncoding& encoding = anEncoding.mySubsets[subset];
+		anEncoding.myError += EncodeSubset(aMode, someTexels, mask, encoding, anEncoding.myIndices);
+
+		// The anchor texel's index is stored without its top bit, so the endpoints are swapped when it would be set
+		const std::size_t anchor = subset == 0 ? 0 : BC7::ourSecondAnchors[aPartition];
+		const int indexMaximum = (1 << aMode.myIndexBits) - 1;
+		if (anEncoding.myIndices[anchor] <= indexMaximum / 2)
+			continue;
+
+		std::swap(encoding.myEndpoints[0], encoding.myEndpoints[1]);
+		std::swap(encoding.myParityBits[0], encoding.myParityBits[1]);
+		for (std::size_t texel = 0; texel < 16; ++texel)
+		{
+			if (mask & (1u << texel))
+				anEncoding.myIndices[texel] = indexMaximum - anEncoding.myIndices[texel];
+		}
+	}
+}
+
+static void WriteBlock(const BlockEncoding& anEncoding, std::uint8_t* aBlock)
+{
+	const BC7::Mode& mode = *anEncoding.myMode;
+	std::memset(aBlock, 0, 16);
+	unsigned int position = 0;
+	WriteBits(aBlock, position, 1u << mode.myNumber, mode.myNumber + 1);
+	if (mode.mySubsetCount == 2)
+		WriteBits(aBlock, position, anEncoding.myPartition, 6);
+
+	const std::size_t channelCount = mode.myHasAlpha ? 4 : 3;
+	for (std::size_t channel = 0; channel < channelCount; ++channel)
+	{
+		for (std::uint32_t subset = 0; subset < mode.mySubsetCount; ++subset)
+		{
+			for (std::size_t endpoint = 0; endpoint < 2; ++endpoint)
+				WriteBits(aBlock, position, static_cast<std::uint32_t>(anEncoding.mySubsets[subset].myEndpoints[endpoint][channel]), mode.myEndpointBits);
+		}
+	}
+
+	for (std::uint32_t subset = 0; subset < mode.mySubsetCount; ++subset)
+	{
+		for (std::size_t endpoint = 0; endpoint < (mode.myHasSharedParityBits ? 1 : 2); ++endpoint)
+			WriteBits(aBlock, position, static_cast<std::uint32_t>(anEncoding.mySubsets[subset].myParityBits[endpoint]), 1);
+	}
+
+	const std::size_t secondAnchor = mode.mySubsetCount == 2 ? BC7::ourSecondAnchors[anEncoding.myPartition] : 0;
+	for (std::size_t texel = 0; texel < 16; ++texel)
+	{
+		const bool isAnchor = texel == 0 || texel == secondAnchor;
+		WriteBits(aBlock, position, static_cast<std::uint32_t>(anEncoding.myIndices[texel]), mode.myIndexBits - (isAnchor ? 1 : 0));
+	}
+}
+
+// Encodes 16 RGBA texels, row by row, as one BC7 block. A single subset in mode 6 is tried first, then the
+// partitions that best split the texels in two, in mode 1 for opaque blocks and in mode 7 otherwise.
+static void EncodeBC7Block(const std::uint8_t* someTexels, std::uint8_t* aBlock)
+{
+	BlockEncoding best;
+	EncodeBlock(BC7::ourSingleSubsetMode, 0, someTexels, best);
+	if (best.myError > 0)
+	{
+		bool isOpaque = true;
+		for (std::size_t texel = 0; texel < 16; ++texel)
+			isOpaque = isOpaque && someTexels[texel * 4 + 3] == 255;
+
+		const BC7::Mode& mode = isOpaque ? BC7::ourOpaqueMode : BC7::ourTranslucentMode;
+		const int channelCount = mode.myHasAlpha ? 4 : 3;
+		std::array<std::pair<float, std::uint32_t>, BC7::ourPartitions.size()> estimates;
+		for (std::uint32_t partition = 0; partition < estimates.size(); ++partition)
+		{
+			float mean[4];
+			float axis[4];
+			const float secondSpread = GetPrincipalAxis(someTexels, BC7::ourPartitions[partition], channelCount, mean, axis);
+			const float firstSpread = GetPrincipalAxis(someTexels, 0xFFFFu & ~static_cast<std::uint32_t>(BC7::ourPartitions[partition]), channelCount, mean, axis);
+			estimates[partition] = { firstSpread + secondSpread, partition };
+		}
+
+		std::partial_sort(estimates.begin(), estimates.begin() + TextureBakerParameters::ourPartitionCandidateCount, estimates.end());
+		for (std::size_t i = 0; i < TextureBakerParameters::ourPartitionCandidateCount && best.myError > 0; ++i)
+		{
+			BlockEncoding candidate;
+			EncodeBlock(mode, estimates[i].second, someTexels, candidate);
+			if (candidate.myError < best.myError)
+				best = candidate;
+		}
+	}
+
+	WriteBlock(best, aBlock);
+}
+
+static std::vector<std::uint8_t> EncodeBC7(const Image& anImage)
+{
+	const std::size_t blockColumns = anImage.myWidth / 4;
+	const std::size_t blockRows = anImage.myHeight / 4;
+	std::vector<std::uint8_t> blocks(blockColumns * blockRows * 16);
+	JobSystem::GetInstance().ParallelFor(blockRows, TextureBakerParameters::ourBlockRowsPerJob, [&](std::size_t aBegin, std::size_t anEnd)
+		{
+			std::uint8_t texels[16 * 4];
+			for (std::size_t blockRow = aBegin; blockRow < anEnd; ++blockRow)
+			{
+				for (std::size_t blockColumn = 0; blockColumn < blockColumns; ++blockColumn)
+				{
+					for (std::size_t row = 0; row < 4; ++row)
+						std::memcpy(texels + row * 16, &anImage.myPixels[((blockRow * 4 + row) * anImage.myWidth + blockColumn * 4) * 4], 16);
+
+					EncodeBC7Block(texels, &blocks[(blockRow * blockColumns + blockColumn) * 16]);
+				}
+			}
+		});
+
+	return blocks;
+}
+
+static bool GetIsUpToDate(const std::string& aCachePath, const TextureCacheHeader& aHeader)
+{
+	std::ifstream file(aCachePath, std::ifstream::binary);
+	TextureCacheHeader header;
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+		return false;
+
+	// The whole header follows from the source and the bake parameters, a cache baked with another gutter or cell
+	// alignment lays its tiles out differently even when the image is the same
+	return std::memcmp(header.myMagic, aHeader.myMagic, sizeof(header.myMagic)) == 0
+		&& header.myVersion == aHeader.myVersion
+		&& header.myFormat == aHeader.myFormat
+		&& header.myLevelCount == aHeader.myLevelCount
+		&& header.myWidth == aHeader.myWidth
+		&& header.myHeight == aHeader.myHeight
+		&& header.myTileWidth == aHeader.myTileWidth
+		&& header.myTileHeight == aHeader.myTileHeight
+		&& header.myCellWidth == aHeader.myCellWidth
+		&& header.myCellHeight == aHeader.myCellHeight
+		&& header.myGutter == aHeader.myGutter
+		&& header.myColumnCount == aHeader.myColumnCount
+		&& header.myRowCount == aHeader.myRowCount
+		&& header.myTileCount == aHeader.myTileCount
+		&& header.mySourceSize == aHeader.mySourceSize
+		&& header.mySourceHash == aHeader.mySourceHash;
+}
+
+static bool Bake(const TilesetSource& aSource, const Options& someOptions)
+{
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	const std::string cachePath = TextureCache::GetCachePath(aSource.myImagePath);
+
+	std::vector<std::uint8_t> encodedImage;
+	if (!ReadFile(aSource.myImagePath, encodedImage))
+	{
+		fprintf(stderr, "Failed to read %s\n", aSource.myImagePath.c_str());
+		return false;
+	}
+
+	TextureCacheHeader header;
+	std::memcpy(header.myMagic, TextureCache::ourMagic, sizeof(header.myMagic));
+	header.myVersion = TextureCache::ourVersion;
+	header.myFormat = static_cast<std::uint32_t>(someOptions.myIsCompressing ? TextureCache::Format::BC7 : TextureCache::Format::RGBA8);
+	header.myLevelCount = TextureBakerParameters::ourLevelCount;
+	header.myTileWidth = aSource.myTileWidth;
+	header.myTileHeight = aSource.myTileHeight;
+	header.myCellWidth = GetAligned(aSource.myTileWidth + 2 * TextureBakerParameters::ourMinimumGutter, TextureBakerParameters::ourCellAlignment);
+	header.myCellHeight = GetAligned(aSource.myTileHeight + 2 * TextureBakerParameters::ourMinimumGutter, TextureBakerParameters::ourCellAlignment);
+	// Whatever the alignment adds is split between both sides, the narrower side is still at least the minimum
+	header.myGutter = std::min(header.myCellWidth - aSource.myTileWidth, header.myCellHeight - aSource.myTileHeight) / 2;
+	header.myColumnCount = aSource.myColumnCount;
+	header.myRowCount = (aSource.myTileCount + aSource.myColumnCount - 1) / aSource.myColumnCount;
+	header.myTileCount = aSource.myTileCount;
+	header.myWidth = header.myColumnCount * header.myCellWidth;
+	header.myHeight = header.myRowCount * header.myCellHeight;
+	header.mySourceSize = encodedImage.size();
+	header.mySourceHash = TextureCache::GetSourceHash(encodedImage.data(), encodedImage.size());
+
+	if (!someOptions.myIsForced && GetIsUpToDate(cachePath, header))
+	{
+		printf("%s is up to date\n", cachePath.c_str());
+		return true;
+	}
+
+	int width = 0;
+	int height = 0;
+	int numberOfChannels = 0;
+	unsigned char* pixels = stbi_load_from_memory(encodedImage.data(), static_cast<int>(encodedImage.size()), &width, &height, &numberOfChannels, 4);
+	if (!pixels)
+	{
+		fprintf(stderr, "Failed to decode %s\n", aSource.myImagePath.c_str());
+		return false;
+	}
+
+	std::vector<Image> levels;
+	levels.push_back(LayOutTiles(aSource, pixels, width, height, header));
+	stbi_image_free(pixels);
+	while (levels.size() < header.myLevelCount)
+		levels.push_back(Downsample(levels.back()));
+
+	const std::vector<std::uint32_t> opaqueTileBits = GetOpaqueTileBits(levels.front(), header);
+
+	std::vector<std::vector<std::uint8_t>> levelData(levels.size());
+	std::vector<TextureCacheLevel> levelEntries(levels.size());
+	std::uint64_t offset = sizeof(header) + levelEntries.size() * sizeof(TextureCacheLevel) + opaqueTileBits.size() * sizeof(std::uint32_t);
+	for (std::size_t i = 0; i < levels.size(); ++i)
+	{
+		levelData[i] = someOptions.myIsCompressing ? EncodeBC7(levels[i]) : levels[i].myPixels;
+		offset = (offset + TextureCache::ourAlignment - 1) / TextureCache::ourAlignment * TextureCache::ourAlignment;
+		levelEntries[i].myDataOffset = offset;
+		levelEntries[i].mySize = levelData[i].size();
+		levelEntries[i].myWidth = levels[i].myWidth;
+		levelEntries[i].myHeight = levels[i].myHeight;
+		offset += levelData[i].size();
+	}
+
+	std::ofstream output(cachePath, std::ofstream::binary | std::ofstream::trunc);
+	output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	output.write(reinterpret_cast<const char*>(levelEntries.data()), static_cast<std::streamsize>(levelEntries.size() * sizeof(TextureCacheLevel)));
+	output.write(reinterpret_cast<const char*>(opaqueTileBits.data()), static_cast<std::streamsize>(opaqueTileBits.size() * sizeof(std::uint32_t)));
+
+	const char padding[TextureCache::ourAlignment] = {};
+	std::uint64_t written = sizeof(header) + levelEntries.size() * sizeof(TextureCacheLevel) + opaqueTileBits.size() * sizeof(std::uint32_t);
+	for (std::size_t i = 0; i < levelData.size(); ++i)
+	{
+		output.write(padding, static_cast<std::streamsize>(levelEntries[i].myDataOffset - written));
+		output.write(reinterpret_cast<const char*>(levelData[i].data()), static_cast<std::streamsize>(levelData[i].size()));
+		written = levelEntries[i].myDataOffset + levelData[i].size();
+	}
+
+	output.close();
+	if (!output)
+	{
+		fprintf(stderr, "Failed to write %s\n", cachePath.c_str());
+		return false;
+	}
+
+	// What the game uploaded before, a single uncompressed level of the source image
+	const std::uint64_t sourceBytes = static_cast<std::uint64_t>(width) * static_cast<std::uint64_t>(height) * 4;
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("Baked %s, %u tiles of %ux%u in %ux%u cells, %u levels of %s, %llu bytes against %llu as RGBA8, in %.2f s\n",
+		cachePath.c_str(),
+		header.myTileCount,
+		header.myTileWidth,
+		header.myTileHeight,
+		header.myCellWidth,
+		header.myCellHeight,
+		header.myLevelCount,
+		someOptions.myIsCompressing ? "BC7" : "RGBA8",
+		static_cast<unsigned long long>(written),
+		static_cast<unsigned long long>(sourceBytes),
+		seconds);
+
+	return true;
+}
+
+static bool ParseOptions(int argc, char** argv, Options& someOptions)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--uncompressed") == 0)
+			someOptions.myIsCompressing = false;
+		else if (std::strcmp(argv[i], "--force") == 0)
+			someOptions.myIsForced = true;
+		else if (argv[i][0] != '-')
+			someOptions.myMapPaths.emplace_back(argv[i]);
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return false;
+		}
+	}
+
+	if (someOptions.myMapPaths.empty() && std::filesystem::is_directory("Data/Tilemaps"))
+	{
+		for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator("Data/Tilemaps"))
+		{
+			if (entry.is_regular_file() && entry.path().extension() == ".tmx")
+				someOptions.myMapPaths.emplace_back(entry.path().generic_string());
+		}
+
+		std::sort(someOptions.myMapPaths.begin(), someOptions.myMapPaths.end());
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		fprintf(stderr, "Usage: TextureBaker [--uncompressed] [--force] [maps, every map in Data/Tilemaps by default]\n");
+		return 1;
+	}
+
+	// Tilesets shared between maps are baked once, keyed by the image path the game reads them by
+	std::vector<TilesetSource> sources;
+	std::set<std::string> imagePaths;
+	for (const std::string& mapPath : options.myMapPaths)
+	{
+		tmx::Map map;
+		if (!map.load(mapPath))
+		{
+			fprintf(stderr, "Failed to load %s\n", mapPath.c_str());
+			return 1;
+		}
+
+		for (const tmx::Tileset& tileset : map.getTilesets())
+		{
+			const std::string& imagePath = tileset.getImagePath();
+			if (imagePath.empty() || tileset.getColumnCount() == 0 || !imagePaths.insert(imagePath).second)
+				continue;
+
+			sources.push_back({ imagePath, tileset.getTileSize().x, tileset.getTileSize().y, tileset.getColumnCount(), tileset.getTileCount(), tileset.getMargin(), tileset.getSpacing() });
+		}
+	}
+
+	for (const TilesetSource& source : sources)
+	{
+		if (!Bake(source, options))
+			return 1;
+	}
+
+	return 0;
+}